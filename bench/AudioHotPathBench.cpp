@@ -0,0 +1,588 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T16:30:00Z
+File: AudioHotPathBench.cpp
+Desc: 音频热路径微基准（Opus编解码、AES-CTR封包、WebSocket二进制协议、上行分帧）
+*/
+
+// 需要与客户端相同的依赖（Qt6 Core/Network/WebSockets/Multimedia、Opus、OpenSSL），
+// 链接以下源文件（含moc）构建为独立可执行文件：
+//   src/audio/{OpusCodec,AudioEncryptor,AudioCaptureWorker}.cpp
+//   src/network/{UdpManager,WebSocketManager}.cpp  src/utils/{Logger,Config}.cpp
+//
+// 用法：audio_hot_path_bench [--frames N] [--filter 子串] [--json 输出文件]
+//
+// 每项报告：
+//   ns/frame     单帧耗时（单线程）
+//   allocs/frame 单帧堆分配次数（glibc下统计malloc/calloc/realloc与memalign/aligned_alloc/
+//                posix_memalign/valloc/pvalloc，含Qt容器与对齐版operator new；其他平台只统计
+//                非对齐的operator new，C分配函数和对齐分配不计入，读数为0不代表没有分配）
+//   frames/s     单核每秒可处理帧数
+//   rt_streams   单核可承载的实时流数（帧时长 / 单帧耗时，仅音频帧项）
+
+#include "audio/AudioCaptureWorker.h"
+#include "audio/AudioEncryptor.h"
+#include "audio/JitterBuffer.h"
+#include "audio/OpusCodec.h"
+#include "network/WebSocketManager.h"
+#include "utils/Logger.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace xiaozhi;
+
+// ============================================================================
+// 堆分配计数
+// ============================================================================
+
+namespace {
+
+std::atomic<unsigned long long> g_allocations{0};
+
+} // namespace
+
+#if defined(__GLIBC__)
+// glibc：在可执行文件中定义malloc族符号即可拦截整个进程（Qt容器与operator new都经由malloc）
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+
+void* malloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+// 对齐分配不经过malloc（对齐版operator new经由aligned_alloc），需单独拦截
+void* memalign(size_t alignment, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) noexcept {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment % sizeof(void*) != 0) {
+        return EINVAL;
+    }
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *memptr = p;
+    return 0;
+}
+
+void* valloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_pvalloc(size);
+}
+}
+#else
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+// ============================================================================
+// 计时框架
+// ============================================================================
+
+struct Result {
+    std::string name;
+    double nsPerFrame;
+    double allocsPerFrame;
+    double frameMs;     // 音频帧时长（非音频项为0）
+};
+
+std::vector<Result> g_results;
+int g_frames = 2000;
+QByteArray g_filter;
+
+volatile int g_sink;    // 防止编译器消除被测调用的结果
+
+template <typename Body>
+void run(const std::string& name, double frameMs, Body&& body) {
+    if (!g_filter.isEmpty() && !QByteArray::fromStdString(name).contains(g_filter)) {
+        return;
+    }
+
+    // 预热：让缓存、分支预测与惰性初始化（Qt/Opus/OpenSSL内部表）就位
+    const int warmup = qMax(10, g_frames / 10);
+    for (int i = 0; i < warmup; ++i) {
+        body(i);
+    }
+
+    const unsigned long long allocsBefore = g_allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < g_frames; ++i) {
+        body(warmup + i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const unsigned long long allocs = g_allocations.load(std::memory_order_relaxed) - allocsBefore;
+
+    Result result;
+    result.name = name;
+    result.nsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / g_frames;
+    result.allocsPerFrame = static_cast<double>(allocs) / g_frames;
+    result.frameMs = frameMs;
+    g_results.push_back(result);
+
+    const double framesPerSec = 1e9 / result.nsPerFrame;
+    if (frameMs > 0) {
+        std::printf("%-28s %12.0f %14.2f %14.0f %12.0f\n", name.c_str(), result.nsPerFrame,
+                    result.allocsPerFrame, framesPerSec, frameMs * 1e6 / result.nsPerFrame);
+    } else {
+        std::printf("%-28s %12.0f %14.2f %14.0f %12s\n", name.c_str(), result.nsPerFrame,
+                    result.allocsPerFrame, framesPerSec, "-");
+    }
+    std::fflush(stdout);
+}
+
+// ============================================================================
+// 测试数据
+// ============================================================================
+
+constexpr double PI = 3.14159265358979323846;
+constexpr int FRAME_MS = 60;
+constexpr int DISTINCT_FRAMES = 64;     // 循环使用的不同帧数（避免编码器看到完全重复的输入）
+
+/**
+ * @brief 生成带轻微噪声的语音频段正弦PCM（单声道）
+ */
+std::vector<opus_int16> makePcm(int sampleRate, int samples) {
+    std::vector<opus_int16> pcm(static_cast<size_t>(samples));
+    unsigned int noise = 12345;
+    for (int i = 0; i < samples; ++i) {
+        const double t = static_cast<double>(i) / sampleRate;
+        noise = noise * 1103515245u + 12345u;
+        const double v = 0.25 * std::sin(2.0 * PI * 220.0 * t)
+                       + 0.10 * std::sin(2.0 * PI * 1375.0 * t)
+                       + 0.02 * (static_cast<int>((noise >> 16) & 0x7FFF) / 16384.0 - 1.0);
+        pcm[static_cast<size_t>(i)] = static_cast<opus_int16>(v * 32767.0);
+    }
+    return pcm;
+}
+
+/**
+ * @brief 编码DISTINCT_FRAMES个连续帧，作为解码与封包的输入
+ */
+std::vector<QByteArray> encodeFrames(int sampleRate) {
+    audio::OpusCodec codec;
+    codec.initEncoder(sampleRate, 1, 24000);
+    const int frameSize = codec.getEncoderFrameSize();
+    const std::vector<opus_int16> pcm = makePcm(sampleRate, frameSize * DISTINCT_FRAMES);
+    std::vector<QByteArray> frames;
+    std::vector<unsigned char> out(audio::OpusCodec::maxPacketSize());
+    for (int i = 0; i < DISTINCT_FRAMES; ++i) {
+        const int n = codec.encode(pcm.data() + i * frameSize, frameSize, out.data(), static_cast<int>(out.size()));
+        frames.emplace_back(reinterpret_cast<const char*>(out.data()), qMax(0, n));
+    }
+    return frames;
+}
+
+// ============================================================================
+// Opus
+// ============================================================================
+
+void benchOpus(int sampleRate) {
+    const std::string rate = std::to_string(sampleRate / 1000) + "k";
+    audio::OpusCodec encoder;
+    encoder.initEncoder(sampleRate, 1, 24000);
+    const int frameSize = encoder.getEncoderFrameSize();
+    const std::vector<opus_int16> pcm = makePcm(sampleRate, frameSize * DISTINCT_FRAMES);
+    std::vector<unsigned char> out(audio::OpusCodec::maxPacketSize());
+
+    run("opus_encode_" + rate, FRAME_MS, [&](int i) {
+        g_sink = encoder.encode(pcm.data() + (i % DISTINCT_FRAMES) * frameSize, frameSize,
+                                out.data(), static_cast<int>(out.size()));
+    });
+
+    // 旧接口：每帧构造输入/输出QByteArray
+    std::vector<QByteArray> pcmFrames;
+    for (int i = 0; i < DISTINCT_FRAMES; ++i) {
+        pcmFrames.emplace_back(reinterpret_cast<const char*>(pcm.data() + i * frameSize),
+                               frameSize * static_cast<int>(sizeof(opus_int16)));
+    }
+    run("opus_encode_" + rate + "_qbytearray", FRAME_MS, [&](int i) {
+        g_sink = encoder.encode(pcmFrames[static_cast<size_t>(i % DISTINCT_FRAMES)]).size();
+    });
+
+    const std::vector<QByteArray> frames = encodeFrames(sampleRate);
+    audio::OpusCodec decoder;
+    decoder.initDecoder(sampleRate, 1);
+
+    run("opus_decode_" + rate, FRAME_MS, [&](int i) {
+        const QByteArray& frame = frames[static_cast<size_t>(i % DISTINCT_FRAMES)];
+        const opus_int16* decoded = nullptr;
+        g_sink = decoder.decode(reinterpret_cast<const unsigned char*>(frame.constData()),
+                                frame.size(), &decoded);
+    });
+
+    run("opus_decode_" + rate + "_qbytearray", FRAME_MS, [&](int i) {
+        g_sink = decoder.decode(frames[static_cast<size_t>(i % DISTINCT_FRAMES)]).size();
+    });
+}
+
+// ============================================================================
+// AES-128-CTR封包
+// ============================================================================
+
+void benchCrypto() {
+    const QString key = "000102030405060708090a0b0c0d0e0f";
+    const QString nonce = "0100000012345678" "0000000000000000";
+    const std::vector<QByteArray> frames = encodeFrames(16000);
+
+    audio::AudioEncryptor encryptor;
+    encryptor.initialize(key, nonce);
+    std::vector<char> packet(2048);
+
+    run("aes_encrypt_qbytearray", FRAME_MS, [&](int i) {
+        g_sink = encryptor.encrypt(frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<uint32_t>(i)).size();
+    });
+
+    run("aes_encrypt_into", FRAME_MS, [&](int i) {
+        const QByteArray& frame = frames[static_cast<size_t>(i % DISTINCT_FRAMES)];
+        g_sink = encryptor.encryptInto(frame.constData(), frame.size(), static_cast<uint32_t>(i),
+                                       packet.data(), static_cast<int>(packet.size()));
+    });
+
+    // 解密需要序列号递增的不同包（防重放窗口会丢弃重复包）
+    const int warmup = qMax(10, g_frames / 10);
+    const int total = warmup + g_frames;
+    auto makePackets = [&]() {
+        audio::AudioEncryptor sender;
+        sender.initialize(key, nonce);
+        std::vector<QByteArray> packets;
+        packets.reserve(static_cast<size_t>(total));
+        for (int i = 0; i < total; ++i) {
+            packets.push_back(sender.encrypt(frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<uint32_t>(i)));
+        }
+        return packets;
+    };
+
+    {
+        const std::vector<QByteArray> packets = makePackets();
+        audio::AudioEncryptor receiver;
+        receiver.initialize(key, nonce);
+        run("aes_decrypt_qbytearray", FRAME_MS, [&](int i) {
+            uint32_t ts = 0;
+            uint32_t seq = 0;
+            g_sink = receiver.decrypt(packets[static_cast<size_t>(i)], ts, seq).size();
+        });
+    }
+
+    {
+        const std::vector<QByteArray> packets = makePackets();
+        audio::AudioEncryptor receiver;
+        receiver.initialize(key, nonce);
+        run("aes_decrypt_in_place", FRAME_MS, [&](int i) {
+            // 拷贝到接收缓冲模拟recv，计入耗时
+            const QByteArray& p = packets[static_cast<size_t>(i)];
+            std::memcpy(packet.data(), p.constData(), static_cast<size_t>(p.size()));
+            uint32_t ts = 0;
+            uint32_t seq = 0;
+            g_sink = receiver.decryptInPlace(packet.data(), p.size(), ts, seq);
+        });
+    }
+}
+
+// ============================================================================
+// WebSocket二进制协议
+// ============================================================================
+
+/**
+ * @brief 改造前的实现（每帧新建包；解析用mid()拷贝负载），作为对照基线
+ */
+namespace legacy {
+
+QByteArray buildBinaryPacket(int version, const QByteArray& opusData, quint32 timestamp) {
+    if (version == 2) {
+        QByteArray packet;
+        packet.resize(16 + opusData.size());
+        char* p = packet.data();
+        qToBigEndian<quint16>(static_cast<quint16>(version), p);
+        qToBigEndian<quint16>(0, p + 2);
+        qToBigEndian<quint32>(0, p + 4);
+        qToBigEndian<quint32>(timestamp, p + 8);
+        qToBigEndian<quint32>(static_cast<quint32>(opusData.size()), p + 12);
+        std::memcpy(p + 16, opusData.constData(), static_cast<size_t>(opusData.size()));
+        return packet;
+    } else if (version == 3) {
+        QByteArray packet;
+        packet.resize(4 + opusData.size());
+        char* p = packet.data();
+        p[0] = 0;
+        p[1] = 0;
+        qToBigEndian<quint16>(static_cast<quint16>(opusData.size()), p + 2);
+        std::memcpy(p + 4, opusData.constData(), static_cast<size_t>(opusData.size()));
+        return packet;
+    }
+    return opusData;
+}
+
+QByteArray parseBinaryPacket(int version, const QByteArray& data) {
+    if (version == 2) {
+        const quint32 payloadSize = qFromBigEndian<quint32>(data.constData() + 12);
+        return data.mid(16, static_cast<int>(payloadSize));
+    } else if (version == 3) {
+        const quint16 payloadSize = qFromBigEndian<quint16>(data.constData() + 2);
+        return data.mid(4, payloadSize);
+    }
+    return data;
+}
+
+} // namespace legacy
+
+/**
+ * @brief 现行接收路径：包头校验 + 引用原消息
+ */
+audio::OpusPacket parseIntoPacket(int version, const QByteArray& message) {
+    const QByteArrayView payload = network::WebSocketManager::binaryPayloadView(version, message);
+    if (payload.isEmpty()) {
+        return audio::OpusPacket();
+    }
+    return audio::OpusPacket(message, payload.data() - message.constData(), payload.size());
+}
+
+void benchWebSocket() {
+    const std::vector<QByteArray> frames = encodeFrames(16000);
+
+    for (int version = 1; version <= 3; ++version) {
+        const std::string v = "_v" + std::to_string(version);
+
+        run("ws_build" + v + "_legacy", FRAME_MS, [&](int i) {
+            g_sink = legacy::buildBinaryPacket(
+                version, frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<quint32>(i)).size();
+        });
+
+        // 发送路径：写入复用缓冲，稳态无分配
+        QByteArray txPacket;
+        run("ws_build" + v, FRAME_MS, [&](int i) {
+            g_sink = network::WebSocketManager::buildBinaryPacketInto(
+                version, frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<quint32>(i), txPacket);
+        });
+
+        std::vector<QByteArray> packets;
+        for (const QByteArray& frame : frames) {
+            packets.push_back(network::WebSocketManager::buildBinaryPacket(version, frame, 0));
+        }
+        run("ws_parse" + v + "_legacy", FRAME_MS, [&](int i) {
+            g_sink = legacy::parseBinaryPacket(version, packets[static_cast<size_t>(i % DISTINCT_FRAMES)]).size();
+        });
+
+        // 接收路径：校验包头后以原消息+偏移入抖动缓冲（同WebSocketWorker），负载不拷出
+        run("ws_parse" + v, FRAME_MS, [&](int i) {
+            g_sink = parseIntoPacket(version, packets[static_cast<size_t>(i % DISTINCT_FRAMES)]).size;
+        });
+
+        // 往返：封包→解析（对应一帧在两端各经历的协议处理）
+        run("ws_roundtrip" + v + "_legacy", FRAME_MS, [&](int i) {
+            const QByteArray packet = legacy::buildBinaryPacket(
+                version, frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<quint32>(i));
+            g_sink = legacy::parseBinaryPacket(version, packet).size();
+        });
+
+        run("ws_roundtrip" + v, FRAME_MS, [&](int i) {
+            network::WebSocketManager::buildBinaryPacketInto(
+                version, frames[static_cast<size_t>(i % DISTINCT_FRAMES)], static_cast<quint32>(i), txPacket);
+            g_sink = parseIntoPacket(version, txPacket).size;
+        });
+    }
+}
+
+// ============================================================================
+// 上行分帧（AudioCaptureWorker：按QAudioSource的10ms块喂入，满60ms帧即编码）
+// ============================================================================
+
+/**
+ * @brief 模拟采集设备：每次投喂一块PCM并发出readyRead
+ */
+class FeedDevice : public QIODevice {
+public:
+    explicit FeedDevice(QObject* parent) : QIODevice(parent) {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    void feed(const char* data, qint64 size) {
+        m_data = data;
+        m_size = size;
+        m_pos = 0;
+        emit readyRead();
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_size - m_pos; }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override {
+        const qint64 n = qMin(maxlen, m_size - m_pos);
+        std::memcpy(data, m_data + m_pos, static_cast<size_t>(n));
+        m_pos += n;
+        return n;
+    }
+
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    const char* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+};
+
+void benchCaptureFraming() {
+    constexpr int SAMPLE_RATE = 16000;
+    constexpr int CHUNK_MS = 10;
+    constexpr int CHUNKS_PER_FRAME = FRAME_MS / CHUNK_MS;
+    constexpr int CHUNK_BYTES = SAMPLE_RATE / 1000 * CHUNK_MS * 2;
+
+    const std::vector<opus_int16> pcm = makePcm(SAMPLE_RATE, SAMPLE_RATE / 1000 * FRAME_MS * DISTINCT_FRAMES);
+    const char* pcmBytes = reinterpret_cast<const char*>(pcm.data());
+    const int totalChunks = DISTINCT_FRAMES * CHUNKS_PER_FRAME;
+
+    audio::AudioCaptureWorker worker;
+    worker.initEncoder(false, 0);
+    FeedDevice* device = nullptr;
+    worker.setPcmSourceFactory([&device](const audio::AudioConfig&, QObject* parent) -> QIODevice* {
+        device = new FeedDevice(parent);
+        return device;
+    });
+    int encoded = 0;
+    QObject::connect(&worker, &audio::AudioCaptureWorker::encodedAudioReady, &worker,
+                     [&encoded](const QByteArray& opus) { encoded += opus.size() > 0; },
+                     Qt::DirectConnection);
+    worker.start();
+    if (!device) {
+        std::fprintf(stderr, "capture worker did not start\n");
+        return;
+    }
+
+    // 含Opus编码与跨线程投递的数据拷贝；减去opus_encode_16k即分帧本身的开销
+    int chunk = 0;
+    run("capture_framing_16k", FRAME_MS, [&](int) {
+        for (int c = 0; c < CHUNKS_PER_FRAME; ++c) {
+            device->feed(pcmBytes + static_cast<size_t>(chunk % totalChunks) * CHUNK_BYTES, CHUNK_BYTES);
+            ++chunk;
+        }
+    });
+    g_sink = encoded;
+    worker.stop();
+}
+
+void writeJson(const QString& path) {
+    QJsonArray array;
+    for (const Result& r : g_results) {
+        QJsonObject item;
+        item["name"] = QString::fromStdString(r.name);
+        item["ns_per_frame"] = r.nsPerFrame;
+        item["allocs_per_frame"] = r.allocsPerFrame;
+        item["frames_per_sec_core"] = 1e9 / r.nsPerFrame;
+        if (r.frameMs > 0) {
+            item["realtime_streams_core"] = r.frameMs * 1e6 / r.nsPerFrame;
+        }
+        array.append(item);
+    }
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(array).toJson());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    utils::Logger::instance().setConsoleOutput(false);
+
+    QString jsonPath;
+    const QStringList args = app.arguments();
+    for (int i = 1; i + 1 < args.size(); ++i) {
+        if (args[i] == "--frames") {
+            g_frames = qMax(1, args[++i].toInt());
+        } else if (args[i] == "--filter") {
+            g_filter = args[++i].toUtf8();
+        } else if (args[i] == "--json") {
+            jsonPath = args[++i];
+        }
+    }
+
+    std::printf("%-28s %12s %14s %14s %12s\n", "case", "ns/frame", "allocs/frame", "frames/s", "rt_streams");
+    benchOpus(16000);
+    benchOpus(24000);
+    benchCrypto();
+    benchWebSocket();
+    benchCaptureFraming();
+
+    if (!jsonPath.isEmpty()) {
+        writeJson(jsonPath);
+    }
+    return 0;
+}
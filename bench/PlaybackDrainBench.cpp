@@ -0,0 +1,90 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T11:00:00Z
+File: PlaybackDrainBench.cpp
+Desc: 播放缓冲排空微基准（前端删除式线性缓冲 vs SPSC环形缓冲，随缓冲时长变化）
+*/
+
+// 独立编译（在仓库根目录执行，仅依赖标准库与SpscRingBuffer.h）：
+//   g++ -std=c++20 -O2 -Isrc bench/PlaybackDrainBench.cpp -o playback_drain_bench
+//
+// 模拟AudioDevice的5ms排空节拍：每个tick写入一帧、输出设备取走等量字节。
+// 线性缓冲每次从头部删除已写部分（等价于QByteArray::remove(0, n)，搬移剩余全部数据），
+// 环形缓冲只推进读索引，开销与已缓冲时长无关。
+
+#include "audio/SpscRingBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using xiaozhi::audio::SpscRingBuffer;
+
+namespace {
+
+constexpr int SAMPLE_RATE = 24000;
+constexpr int BYTES_PER_MS = SAMPLE_RATE * 2 / 1000;   // 16bit单声道
+constexpr int TICK_MS = 5;
+constexpr int TICK_BYTES = BYTES_PER_MS * TICK_MS;
+constexpr int ITERATIONS = 20000;
+
+volatile char g_sink;   // 防止编译器消除"写入设备"的读取
+
+void consume(const char* data, size_t len) {
+    g_sink = data[len - 1];
+}
+
+double benchLinear(int bufferedMs) {
+    std::vector<char> buffer(static_cast<size_t>(bufferedMs) * BYTES_PER_MS, 1);
+    std::vector<char> frame(TICK_BYTES, 2);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        buffer.insert(buffer.end(), frame.begin(), frame.end());
+        consume(buffer.data(), TICK_BYTES);
+        buffer.erase(buffer.begin(), buffer.begin() + TICK_BYTES);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+double benchRing(int bufferedMs) {
+    const size_t prefill = static_cast<size_t>(bufferedMs) * BYTES_PER_MS;
+    SpscRingBuffer ring(prefill + TICK_BYTES);
+    std::vector<char> fill(prefill, 1);
+    ring.write(fill.data(), fill.size());
+    std::vector<char> frame(TICK_BYTES, 2);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        ring.write(frame.data(), frame.size());
+        size_t remaining = TICK_BYTES;
+        while (remaining > 0) {
+            const char* region = nullptr;
+            size_t n = ring.readRegion(&region);
+            if (n > remaining) {
+                n = remaining;
+            }
+            consume(region, n);
+            ring.commitRead(n);
+            remaining -= n;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-12s %16s %16s %10s\n", "buffered_ms", "linear_ns/tick", "ring_ns/tick", "speedup");
+    for (int bufferedMs : {20, 60, 120, 500, 1000, 3000, 10000}) {
+        const double linear = benchLinear(bufferedMs);
+        const double ring = benchRing(bufferedMs);
+        std::printf("%-12d %16.1f %16.1f %9.1fx\n", bufferedMs, linear, ring, linear / ring);
+    }
+    return 0;
+}
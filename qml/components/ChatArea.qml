@@ -162,6 +162,7 @@ Rectangle {
                     messageText: (modelData && modelData.textContent) ? modelData.textContent : ""
                     audioPath: (modelData && modelData.audioFilePath) ? modelData.audioFilePath : ""
                     imagePath: (modelData && modelData.imagePath) ? modelData.imagePath : ""
+                    thumbnailUrl: (modelData && modelData.thumbnailUrl) ? modelData.thumbnailUrl : ""
                     isPlaying: (modelData && modelData.isPlaying) ? modelData.isPlaying : false
                     timestamp: (modelData && modelData.timestamp) ? modelData.timestamp : 0
                     messageType: (modelData && modelData.messageType) ? modelData.messageType : ""
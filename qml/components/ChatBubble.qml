@@ -3,7 +3,7 @@ Project: jtxiaozhi-client
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-01-12T08:30:00Z
+Updated: 2026-10-16T23:40:00Z
 File: ChatBubble.qml
 Desc: 聊天气泡组件（支持文字和音频播放）
 */
@@ -22,6 +22,7 @@ Rectangle {
     property string messageText: ""
     property string audioPath: ""    // 音频文件路径
     property string imagePath: ""    // 图片文件路径
+    property string thumbnailUrl: "" // 缩略图URL（image://thumbnail/...），为空时回退原图
     property bool hasAudio: audioPath !== ""
     property bool hasImage: imagePath !== ""
     property bool isPlaying: false
@@ -160,7 +161,12 @@ Rectangle {
                         id: previewImage
                         anchors.fill: parent
                         anchors.margins: 2
-                        source: root.hasImage ? ("file:///" + root.imagePath) : ""
+                        // 气泡只显示缩略图（异步解码并由提供器缓存），不在列表中解码原图
+                        source: !root.hasImage ? ""
+                                : (root.thumbnailUrl !== "" ? root.thumbnailUrl : ("file:///" + root.imagePath))
+                        sourceSize.width: 400
+                        sourceSize.height: 300
+                        asynchronous: true
                         fillMode: Image.PreserveAspectFit
                         smooth: true
                         cache: false
@@ -538,7 +544,9 @@ Rectangle {
                 
                 Image {
                     id: fullImage
-                    source: root.hasImage ? ("file:///" + root.imagePath) : ""
+                    // 原图仅在打开查看窗口时加载，关闭后释放
+                    source: (root.hasImage && imageViewWindow.visible) ? ("file:///" + root.imagePath) : ""
+                    asynchronous: true
                     fillMode: Image.PreserveAspectFit  // 保持比例，完整显示
                     smooth: true
                     cache: false
@@ -0,0 +1,193 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T20:30:00Z
+File: AudioCaptureWorker.cpp
+Desc: 上行音频工作者实现
+*/
+
+#include "AudioCaptureWorker.h"
+#include "../network/UdpManager.h"
+#include "../network/WebSocketManager.h"
+#include "../utils/LatencyTracer.h"
+#include "../utils/Logger.h"
+#include <QAudioDevice>
+#include <QMediaDevices>
+
+namespace xiaozhi {
+namespace audio {
+
+namespace {
+constexpr int UPLINK_SAMPLE_RATE = 16000;   // 客户端发送给服务器的采样率
+constexpr int UPLINK_CHANNELS = 1;
+constexpr int UPLINK_BITRATE = 24000;
+}
+
+AudioCaptureWorker::AudioCaptureWorker(QObject* parent)
+    : QObject(parent)
+    , m_codec(std::make_unique<OpusCodec>())
+    , m_inputDevice(nullptr)
+    , m_udpWorker(nullptr)
+    , m_wsWorker(nullptr)
+    , m_frameBytes(0)
+    , m_frameFilled(0)
+    , m_frameCaptureNs(0)
+{
+    m_captureConfig.sampleRate = UPLINK_SAMPLE_RATE;
+    m_captureConfig.channelCount = UPLINK_CHANNELS;
+    m_captureConfig.sampleSize = 16;
+    m_captureConfig.sampleFormat = QAudioFormat::Int16;
+}
+
+AudioCaptureWorker::~AudioCaptureWorker() {
+    stop();
+}
+
+bool AudioCaptureWorker::initEncoder(bool inbandFec, int packetLossPercent) {
+    if (!m_codec->initEncoder(UPLINK_SAMPLE_RATE, UPLINK_CHANNELS, UPLINK_BITRATE)) {
+        return false;
+    }
+    if (inbandFec) {
+        // 可选：上行带内FEC，服务器在弱网下可恢复单个丢包
+        m_codec->setEncoderInbandFec(true, packetLossPercent);
+    }
+
+    // 目标帧大小（字节）：960样本 * 1声道 * 2字节 = 1920字节
+    m_frameBytes = m_codec->getEncoderFrameSize() * UPLINK_CHANNELS * 2;
+    m_frameBuffer.resize(m_frameBytes);
+    m_frameFilled = 0;
+
+    // 预分配编码输出缓冲区（热路径复用，不再逐帧分配）
+    m_encodeBuffer.resize(OpusCodec::maxPacketSize());
+    return true;
+}
+
+void AudioCaptureWorker::start() {
+    if (m_inputDevice) {
+        return;
+    }
+    if (m_frameBytes <= 0) {
+        emit captureFailed("Opus编码器未初始化");
+        return;
+    }
+
+    // 外部数据源（无头压测等）：不访问音频硬件
+    if (m_pcmSourceFactory) {
+        m_inputDevice = m_pcmSourceFactory(m_captureConfig, this);
+        if (!m_inputDevice) {
+            emit captureFailed("创建采集数据源失败");
+            return;
+        }
+        connect(m_inputDevice, &QIODevice::readyRead, this, &AudioCaptureWorker::onReadyRead);
+        m_frameFilled = 0;
+        emit captureStarted();
+        return;
+    }
+
+    // 获取默认音频输入设备
+    QAudioDevice inputDevice = QMediaDevices::defaultAudioInput();
+    if (inputDevice.isNull()) {
+        emit captureFailed("未找到音频输入设备");
+        return;
+    }
+
+    QAudioFormat format = m_captureConfig.toQAudioFormat();
+    if (!inputDevice.isFormatSupported(format)) {
+        emit captureFailed("音频格式不支持");
+        return;
+    }
+
+    // 在本线程创建音频源，readyRead直接在音频线程投递
+    m_audioSource = std::make_unique<QAudioSource>(inputDevice, format);
+    m_inputDevice = m_audioSource->start();
+    if (!m_inputDevice) {
+        m_audioSource.reset();
+        emit captureFailed("启动录音失败");
+        return;
+    }
+
+    connect(m_inputDevice, &QIODevice::readyRead, this, &AudioCaptureWorker::onReadyRead);
+    m_frameFilled = 0;
+    emit captureStarted();
+}
+
+void AudioCaptureWorker::stop() {
+    if (!m_inputDevice) {
+        return;
+    }
+
+    if (m_audioSource) {
+        m_audioSource->stop();
+        m_audioSource.reset();
+    } else {
+        // 工厂创建的数据源归本对象所有
+        m_inputDevice->close();
+        m_inputDevice->deleteLater();
+    }
+    m_inputDevice = nullptr;
+    m_frameFilled = 0;
+    emit captureStopped();
+}
+
+void AudioCaptureWorker::onReadyRead() {
+    if (!m_inputDevice) {
+        return;
+    }
+
+    const bool tracing = m_tracer && m_tracer->isEnabled();
+
+    // 每次只读取当前帧剩余部分，满帧即编码，之后从帧首继续填充
+    for (;;) {
+        const qint64 n = m_inputDevice->read(m_frameBuffer.data() + m_frameFilled,
+                                             m_frameBytes - m_frameFilled);
+        if (n <= 0) {
+            break;
+        }
+        if (tracing && m_frameFilled == 0) {
+            m_frameCaptureNs = utils::LatencyTracer::nowNs();
+        }
+        m_frameFilled += static_cast<int>(n);
+        if (m_frameFilled == m_frameBytes) {
+            encodeAndSend(m_frameBuffer.constData());
+            m_frameFilled = 0;
+        }
+    }
+}
+
+void AudioCaptureWorker::encodeAndSend(const char* pcm) {
+    quint32 traceId = 0;
+    if (m_tracer && m_tracer->isEnabled()) {
+        traceId = m_tracer->beginUplinkFrame(m_frameCaptureNs);
+    }
+
+    // Opus编码（直接写入复用的编码缓冲区，编码器本身不做堆分配）
+    const int encoded_bytes = m_codec->encode(
+        reinterpret_cast<const opus_int16*>(pcm),
+        m_codec->getEncoderFrameSize(),
+        reinterpret_cast<unsigned char*>(m_encodeBuffer.data()),
+        m_encodeBuffer.size()
+    );
+    if (encoded_bytes <= 0) {
+        utils::Logger::instance().error(" Opus编码失败");
+        return;
+    }
+    if (traceId != 0) {
+        m_tracer->markUplink(traceId, utils::TracePoint::Encoded);
+    }
+
+    if (m_udpWorker) {
+        // 同线程直接加密发送：包装复用缓冲区，不拷贝
+        m_udpWorker->sendAudioData(QByteArray::fromRawData(m_encodeBuffer.constData(), encoded_bytes));
+    } else if (m_wsWorker) {
+        // 同线程直接封包发送（封包时拷贝一次负载）
+        m_wsWorker->sendAudioData(QByteArray::fromRawData(m_encodeBuffer.constData(), encoded_bytes));
+    } else {
+        // 跨线程投递需要独立的数据副本（按实际长度拷贝一次）
+        emit encodedAudioReady(QByteArray(m_encodeBuffer.constData(), encoded_bytes));
+    }
+}
+
+} // namespace audio
+} // namespace xiaozhi
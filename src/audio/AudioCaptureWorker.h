@@ -0,0 +1,154 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T20:30:00Z
+File: AudioCaptureWorker.h
+Desc: 上行音频工作者（在实时音频线程中完成采集→分帧→编码→加密发送）
+*/
+
+#ifndef AUDIO_CAPTURE_WORKER_H
+#define AUDIO_CAPTURE_WORKER_H
+
+#include "AudioTypes.h"
+#include "OpusCodec.h"
+#include <QObject>
+#include <QAudioSource>
+#include <QIODevice>
+#include <QByteArray>
+#include <functional>
+#include <memory>
+
+namespace xiaozhi {
+namespace network {
+class UdpWorker;
+class WebSocketWorker;
+}
+
+namespace utils {
+class LatencyTracer;
+}
+
+namespace audio {
+
+/**
+ * @brief 采集数据源工厂（替代QMediaDevices麦克风，如无头压测的合成/文件PCM）
+ *
+ * 在音频线程中调用；返回的设备需已打开，按config格式产出PCM并发出readyRead，
+ * 所有权归parent
+ */
+using PcmSourceFactory = std::function<QIODevice*(const AudioConfig& config, QObject* parent)>;
+
+/**
+ * @brief 上行音频工作者
+ *
+ * 运行在高优先级的音频线程中，GUI线程繁忙（QML布局、数据库）不会延迟上行帧：
+ * - MQTT+UDP模式：与UdpWorker同处UDP线程，编码后直接调用其发送（无跨线程拷贝）
+ * - WebSocket模式：与WebSocketWorker同处网络音频线程，同样直接调用其发送
+ *
+ * 控制接口start/stop需通过队列调用进入所在线程；与UI只通过状态信号交互
+ */
+class AudioCaptureWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AudioCaptureWorker(QObject* parent = nullptr);
+    ~AudioCaptureWorker();
+
+    /**
+     * @brief 初始化编码器（moveToThread之前调用）
+     * @param inbandFec 是否开启上行带内FEC
+     * @param packetLossPercent FEC预期丢包率（%）
+     */
+    bool initEncoder(bool inbandFec, int packetLossPercent);
+
+    /**
+     * @brief 设置同线程直接发送的UDP工作者（为空时改为发出encodedAudioReady）
+     */
+    void setUdpWorker(network::UdpWorker* udpWorker) { m_udpWorker = udpWorker; }
+
+    /**
+     * @brief 设置同线程直接发送的WebSocket工作者（为空时改为发出encodedAudioReady）
+     */
+    void setWebSocketWorker(network::WebSocketWorker* wsWorker) { m_wsWorker = wsWorker; }
+
+    /**
+     * @brief 设置采集数据源工厂（为空时使用默认麦克风；需在音频线程中、start之前调用）
+     */
+    void setPcmSourceFactory(PcmSourceFactory factory) { m_pcmSourceFactory = std::move(factory); }
+
+    /**
+     * @brief 设置延迟追踪器（moveToThread之前调用；为空时不打点）
+     */
+    void setLatencyTracer(std::shared_ptr<utils::LatencyTracer> tracer) { m_tracer = std::move(tracer); }
+
+public slots:
+    /**
+     * @brief 在当前线程创建采集设备并开始录音
+     */
+    void start();
+
+    /**
+     * @brief 停止录音并丢弃未满一帧的数据
+     */
+    void stop();
+
+signals:
+    /**
+     * @brief 录音已开始
+     */
+    void captureStarted();
+
+    /**
+     * @brief 录音已停止
+     */
+    void captureStopped();
+
+    /**
+     * @brief 录音启动失败或运行出错
+     */
+    void captureFailed(const QString& error);
+
+    /**
+     * @brief 编码完成的Opus帧（仅在未设置同线程发送工作者时发出）
+     */
+    void encodedAudioReady(const QByteArray& opus_data);
+
+private slots:
+    /**
+     * @brief 采集数据就绪：直接读入帧缓冲，满一帧即原地编码发送
+     */
+    void onReadyRead();
+
+private:
+    /**
+     * @brief 编码一帧PCM并发送
+     */
+    void encodeAndSend(const char* pcm);
+
+    std::unique_ptr<OpusCodec> m_codec;
+    std::unique_ptr<QAudioSource> m_audioSource;
+    PcmSourceFactory m_pcmSourceFactory;
+    QIODevice* m_inputDevice;           // 当前采集设备（麦克风或工厂创建的数据源）
+    network::UdpWorker* m_udpWorker;
+    network::WebSocketWorker* m_wsWorker;
+    AudioConfig m_captureConfig;    // 采集格式（与编码器一致：16kHz单声道）
+
+    // 分帧缓冲：固定一帧大小，采集数据直接读入，满帧后整帧交给编码器
+    // 不做append/remove，无逐帧分配和搬移；采集与编码同线程，无需多槽位
+    QByteArray m_frameBuffer;
+    int m_frameBytes;               // 目标帧大小（字节）
+    int m_frameFilled;              // 当前帧已填充字节数
+    qint64 m_frameCaptureNs;        // 当前帧首个采样块读出时刻（延迟追踪用）
+
+    std::shared_ptr<utils::LatencyTracer> m_tracer;
+
+    // 编码输出缓冲区（预分配，逐帧复用）
+    QByteArray m_encodeBuffer;
+};
+
+} // namespace audio
+} // namespace xiaozhi
+
+#endif // AUDIO_CAPTURE_WORKER_H
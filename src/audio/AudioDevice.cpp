@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:32:00Z
+Updated: 2026-10-17T10:00:00Z
 File: AudioDevice.cpp
 Desc: 音频设备管理器实现
 */
@@ -19,13 +19,30 @@ namespace audio {
 AudioDevice::AudioDevice(QObject* parent)
     : QObject(parent)
     , m_inputDevice(nullptr)
-    , m_outputDevice(nullptr)
     , m_recording(false)
     , m_playing(false)
+    , m_nullSinkTimer(new QTimer(this))
+    , m_drainTimer(new QTimer(this))
+    , m_playbackSource(std::make_unique<PlaybackRingDevice>())
 {
-    // 回退定时器用于在QAudioSink通知之前继续尝试写入
-    connect(&m_drainFallbackTimer, &QTimer::timeout, this, &AudioDevice::drainPlaybackQueue);
-    m_drainFallbackTimer.setInterval(5); // 5ms tick，低开销
+    // 拉模式数据源：音频后端按自身节奏读取，无需定时器推送
+    m_playbackSource->open(QIODevice::ReadOnly);
+    // 拉取端释放空间后回到本线程搬运积压（保持环形缓冲单生产者）
+    connect(m_playbackSource.get(), &PlaybackRingDevice::spaceAvailable,
+            this, &AudioDevice::refillFromBacklog, Qt::QueuedConnection);
+    connect(m_playbackSource.get(), &PlaybackRingDevice::dataRequested,
+            this, &AudioDevice::onPlaybackDemand, Qt::QueuedConnection);
+
+    m_nullSinkTimer->setTimerType(Qt::PreciseTimer);
+    m_nullSinkTimer->setInterval(NULL_SINK_PERIOD_MS);
+    connect(m_nullSinkTimer, &QTimer::timeout, this, &AudioDevice::onNullSinkTick);
+
+    m_drainTimer->setSingleShot(true);
+    connect(m_drainTimer, &QTimer::timeout, this, [this]() {
+        if (m_draining) {
+            finishDrain();
+        }
+    });
 }
 
 AudioDevice::~AudioDevice() {
@@ -90,6 +107,17 @@ bool AudioDevice::startPlayback() {
         return true;
     }
 
+    // 空输出模式：不访问音频硬件，按墙钟模拟设备消耗
+    if (m_nullSink) {
+        m_nullSinkPending = 0;
+        m_nullSinkLastMs = 0;
+        m_nullSinkClock.start();
+        m_nullSinkTimer->start();
+        m_playing = true;
+        emit playbackStarted();
+        return true;
+    }
+
     // 获取默认音频输出设备
     QAudioDevice outputDevice = QMediaDevices::defaultAudioOutput();
     if (outputDevice.isNull()) {
@@ -106,22 +134,25 @@ bool AudioDevice::startPlayback() {
         return false;
     }
 
+    // 按新配置准备播放环形缓冲
+    ensurePlaybackRing();
+
     // 创建音频接收器
     m_audioSink = std::make_unique<QAudioSink>(outputDevice, format, this);
 
-    // 启动播放
-    m_outputDevice = m_audioSink->start();
-    if (m_outputDevice) {
-        m_playing = true;
-        emit playbackStarted();
-        // 启动主动排空逻辑
-        drainPlaybackQueue();
-        m_drainFallbackTimer.start();
-        return true;
+    connect(m_audioSink.get(), &QAudioSink::stateChanged, this, &AudioDevice::onSinkStateChanged);
+
+    // 启动播放（拉模式）
+    m_audioSink->start(m_playbackSource.get());
+    if (m_audioSink->error() != QAudio::NoError) {
+        m_audioSink.reset();
+        emit errorOccurred("启动播放失败");
+        return false;
     }
 
-    emit errorOccurred("启动播放失败");
-    return false;
+    m_playing = true;
+    emit playbackStarted();
+    return true;
 }
 
 void AudioDevice::stopPlayback() {
@@ -134,13 +165,115 @@ void AudioDevice::stopPlayback() {
         m_audioSink.reset();
     }
 
-    m_outputDevice = nullptr;
+    // 接收器已停止，拉取端静止后才能清空环形缓冲
     m_playing = false;
-    m_pendingPlaybackBuffer.clear();
-    m_drainFallbackTimer.stop();
+    if (m_playbackRing) {
+        m_playbackRing->clear();
+    }
+    m_playbackBacklog.clear();
+    m_playbackBacklogOffset = 0;
+    m_nullSinkTimer->stop();
+    m_nullSinkPending = 0;
+    m_playbackDemandBytes = 0;
+    m_playbackSource->requestData(0);
+    m_draining = false;
+    m_drainTimer->stop();
     emit playbackStopped();
 }
 
+void AudioDevice::drainPlayback() {
+    if (!m_playing) {
+        emit playbackFinished();
+        return;
+    }
+
+    m_draining = true;
+    m_playbackDemandBytes = 0;
+
+    // 输出设备未报告Idle时按剩余时长兜底（含设备内部缓冲）
+    qint64 remaining = pendingPlaybackBytes();
+    if (m_audioSink) {
+        remaining += m_audioSink->bufferSize();
+    }
+    m_drainTimer->start(static_cast<int>(remaining * 1000 / qMax<qint64>(1, bytesPerSecond())) + DRAIN_MARGIN_MS);
+    checkDrained();
+}
+
+void AudioDevice::cancelDrain() {
+    m_draining = false;
+    m_drainTimer->stop();
+}
+
+void AudioDevice::requestPlaybackData(qint64 lowWatermarkBytes) {
+    m_playbackDemandBytes = qMax<qint64>(0, lowWatermarkBytes);
+    if (!m_playing || m_nullSink) {
+        return;  // 空输出模式由模拟拉取周期检查
+    }
+    m_playbackSource->requestData(m_playbackDemandBytes);
+}
+
+void AudioDevice::onPlaybackDemand() {
+    if (!m_playing || m_playbackDemandBytes <= 0) {
+        return;
+    }
+    // 环形缓冲低于水位但仍有积压时先搬运，积压也不足才需要生产者解码
+    refillFromBacklog();
+    if (pendingPlaybackBytes() < m_playbackDemandBytes) {
+        m_playbackDemandBytes = 0;
+        emit playbackDataRequested();
+    } else {
+        m_playbackSource->requestData(m_playbackDemandBytes);
+    }
+}
+
+void AudioDevice::onSinkStateChanged(QAudio::State state) {
+    if (state == QAudio::IdleState) {
+        checkDrained();
+    }
+}
+
+void AudioDevice::onNullSinkTick() {
+    advanceNullSink();
+    if (m_playbackDemandBytes > 0 && m_nullSinkPending < m_playbackDemandBytes) {
+        m_playbackDemandBytes = 0;
+        emit playbackDataRequested();
+    }
+    checkDrained();
+}
+
+qint64 AudioDevice::bytesPerSecond() const {
+    return static_cast<qint64>(qMax(1, m_config.sampleRate))
+         * qMax(1, m_config.channelCount)
+         * qMax(1, m_config.sampleSize / 8);
+}
+
+void AudioDevice::advanceNullSink() {
+    const qint64 now = m_nullSinkClock.elapsed();
+    const qint64 consumed = (now - m_nullSinkLastMs) * bytesPerSecond() / 1000;
+    if (consumed > 0) {
+        m_nullSinkPending = qMax<qint64>(0, m_nullSinkPending - consumed);
+        m_nullSinkLastMs = now;
+    }
+}
+
+void AudioDevice::checkDrained() {
+    if (!m_draining || pendingPlaybackBytes() > 0) {
+        return;
+    }
+    // 真实设备还要等内部缓冲播完（拉取不到数据后进入Idle）
+    if (m_audioSink && m_audioSink->state() != QAudio::IdleState) {
+        return;
+    }
+    finishDrain();
+}
+
+void AudioDevice::finishDrain() {
+    m_draining = false;
+    m_drainTimer->stop();
+    stopPlayback();
+    emit playbackFinished();
+}
+
 void AudioDevice::setAudioConfig(const AudioConfig& config) {
     m_config = config;
 }
@@ -155,37 +288,76 @@ void AudioDevice::handleAudioData() {
 }
 
 void AudioDevice::writeAudioData(const QByteArray& data) {
-    if (!m_playing || !m_outputDevice) {
+    // 排空期间又有新数据：继续正常播放
+    if (m_draining && !data.isEmpty()) {
+        cancelDrain();
+    }
+    if (m_nullSink) {
+        if (m_playing) {
+            m_nullSinkBytes += static_cast<quint64>(data.size());
+            advanceNullSink();
+            m_nullSinkPending += data.size();
+        }
+        return;
+    }
+    if (!m_playing || !m_playbackRing) {
         return;
     }
     if (data.isEmpty()) {
         return;
     }
-    // 追加到待播放缓冲，由drainPlaybackQueue按bytesFree写入
-    m_pendingPlaybackBuffer.append(data);
-    drainPlaybackQueue();
+    // 已有积压时必须排在积压之后，保持播放顺序
+    qsizetype accepted = 0;
+    if (m_playbackBacklog.isEmpty()) {
+        accepted = static_cast<qsizetype>(m_playbackRing->write(data.constData(), static_cast<size_t>(data.size())));
+    }
+    // 环形缓冲放不下的部分进入积压，随拉取逐步搬入
+    if (accepted < data.size()) {
+        m_playbackBacklog.append(data.constData() + accepted, data.size() - accepted);
+        m_playbackSource->requestRefill();
+    }
+    if (accepted > 0) {
+        m_playbackSource->notifyDataAvailable();
+    }
 }
 
-void AudioDevice::drainPlaybackQueue() {
-    if (!m_playing || !m_outputDevice) {
-        m_pendingPlaybackBuffer.clear();
-        return;
+qint64 AudioDevice::pendingPlaybackBytes() const {
+    if (m_nullSink) {
+        return m_nullSinkPending;
     }
-    if (m_pendingPlaybackBuffer.isEmpty()) {
+    const qint64 ringBytes = m_playbackRing ? static_cast<qint64>(m_playbackRing->size()) : 0;
+    return ringBytes + (m_playbackBacklog.size() - m_playbackBacklogOffset);
+}
+
+void AudioDevice::ensurePlaybackRing() {
+    const int bytesPerSample = qMax(1, m_config.sampleSize / 8);
+    const size_t wanted = static_cast<size_t>(qMax(1, m_config.sampleRate))
+                        * static_cast<size_t>(qMax(1, m_config.channelCount))
+                        * static_cast<size_t>(bytesPerSample)
+                        * PLAYBACK_RING_SECONDS;
+    // 容量取整为2的幂，同一配置下复用已分配的缓冲
+    if (m_playbackRing && m_playbackRing->capacity() >= wanted && m_playbackRing->capacity() < wanted * 2) {
+        m_playbackRing->clear();
         return;
     }
-    // 查询可写字节，避免阻塞和写失败
-    const qint64 freeBytes = m_audioSink ? m_audioSink->bytesFree() : 0;
-    if (freeBytes <= 0) {
+    m_playbackRing = std::make_unique<SpscRingBuffer>(wanted);
+    m_playbackSource->setRingBuffer(m_playbackRing.get());
+}
+
+void AudioDevice::refillFromBacklog() {
+    if (!m_playing || m_playbackBacklog.isEmpty()) {
         return;
     }
-    // 一次写不超过可用空间与缓冲剩余
-    const qint64 toWrite = qMin<qint64>(freeBytes, m_pendingPlaybackBuffer.size());
-    if (toWrite <= 0) return;
-
-    qint64 written = m_outputDevice->write(m_pendingPlaybackBuffer.constData(), toWrite);
-    if (written > 0) {
-        m_pendingPlaybackBuffer.remove(0, static_cast<int>(written));
+    const qsizetype remaining = m_playbackBacklog.size() - m_playbackBacklogOffset;
+    const size_t moved = m_playbackRing->write(m_playbackBacklog.constData() + m_playbackBacklogOffset,
+                                               static_cast<size_t>(remaining));
+    m_playbackBacklogOffset += static_cast<qsizetype>(moved);
+    // 积压整体消费完才释放，期间只移动偏移不搬移数据
+    if (m_playbackBacklogOffset >= m_playbackBacklog.size()) {
+        m_playbackBacklog.clear();
+        m_playbackBacklogOffset = 0;
+    } else {
+        m_playbackSource->requestRefill();
     }
 }
 
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:32:00Z
+Updated: 2026-10-17T09:10:00Z
 File: AudioDevice.h
 Desc: 音频设备管理器（基础录音/播放启动停止功能）
 */
@@ -12,12 +12,15 @@ Desc: 音频设备管理器（基础录音/播放启动停止功能）
 #define AUDIO_DEVICE_H
 
 #include "AudioTypes.h"
+#include "SpscRingBuffer.h"
+#include "PlaybackRingDevice.h"
 #include <QObject>
 #include <QAudioSource>
 #include <QAudioSink>
 #include <QIODevice>
-#include <QTimer>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <memory>
 
 namespace xiaozhi {
@@ -53,6 +56,25 @@ public:
      */
     void stopPlayback();
 
+    /**
+     * @brief 排空播放：已写入的数据（含输出设备内部缓冲）播完后停止，并发出playbackFinished
+     *
+     * 排空期间再写入数据或调用cancelDrain时取消，继续正常播放
+     */
+    void drainPlayback();
+
+    /**
+     * @brief 取消排空，继续正常播放
+     */
+    void cancelDrain();
+
+    /**
+     * @brief 请求在待播放数据低于指定字节数时发出一次playbackDataRequested
+     *
+     * 由输出设备的拉取驱动（空输出模式由模拟时钟驱动），生产者无需定时器
+     */
+    void requestPlaybackData(qint64 lowWatermarkBytes);
+
     /**
      * @brief 是否正在录音
      */
@@ -73,12 +95,32 @@ public:
      */
     AudioConfig audioConfig() const { return m_config; }
 
+    /**
+     * @brief 空输出模式：播放不打开音频硬件，写入的PCM只计数后丢弃（无头压测）
+     */
+    void setNullSink(bool enabled) { m_nullSink = enabled; }
+
+    /**
+     * @brief 空输出模式下累计丢弃的PCM字节数
+     */
+    quint64 nullSinkBytes() const { return m_nullSinkBytes; }
+
     /**
      * @brief 写入PCM数据到播放设备
      * @param data PCM原始数据（不包含任何头部），采样率/声道需与当前配置一致
      */
     void writeAudioData(const QByteArray& data);
 
+    /**
+     * @brief 待播放缓冲中尚未被输出设备拉取的字节数（环形缓冲+溢出积压）
+     */
+    qint64 pendingPlaybackBytes() const;
+
+    /**
+     * @brief 播放缓冲耗尽次数（见PlaybackRingDevice::underrunCount）
+     */
+    quint64 playbackUnderruns() const { return m_playbackSource->underrunCount(); }
+
 signals:
     /**
      * @brief 音频数据就绪（录音）
@@ -110,6 +152,11 @@ signals:
      */
     void playbackFinished();
 
+    /**
+     * @brief 待播放数据已低于requestPlaybackData设置的水位（一次性）
+     */
+    void playbackDataRequested();
+
     /**
      * @brief 发生错误
      */
@@ -122,22 +169,82 @@ private slots:
     void handleAudioData();
 
     /**
-     * @brief 尝试将待播放缓冲写入输出设备（基于bytesFree进行节流）
+     * @brief 将溢出积压尽量搬入环形缓冲（写入端调用，或由拉取端空间释放后排队触发）
      */
-    void drainPlaybackQueue();
+    void refillFromBacklog();
+
+    /**
+     * @brief 拉取端报告环形缓冲低于水位：先搬运积压，仍不足时通知生产者
+     */
+    void onPlaybackDemand();
+
+    /**
+     * @brief 输出设备状态变化（排空时等待进入Idle）
+     */
+    void onSinkStateChanged(QAudio::State state);
+
+    /**
+     * @brief 空输出模式的模拟拉取周期
+     */
+    void onNullSinkTick();
 
 private:
+    /**
+     * @brief 按当前音频配置分配播放环形缓冲（容量不变时复用）
+     */
+    void ensurePlaybackRing();
+
+    /**
+     * @brief 当前配置下每秒PCM字节数
+     */
+    qint64 bytesPerSecond() const;
+
+    /**
+     * @brief 空输出模式：按墙钟消耗模拟的待播放数据
+     */
+    void advanceNullSink();
+
+    /**
+     * @brief 排空条件满足时结束播放
+     */
+    void checkDrained();
+
+    /**
+     * @brief 结束排空：停止播放并发出playbackFinished
+     */
+    void finishDrain();
+
+    static constexpr int NULL_SINK_PERIOD_MS = 20;   // 空输出模式模拟的设备拉取周期
+    static constexpr int DRAIN_MARGIN_MS = 200;      // 排空兜底超时余量（设备未报告Idle时）
+
+    // 播放环形缓冲可容纳的音频时长（秒），覆盖抖动缓冲上限（3秒）
+    static constexpr int PLAYBACK_RING_SECONDS = 4;
+
     AudioConfig m_config;
     std::unique_ptr<QAudioSource> m_audioSource;
     std::unique_ptr<QAudioSink> m_audioSink;
     QIODevice* m_inputDevice;
-    QIODevice* m_outputDevice;
     bool m_recording;
     bool m_playing;
-
-    // 播放缓冲与节流
-    QByteArray m_pendingPlaybackBuffer;
-    QTimer m_drainFallbackTimer;
+    bool m_nullSink = false;
+    quint64 m_nullSinkBytes = 0;
+    QTimer* m_nullSinkTimer;
+    QElapsedTimer m_nullSinkClock;
+    qint64 m_nullSinkPending = 0;       // 空输出模式下模拟的待播放字节数
+    qint64 m_nullSinkLastMs = 0;
+
+    // 播放节奏与排空
+    qint64 m_playbackDemandBytes = 0;   // 已请求的低水位（0表示未请求）
+    bool m_draining = false;
+    QTimer* m_drainTimer;
+
+    // 播放缓冲（拉模式）
+    // 环形缓冲：生产者writeAudioData写入，m_playbackSource由音频后端拉取消费，两端均不搬移数据
+    std::unique_ptr<SpscRingBuffer> m_playbackRing;
+    std::unique_ptr<PlaybackRingDevice> m_playbackSource;
+    // 溢出积压：一次写入超过环形缓冲剩余空间时（如整段缓存消息回放）暂存，按偏移消费
+    QByteArray m_playbackBacklog;
+    qsizetype m_playbackBacklogOffset = 0;
 };
 
 } // namespace audio
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T07:00:00Z
+Updated: 2026-10-16T14:00:00Z
 File: AudioEncryptor.cpp
 Desc: 音频数据AES-CTR加密/解密实现（修复解密时使用实际payload长度）
 */
@@ -22,6 +22,8 @@ AudioEncryptor::AudioEncryptor(QObject* parent)
     , m_decryptCtx(nullptr)
     , m_localSequence(0)
     , m_remoteSequence(0)
+    , m_replayWindow(0)
+    , m_hasRemoteSequence(false)
     , m_ssrc(0)
     , m_initialized(false)
 {
@@ -78,6 +80,9 @@ bool AudioEncryptor::initialize(const QString& keyHex, const QString& nonceHex)
     m_initialized = true;
     m_localSequence = 0;
     m_remoteSequence = 0;
+    m_replayWindow = 0;
+    m_hasRemoteSequence = false;
+    m_receiveStats = ReceiveStats();
     
     // 从nonce中提取SSRC (位置4-7)
     // nonce结构: [type 1][flags 1][len 2][ssrc 4][timestamp 4][sequence 4]
@@ -90,13 +95,36 @@ bool AudioEncryptor::initialize(const QString& keyHex, const QString& nonceHex)
 }
 
 QByteArray AudioEncryptor::encrypt(const QByteArray& audioData, uint32_t timestamp) {
+    if (audioData.isEmpty()) {
+        return QByteArray();
+    }
+
+    // 兼容接口：分配一次完整包缓冲，由encryptInto直接写入
+    QByteArray packet(packetSize(audioData.size()), Qt::Uninitialized);
+    const int written = encryptInto(audioData.constData(), audioData.size(), timestamp,
+                                    packet.data(), packet.size());
+    if (written < 0) {
+        return QByteArray();
+    }
+    return packet;
+}
+
+int AudioEncryptor::encryptInto(const char* payload, int payloadSize, uint32_t timestamp,
+                                char* out, int capacity) {
     if (!m_initialized) {
         utils::Logger::instance().error("加密器未初始化");
-        return QByteArray();
+        return -1;
     }
     
-    if (audioData.isEmpty()) {
-        return QByteArray();
+    if (!payload || payloadSize <= 0 || payloadSize > 0xFFFF) {
+        return -1;
+    }
+
+    const int total = packetSize(payloadSize);
+    if (!out || capacity < total) {
+        utils::Logger::instance().error(QString("加密输出缓冲不足: 需要%1字节, 可用%2字节")
+            .arg(total).arg(capacity));
+        return -1;
     }
     
     // 递增序列号
@@ -108,60 +136,64 @@ QByteArray AudioEncryptor::encrypt(const QByteArray& audioData, uint32_t timesta
     //           *(uint32_t*)&nonce[8] = htonl(packet->timestamp);
     //           *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
     // nonce结构就是header: [type][flags][len][ssrc][timestamp][sequence]
-    QByteArray nonce = m_nonce;  // 复制原始nonce（已包含type/flags/ssrc）
+    // 直接在输出缓冲的包头位置构造，包头同时作为CTR IV
+    memcpy(out, m_nonce.constData(), sizeof(AudioPacketHeader));  // 已包含type/flags/ssrc
     
     // 在nonce的特定位置写入payload长度、时间戳和序列号（网络字节序）
-    uint16_t payloadLen = htons_custom(audioData.size());
+    uint16_t payloadLen = htons_custom(static_cast<uint16_t>(payloadSize));
     uint32_t ts = htonl_custom(timestamp);
     uint32_t seq = htonl_custom(sequence);
     
-    memcpy(nonce.data() + 2, &payloadLen, 2);   // 位置2-3
-    memcpy(nonce.data() + 8, &ts, 4);           // 位置8-11
-    memcpy(nonce.data() + 12, &seq, 4);         // 位置12-15
+    memcpy(out + 2, &payloadLen, 2);    // 位置2-3
+    memcpy(out + 8, &ts, 4);            // 位置8-11
+    memcpy(out + 12, &seq, 4);          // 位置12-15
     // 位置0-1 (type/flags) 和 位置4-7 (ssrc) 保持服务器提供的值不变
     
-    // 加密音频数据
-    QByteArray encrypted(audioData.size(), 0);
-    int outLen = 0;
-    
-    // 重新初始化IV（使用修改后的nonce）
+    // 重新初始化IV（使用修改后的nonce，即包头）
     if (EVP_EncryptInit_ex(m_encryptCtx, nullptr, nullptr, nullptr, 
-                          (const unsigned char*)nonce.data()) != 1) {
+                          (const unsigned char*)out) != 1) {
         utils::Logger::instance().error("重新初始化加密IV失败");
-        return QByteArray();
+        return -1;
     }
     
-    if (EVP_EncryptUpdate(m_encryptCtx, (unsigned char*)encrypted.data(), &outLen,
-                         (const unsigned char*)audioData.data(), audioData.size()) != 1) {
+    // 负载一次遍历加密到包头之后（与ESP32一致：modified_nonce + encrypted_payload）
+    int outLen = 0;
+    if (EVP_EncryptUpdate(m_encryptCtx, (unsigned char*)(out + sizeof(AudioPacketHeader)), &outLen,
+                         (const unsigned char*)payload, payloadSize) != 1) {
         utils::Logger::instance().error("加密失败");
-        return QByteArray();
+        return -1;
     }
     
-    // 构建完整UDP包：nonce(16字节，就是header) + 加密负载
-    // 与ESP32完全一致：modified_nonce + encrypted_payload
-    QByteArray packet(16 + encrypted.size(), 0);
-    memcpy(packet.data(), nonce.data(), 16);  // 前16字节是修改后的nonce（就是header）
-    memcpy(packet.data() + 16, encrypted.data(), encrypted.size());  // 后面是加密的payload
-    
-    return packet;
+    return total;
 }
 
 QByteArray AudioEncryptor::decrypt(const QByteArray& encryptedPacket, 
                                   uint32_t& timestamp, 
                                   uint32_t& sequence) {
+    // 兼容接口：拷贝一份后原地解密，只返回负载部分
+    QByteArray packet(encryptedPacket.constData(), encryptedPacket.size());
+    const int payloadSize = decryptInPlace(packet.data(), packet.size(), timestamp, sequence);
+    if (payloadSize <= 0) {
+        return QByteArray();
+    }
+    packet.remove(0, sizeof(AudioPacketHeader));
+    return packet;
+}
+
+int AudioEncryptor::decryptInPlace(char* packet, int size, uint32_t& timestamp, uint32_t& sequence) {
     if (!m_initialized) {
         utils::Logger::instance().error("加密器未初始化");
-        return QByteArray();
+        return -1;
     }
     
-    if (encryptedPacket.size() < (int)sizeof(AudioPacketHeader)) {
-        utils::Logger::instance().error(QString("UDP包太小: %1字节").arg(encryptedPacket.size()));
-        return QByteArray();
+    if (!packet || size < (int)sizeof(AudioPacketHeader)) {
+        utils::Logger::instance().error(QString("UDP包太小: %1字节").arg(size));
+        return -1;
     }
     
     // 解析包头
     AudioPacketHeader header;
-    memcpy(&header, encryptedPacket.data(), sizeof(AudioPacketHeader));
+    memcpy(&header, packet, sizeof(AudioPacketHeader));
     
     header.payload_len = ntohs_custom(header.payload_len);
     header.ssrc = ntohl_custom(header.ssrc);
@@ -171,18 +203,16 @@ QByteArray AudioEncryptor::decrypt(const QByteArray& encryptedPacket,
     // 验证包类型
     if (header.type != 0x01) {
         utils::Logger::instance().warn(QString("未知包类型: 0x%1").arg(header.type, 2, 16, QChar('0')));
-        return QByteArray();
+        return -1;
     }
     
-    // 验证序列号连续性
-    if (m_remoteSequence > 0 && sequence != m_remoteSequence + 1) {
-        utils::Logger::instance().warn(QString("序列号跳跃: 期望=%1, 实际=%2")
-            .arg(m_remoteSequence + 1).arg(sequence));
+    // 防重放窗口：丢弃重复包与过旧包，乱序包在窗口内照常接受（只计数不逐包打日志）
+    if (!acceptSequence(sequence)) {
+        return 0;
     }
-    m_remoteSequence = sequence;
     
     // 提取加密负载（使用实际计算的大小，服务器可能不填payload_len字段）
-    int payloadSize = encryptedPacket.size() - sizeof(AudioPacketHeader);
+    int payloadSize = size - sizeof(AudioPacketHeader);
     if (payloadSize != header.payload_len && header.payload_len != 0) {
         // 只在payload_len非0且不匹配时才警告（服务器payload_len=0是正常的）
         utils::Logger::instance().debug(QString("负载长度不匹配: 包头=%1, 实际=%2")
@@ -190,32 +220,75 @@ QByteArray AudioEncryptor::decrypt(const QByteArray& encryptedPacket,
     }
     
     // 直接使用数据包前16字节作为CTR IV（与ESP32/旧客户端一致，完全避免长度字段不一致导致的偏移）
-    QByteArray nonce = encryptedPacket.left(sizeof(AudioPacketHeader));
-    
-    // 解密
-    QByteArray decrypted(payloadSize, 0);
-    int outLen = 0;
-    
-    // 重新初始化IV
+    // 重新初始化IV（EVP在Init时复制IV，之后包头内容不再被引用）
     if (EVP_DecryptInit_ex(m_decryptCtx, nullptr, nullptr, nullptr, 
-                          (const unsigned char*)nonce.constData()) != 1) {
+                          (const unsigned char*)packet) != 1) {
         utils::Logger::instance().error("重新初始化解密IV失败");
-        return QByteArray();
+        return -1;
     }
     
-    if (EVP_DecryptUpdate(m_decryptCtx, (unsigned char*)decrypted.data(), &outLen,
-                         (const unsigned char*)(encryptedPacket.data() + sizeof(AudioPacketHeader)), 
-                         payloadSize) != 1) {
+    // CTR模式允许输入输出完全重叠：负载原地解密
+    unsigned char* body = (unsigned char*)(packet + sizeof(AudioPacketHeader));
+    int outLen = 0;
+    if (payloadSize > 0 &&
+        EVP_DecryptUpdate(m_decryptCtx, body, &outLen, body, payloadSize) != 1) {
         utils::Logger::instance().error("解密失败");
-        return QByteArray();
+        return -1;
     }
     
-    return decrypted;
+    return payloadSize;
+}
+
+bool AudioEncryptor::acceptSequence(uint32_t sequence) {
+    if (!m_hasRemoteSequence) {
+        m_hasRemoteSequence = true;
+        m_remoteSequence = sequence;
+        m_replayWindow = 1;
+        ++m_receiveStats.received;
+        return true;
+    }
+
+    // 以32位有符号差值比较，正确处理序列号回绕
+    const int32_t delta = static_cast<int32_t>(sequence - m_remoteSequence);
+
+    if (delta > 0) {
+        // 新的最大序列号：窗口右移，中间空缺先记为丢失
+        const uint32_t advance = static_cast<uint32_t>(delta);
+        m_replayWindow = advance < REPLAY_WINDOW_SIZE ? (m_replayWindow << advance) | 1 : 1;
+        m_receiveStats.lost += advance - 1;
+        m_remoteSequence = sequence;
+        ++m_receiveStats.received;
+        return true;
+    }
+
+    const uint32_t offset = static_cast<uint32_t>(-static_cast<int64_t>(delta));
+    if (offset >= REPLAY_WINDOW_SIZE) {
+        ++m_receiveStats.late;
+        return false;
+    }
+
+    const quint64 bit = quint64(1) << offset;
+    if (m_replayWindow & bit) {
+        ++m_receiveStats.duplicated;
+        return false;
+    }
+
+    // 窗口内补到的乱序包：接受，并撤销之前记下的丢失
+    m_replayWindow |= bit;
+    ++m_receiveStats.reordered;
+    if (m_receiveStats.lost > 0) {
+        --m_receiveStats.lost;
+    }
+    ++m_receiveStats.received;
+    return true;
 }
 
 void AudioEncryptor::resetSequence() {
     m_localSequence = 0;
     m_remoteSequence = 0;
+    m_replayWindow = 0;
+    m_hasRemoteSequence = false;
+    m_receiveStats = ReceiveStats();
     utils::Logger::instance().info("序列号已重置");
 }
 
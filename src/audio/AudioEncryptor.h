@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T20:50:00Z
+Updated: 2026-10-16T14:00:00Z
 File: AudioEncryptor.h
 Desc: 音频数据AES-CTR加密/解密模块（严格对齐ESP32实现）
 */
@@ -36,6 +36,17 @@ struct AudioPacketHeader {
 };
 #pragma pack(pop)
 
+/**
+ * @brief 下行包序列统计（由防重放窗口维护，每个会话一份）
+ */
+struct ReceiveStats {
+    quint64 received = 0;       // 接受的包
+    quint64 lost = 0;           // 序列号空缺数（之后在窗口内补到的会扣除）
+    quint64 reordered = 0;      // 乱序到达但仍在窗口内（已接受）
+    quint64 duplicated = 0;     // 窗口内重复包（丢弃）
+    quint64 late = 0;           // 早于窗口的旧包（丢弃）
+};
+
 /**
  * @brief 音频加密器类
  * 
@@ -76,22 +87,68 @@ public:
                       uint32_t& timestamp, 
                       uint32_t& sequence);
 
+    /**
+     * @brief 加密音频数据并直接写入调用方提供的包缓冲（零分配）
+     *
+     * 包头即CTR IV，直接在out中构造；负载一次遍历加密到out+包头之后
+     * @param payload 原始音频数据（Opus编码后）
+     * @param payloadSize 音频数据长度
+     * @param timestamp 时间戳（毫秒）
+     * @param out 输出缓冲（包头 + 加密负载），不可与payload重叠
+     * @param capacity 输出缓冲容量，需不小于 packetSize(payloadSize)
+     * @return 写入的包长度，失败返回-1
+     */
+    int encryptInto(const char* payload, int payloadSize, uint32_t timestamp,
+                    char* out, int capacity);
+
+    /**
+     * @brief 在接收缓冲上原地解密UDP音频包（零分配）
+     * @param packet 加密的UDP包（包含包头），负载部分被就地替换为明文
+     * @param size 包长度
+     * @param timestamp 输出参数：解密后的时间戳
+     * @param sequence 输出参数：解密后的序列号
+     * @return 明文负载长度（负载起始于packet + sizeof(AudioPacketHeader)）；
+     *         被防重放窗口丢弃（重复/过旧）时返回0，包格式错误或解密失败返回-1
+     */
+    int decryptInPlace(char* packet, int size, uint32_t& timestamp, uint32_t& sequence);
+
+    /**
+     * @brief 给定负载长度对应的完整包长度
+     */
+    static constexpr int packetSize(int payloadSize) {
+        return static_cast<int>(sizeof(AudioPacketHeader)) + payloadSize;
+    }
+
     /**
      * @brief 获取当前本地序列号
      */
     uint32_t getLocalSequence() const { return m_localSequence; }
 
     /**
-     * @brief 获取远程序列号
+     * @brief 获取远程序列号（已接受的最大序列号）
      */
     uint32_t getRemoteSequence() const { return m_remoteSequence; }
 
+    /**
+     * @brief 下行包序列统计
+     */
+    const ReceiveStats& receiveStats() const { return m_receiveStats; }
+
+    // 防重放窗口大小（包），覆盖约3.8秒的60ms帧
+    static constexpr int REPLAY_WINDOW_SIZE = 64;
+
     /**
      * @brief 重置序列号
      */
     void resetSequence();
 
 private:
+    /**
+     * @brief 防重放/去重检查，接受时更新窗口与统计
+     * @return 包应被处理返回true，重复或早于窗口返回false
+     */
+    bool acceptSequence(uint32_t sequence);
+
     /**
      * @brief 十六进制字符串转字节数组
      */
@@ -113,7 +170,10 @@ private:
     QByteArray m_nonce;             // 随机数（16字节）
     
     uint32_t m_localSequence;       // 本地发送序列号
-    uint32_t m_remoteSequence;      // 远程接收序列号
+    uint32_t m_remoteSequence;      // 远程接收序列号（窗口右沿）
+    quint64 m_replayWindow;         // 位i表示序列号(m_remoteSequence - i)已收到
+    bool m_hasRemoteSequence;       // 是否已收到过下行包
+    ReceiveStats m_receiveStats;    // 下行包序列统计
     uint32_t m_ssrc;                // 同步源标识符
     
     bool m_initialized;             // 是否已初始化
@@ -3,15 +3,22 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T07:00:00Z
+Updated: 2026-10-17T16:30:00Z
 File: ConversationManager.cpp
 Desc: 对话状态机管理器实现（修复播放采样率不匹配问题）
 */
 
 #include "ConversationManager.h"
 #include "AudioTypes.h"
+#include "../network/NetworkThreadPool.h"
+#include "../utils/LatencyTracer.h"
 #include "../utils/Logger.h"
+#include "../utils/Config.h"
+#include <QDateTime>
+#include <QDir>
 #include <QJsonObject>
+#include <QRegularExpression>
+#include <QStandardPaths>
 
 namespace xiaozhi {
 namespace audio {
@@ -38,14 +45,8 @@ ConversationManager::ConversationManager(
     , m_isRecording(false)
     , m_isPlaying(false)
     , m_udpChannelOpened(false)
-    , m_targetFrameSize(0)
     , m_playbackBuffer(std::make_unique<QBuffer>())
 {
-    // 初始化Opus编码器（16kHz单声道，客户端发送给服务器）
-    if (!m_codec->initEncoder(16000, 1, 24000)) {
-        utils::Logger::instance().error(" Opus编码器初始化失败");
-    }
-
     //  修复：使用服务器参数初始化解码器（不要自动切换采样率！）
     // 服务器参数从hello消息中获取: serverSampleRate (通常是24000Hz)
     if (!m_codec->initDecoder(serverSampleRate, serverChannels)) {
@@ -63,13 +64,20 @@ ConversationManager::ConversationManager(
     
     // 已移除播放设备配置详情日志（敏感信息）
 
-    // 计算目标帧大小（字节）：样本数 * 声道数 * 每样本字节数
-    m_targetFrameSize = m_codec->getEncoderFrameSize() * 1 * 2;  // 960样本 * 1声道 * 2字节 = 1920字节
-
     // 保存服务器参数供外部读取
     m_serverSampleRate = serverSampleRate;
     m_serverChannels = serverChannels;
 
+    // 下行抖动缓冲（播放节奏由播放设备拉取驱动，不使用GUI线程定时器）
+    m_serverFrameDuration = serverFrameDuration > 0 ? serverFrameDuration : 60;
+    m_jitterBuffer = std::make_unique<JitterBuffer>(m_serverFrameDuration);
+    connect(m_audioDevice, &AudioDevice::playbackDataRequested,
+            this, &ConversationManager::onPlaybackDataRequested);
+    connect(m_audioDevice, &AudioDevice::playbackFinished,
+            this, &ConversationManager::onPlaybackFinished);
+    m_rxClock.start();
+    m_statsClock.start();
+
     // ConversationManager初始化完成
 
     // 连接UDP信号
@@ -77,14 +85,25 @@ ConversationManager::ConversationManager(
             this, &ConversationManager::onUdpConnected);
     connect(m_udpManager, &network::UdpManager::audioDataReceived,
             this, &ConversationManager::onUdpAudioReceived);
+    connect(m_udpManager, &network::UdpManager::receiveStatsUpdated,
+            this, [this](const QVariantMap& stats) {
+        m_packetStats = stats;
+        emit packetStatsChanged();
+    });
 
     // 连接MQTT信号
     connect(m_mqttManager, &network::MqttManager::messageReceived,
             this, &ConversationManager::onMqttMessageReceived);
 
-    // 连接录音信号
-    connect(m_audioDevice, &AudioDevice::audioReady,
-            this, &ConversationManager::onAudioReady);
+    // 上行音频工作者与UdpWorker同处UDP线程（实时音频线程），编码后直接加密发送
+    setupLatencyTracer();
+    setupCaptureWorker(m_udpManager->workerThread(), m_udpManager->worker());
+
+    // UdpWorker已在UDP线程中，追踪器按队列在该线程中设置
+    network::UdpWorker* udpWorker = m_udpManager->worker();
+    QMetaObject::invokeMethod(udpWorker, [udpWorker, tracer = m_latencyTracer]() {
+        udpWorker->setLatencyTracer(tracer);
+    }, Qt::QueuedConnection);
     
     // 初始化播放缓冲区
     m_playbackBuffer->open(QIODevice::ReadWrite);
@@ -111,14 +130,8 @@ ConversationManager::ConversationManager(
     , m_isRecording(false)
     , m_isPlaying(false)
     , m_udpChannelOpened(false)  // WebSocket模式下，此标志表示连接状态
-    , m_targetFrameSize(0)
     , m_playbackBuffer(std::make_unique<QBuffer>())
 {
-    // 初始化Opus编码器（16kHz单声道，客户端发送给服务器）
-    if (!m_codec->initEncoder(16000, 1, 24000)) {
-        utils::Logger::instance().error(" Opus编码器初始化失败");
-    }
-
     // 初始化Opus解码器（使用服务器参数）
     if (!m_codec->initDecoder(serverSampleRate, serverChannels)) {
         utils::Logger::instance().error(" Opus解码器初始化失败");
@@ -133,13 +146,22 @@ ConversationManager::ConversationManager(
     playbackConfig.sampleFormat = QAudioFormat::Int16;
     m_audioDevice->setAudioConfig(playbackConfig);
 
-    // 计算目标帧大小
-    m_targetFrameSize = m_codec->getEncoderFrameSize() * 1 * 2;
-
     // 保存服务器参数
     m_serverSampleRate = serverSampleRate;
     m_serverChannels = serverChannels;
 
+    // 下行抖动缓冲（播放节奏由播放设备拉取驱动，不使用GUI线程定时器）
+    // TCP保序不丢包，服务器整句快于实时下发时缓冲增长而不丢帧
+    m_serverFrameDuration = serverFrameDuration > 0 ? serverFrameDuration : 60;
+    m_jitterBuffer = std::make_unique<JitterBuffer>(m_serverFrameDuration);
+    m_jitterBuffer->setReliableTransport(true);
+    connect(m_audioDevice, &AudioDevice::playbackDataRequested,
+            this, &ConversationManager::onPlaybackDataRequested);
+    connect(m_audioDevice, &AudioDevice::playbackFinished,
+            this, &ConversationManager::onPlaybackFinished);
+    m_rxClock.start();
+    m_statsClock.start();
+
     // ConversationManager初始化完成（WebSocket模式）
 
     // 连接WebSocket信号
@@ -150,9 +172,15 @@ ConversationManager::ConversationManager(
     connect(m_websocketManager, &network::WebSocketManager::jsonMessageReceived,
             this, &ConversationManager::onWebSocketJsonReceived);
 
-    // 连接录音信号
-    connect(m_audioDevice, &AudioDevice::audioReady,
-            this, &ConversationManager::onAudioReady);
+    // 上行音频工作者与WebSocketWorker同处网络音频线程，编码后直接封包发送
+    setupLatencyTracer();
+    setupCaptureWorker(m_websocketManager->workerThread(), nullptr, m_websocketManager->worker());
+
+    // WebSocketWorker已在网络线程中，追踪器按队列在该线程中设置
+    network::WebSocketWorker* wsWorker = m_websocketManager->worker();
+    QMetaObject::invokeMethod(wsWorker, [wsWorker, tracer = m_latencyTracer]() {
+        wsWorker->setLatencyTracer(tracer);
+    }, Qt::QueuedConnection);
 
     // 初始化播放缓冲区
     m_playbackBuffer->open(QIODevice::ReadWrite);
@@ -167,6 +195,75 @@ ConversationManager::ConversationManager(
 ConversationManager::~ConversationManager() {
     stopRecording();
     closeAudioChannel();
+    shutdownCaptureWorker();
+
+    // 启用追踪时会话结束自动导出到应用数据目录（工作目录可能不可写，也不应被写入）
+    if (m_latencyTracer && m_latencyTracer->isEnabled()) {
+        const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                              + "/latency-traces";
+        QString name = m_sessionId;
+        name.replace(QRegularExpression("[^A-Za-z0-9_-]"), "_");
+        const QString path = QString("%1/latency-trace-%2-%3.json")
+                                 .arg(dirPath, name, QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+        if (QDir().mkpath(dirPath) && exportLatencyTrace(path)) {
+            utils::Logger::instance().info(QString("延迟追踪已导出: %1").arg(path));
+        } else {
+            utils::Logger::instance().warn(QString("延迟追踪导出失败: %1").arg(path));
+        }
+    }
+}
+
+void ConversationManager::setupLatencyTracer() {
+    m_latencyTracer = std::make_shared<utils::LatencyTracer>(m_sessionId);
+    m_latencyTracer->setEnabled(utils::Config::instance().isLatencyTraceEnabled());
+}
+
+void ConversationManager::setupCaptureWorker(QThread* thread, network::UdpWorker* udpWorker,
+                                             network::WebSocketWorker* wsWorker) {
+    m_captureWorker = new AudioCaptureWorker();
+
+    // 编码器参数在GUI线程读取配置后注入，音频线程中不访问Config
+    const bool inbandFec = utils::Config::instance().isOpusInbandFecEnabled();
+    if (!m_captureWorker->initEncoder(inbandFec, utils::Config::instance().getOpusPacketLossPercent())) {
+        utils::Logger::instance().error(" Opus编码器初始化失败");
+    }
+    m_captureWorker->setUdpWorker(udpWorker);
+    m_captureWorker->setWebSocketWorker(wsWorker);
+    m_captureWorker->setLatencyTracer(m_latencyTracer);
+    m_captureWorker->moveToThread(thread);
+    // 与传输工作者同线程，同样计入该线程负载
+    network::NetworkThreadPool::instance().share(thread);
+
+    connect(m_captureWorker, &AudioCaptureWorker::captureFailed,
+            this, &ConversationManager::onCaptureFailed);
+}
+
+void ConversationManager::setPcmSourceFactory(PcmSourceFactory factory) {
+    // 工作者位于音频线程，按队列顺序在后续start之前生效
+    AudioCaptureWorker* worker = m_captureWorker;
+    QMetaObject::invokeMethod(worker, [worker, factory = std::move(factory)]() mutable {
+        worker->setPcmSourceFactory(std::move(factory));
+    }, Qt::QueuedConnection);
+}
+
+QVariantMap ConversationManager::latencyStats() const {
+    return m_latencyTracer ? m_latencyTracer->stats() : QVariantMap();
+}
+
+bool ConversationManager::exportLatencyTrace(const QString& path) const {
+    return m_latencyTracer && m_latencyTracer->exportChromeTrace(path);
+}
+
+void ConversationManager::shutdownCaptureWorker() {
+    if (!m_captureWorker) {
+        return;
+    }
+
+    // 在音频线程中销毁（析构时停止采集，QAudioSource归属音频线程）。
+    // 先于传输工作者retire，同线程按投递顺序删除，采集工作者不会看到已销毁的传输工作者
+    AudioCaptureWorker* worker = m_captureWorker;
+    m_captureWorker = nullptr;
+    network::NetworkThreadPool::instance().retire(worker);
 }
 
 // ========== 对话控制 ==========
@@ -202,11 +299,8 @@ void ConversationManager::startConversation() {
 
     utils::Logger::instance().info(" 开始对话");
 
-    // 开始录音
-    if (!m_audioDevice->startRecording()) {
-        emit errorOccurred("开始录音失败");
-        return;
-    }
+    // 开始录音（在音频线程中创建采集设备，失败时经onCaptureFailed回退状态）
+    QMetaObject::invokeMethod(m_captureWorker, &AudioCaptureWorker::start, Qt::QueuedConnection);
 
     m_isRecording = true;
     emit isRecordingChanged(true);
@@ -237,15 +331,13 @@ void ConversationManager::stopRecording() {
     }
 
     utils::Logger::instance().info("⏹️ 停止录音");
+    m_latencyTracer->markTurn(utils::TurnPoint::ListenStop);
 
-    // 停止录音
-    m_audioDevice->stopRecording();
+    // 停止录音（音频线程中丢弃未满一帧的数据）
+    QMetaObject::invokeMethod(m_captureWorker, &AudioCaptureWorker::stop, Qt::QueuedConnection);
     m_isRecording = false;
     emit isRecordingChanged(false);
 
-    // 清空PCM缓冲区
-    m_pcmBuffer.clear();
-
     // 发送stop listening消息
     if (m_protocolType == ProtocolType::WebSocket) {
         m_websocketManager->sendStopListening();
@@ -265,7 +357,9 @@ void ConversationManager::abortSpeaking() {
 
     utils::Logger::instance().info("⏸️ 中止说话");
 
-    // 停止播放
+    // 丢弃尚未播放的缓冲帧并停止播放
+    m_playbackDraining = false;
+    stopPlayout();
     m_audioDevice->stopPlayback();
     m_isPlaying = false;
     emit isPlayingChanged(false);
@@ -286,6 +380,8 @@ void ConversationManager::closeAudioChannel() {
 
     // 停止录音和播放
     stopRecording();
+    m_playbackDraining = false;
+    stopPlayout();
     if (m_isPlaying) {
         m_audioDevice->stopPlayback();
         m_isPlaying = false;
@@ -319,10 +415,9 @@ void ConversationManager::switchToSpeaking() {
 
         // 停止录音（但不关闭UDP）
         if (m_isRecording) {
-            m_audioDevice->stopRecording();
+            QMetaObject::invokeMethod(m_captureWorker, &AudioCaptureWorker::stop, Qt::QueuedConnection);
             m_isRecording = false;
             emit isRecordingChanged(false);
-            m_pcmBuffer.clear();
         }
     }
 }
@@ -337,63 +432,195 @@ void ConversationManager::switchToIdle() {
 
 // ========== 音频处理 ==========
 
-void ConversationManager::onAudioReady(const QByteArray& pcm_data) {
-    if (!m_isRecording || m_state != ConversationState::Listening) {
+void ConversationManager::onCaptureFailed(const QString& error) {
+    utils::Logger::instance().error(QString(" 录音失败: %1").arg(error));
+    // 回退录音状态并通知服务器停止聆听
+    stopRecording();
+    emit errorOccurred("开始录音失败");
+}
+
+void ConversationManager::onUdpAudioReceived(const QByteArray& opus_data, quint32 sequence) {
+    if (m_state != ConversationState::Speaking) {
+        // 不在说话状态，忽略收到的音频
         return;
     }
 
-    // 累积PCM数据到缓冲区
-    m_pcmBuffer.append(pcm_data);
+    // 经抖动缓冲重排/去重后按播放设备需求解码，不再收到即播
+    enqueueReceivedAudio(sequence, OpusPacket(opus_data));
+}
 
-    // 当缓冲区达到一帧大小时，编码并发送
-    while (m_pcmBuffer.size() >= m_targetFrameSize) {
-        // 提取一帧
-        QByteArray frame = m_pcmBuffer.left(m_targetFrameSize);
-        m_pcmBuffer.remove(0, m_targetFrameSize);
+void ConversationManager::enqueueReceivedAudio(quint32 sequence, const OpusPacket& packet) {
+    if (m_jitterBuffer->push(sequence, packet, m_rxClock.elapsed())) {
+        m_latencyTracer->markDownlink(sequence, utils::TracePoint::Enqueued);
+    }
 
-        // 编码并发送
-        sendEncodedAudio(frame);
+    // 上一轮正在排空时又来了新音频：继续播放，不结束本轮
+    if (m_playbackDraining) {
+        m_playbackDraining = false;
+        m_audioDevice->cancelDrain();
     }
+
+    // 预缓冲阶段每到一个包检查一次，达到目标深度立即开播
+    fillPlayout();
 }
 
-void ConversationManager::sendEncodedAudio(const QByteArray& pcm_data) {
-    // Opus编码
-    QByteArray opus_data = m_codec->encode(pcm_data);
-    if (opus_data.isEmpty()) {
-        utils::Logger::instance().error(" Opus编码失败");
-        return;
+void ConversationManager::onPlaybackDataRequested() {
+    fillPlayout();
+}
+
+void ConversationManager::fillPlayout() {
+    // 播放设备中已解码的数据即播放时钟：低于提前量才出队，
+    // 缺包在此刻判定为丢失并补偿，GUI线程短暂卡顿由提前量吸收
+    const qint64 leadBytes = static_cast<qint64>(m_serverSampleRate) * m_serverChannels * 2
+                           * m_serverFrameDuration * PLAYOUT_LEAD_FRAMES / 1000;
+    OpusPacket packet;
+    while (!m_isPlaying || m_audioDevice->pendingPlaybackBytes() < leadBytes) {
+        const JitterBuffer::PopResult result = m_jitterBuffer->pop(packet);
+        if (result == JitterBuffer::PopResult::Empty) {
+            break;  // 预缓冲中或欠载：等待新包到达
+        }
+        playJitterFrame(result, packet);
     }
 
-    // 根据协议类型发送
-    if (m_protocolType == ProtocolType::WebSocket) {
-        // WebSocket发送
-        m_websocketManager->sendAudioData(opus_data);
+    // 设备消耗到提前量以下时再通知（一次性，每次补充后重新请求）
+    if (m_isPlaying && !m_playbackDraining) {
+        m_audioDevice->requestPlaybackData(leadBytes);
+    }
+
+    if (m_statsClock.elapsed() >= 1000) {
+        m_statsClock.restart();
+        emit jitterStatsChanged();
+    }
+}
+
+void ConversationManager::playJitterFrame(JitterBuffer::PopResult result, const OpusPacket& packet) {
+    if (result == JitterBuffer::PopResult::Packet) {
+        receiveDecodedAudio(packet.payload());
+    } else if (result == JitterBuffer::PopResult::Missing) {
+        concealMissingFrame();
+    }
+}
+
+void ConversationManager::concealMissingFrame() {
+    const opus_int16* pcm = nullptr;
+    int samples = 0;
+
+    // 下一包已在缓冲中：用其携带的FEC冗余恢复本帧（无FEC时libopus退化为PLC）
+    // 否则只能靠PLC外推
+    if (const OpusPacket* next = m_jitterBuffer->peekNext()) {
+        const QByteArrayView payload = next->payload();
+        samples = m_codec->decodeFec(
+            reinterpret_cast<const unsigned char*>(payload.data()),
+            payload.size(),
+            &pcm
+        );
     } else {
-        // UDP发送（加密在UdpManager中完成）
-        m_udpManager->sendAudioData(opus_data);
+        samples = m_codec->decodeLost(&pcm);
     }
+
+    if (samples > 0) {
+        playDecodedPcm(pcm, samples);
+    }
+}
+
+void ConversationManager::flushJitterBuffer() {
+    OpusPacket packet;
+    JitterBuffer::PopResult result;
+    while ((result = m_jitterBuffer->pop(packet, true)) != JitterBuffer::PopResult::Empty) {
+        playJitterFrame(result, packet);
+    }
+}
+
+void ConversationManager::stopPlayout() {
+    m_jitterBuffer->reset();
+    emit jitterStatsChanged();
 }
 
-void ConversationManager::onUdpAudioReceived(const QByteArray& opus_data) {
+void ConversationManager::onPlaybackFinished() {
+    // 播放设备为多个会话共享，只处理本会话发起的排空
+    if (!m_playbackDraining) {
+        return;
+    }
+    m_playbackDraining = false;
+    finishSpeakingTurn();
+}
+
+void ConversationManager::finishSpeakingTurn() {
+    if (m_isPlaying) {
+        m_isPlaying = false;
+        emit isPlayingChanged(false);
+    }
+    m_playbackBuffer->close();
+    m_playbackBuffer->buffer().clear();
+    m_playbackBuffer->open(QIODevice::ReadWrite);
+    emit jitterStatsChanged();
+
+    // 排空期间用户已开始新一轮对话时不再切换状态
     if (m_state != ConversationState::Speaking) {
-        // 不在说话状态，忽略收到的音频
         return;
     }
 
-    receiveDecodedAudio(opus_data);
+    // 如果在auto模式，自动切回聆听并开始录音
+    if (m_mode == ConversationMode::Auto) {
+        switchToListening();
+        if (!m_isRecording) {
+            startConversation();
+        }
+    } else {
+        // manual模式，切换到空闲
+        switchToIdle();
+    }
 }
 
-void ConversationManager::receiveDecodedAudio(const QByteArray& opus_data) {
-    //  直接按 Opus 帧解码（UDP负载即为纯Opus数据，无需再剥离任何头部）
-    QByteArray pcm_data = m_codec->decode(opus_data);
+QVariantMap ConversationManager::jitterStats() const {
+    const JitterBufferStats s = m_jitterBuffer->stats();
+    QVariantMap map;
+    map["depth"] = s.depth;
+    map["targetDepth"] = s.targetDepth;
+    map["jitterMs"] = s.jitterMs;
+    map["received"] = s.received;
+    map["played"] = s.played;
+    map["late"] = s.late;
+    map["lost"] = s.lost;
+    map["duplicated"] = s.duplicated;
+    map["overflowDropped"] = s.overflowDropped;
+    map["peakDepth"] = s.peakDepth;
+    map["underruns"] = s.underruns;
+    return map;
+}
+
+void ConversationManager::receiveDecodedAudio(QByteArrayView opus_data) {
+    //  直接按 Opus 帧解码（视图指向收到的消息内部，协议包头已在网络线程中跳过）
+    //  解码输出位于编解码器内部复用缓冲区，下一次解码前有效
+    const opus_int16* pcm = nullptr;
+    int decoded_samples = m_codec->decode(
+        reinterpret_cast<const unsigned char*>(opus_data.data()),
+        opus_data.size(),
+        &pcm
+    );
     
-    // 如果解码失败，直接跳过这个包（可能是网络包损坏）
-    if (pcm_data.isEmpty()) {
-        return;
+    // 如果解码失败，用PLC填补这一帧，保持播放连续（避免欠载）
+    if (decoded_samples <= 0) {
+        decoded_samples = m_codec->decodeLost(&pcm);
+        if (decoded_samples <= 0) {
+            return;
+        }
     }
 
+    // 仅由抖动缓冲出队Packet时调用，lastSequence即本帧序列号
+    const quint32 sequence = m_jitterBuffer->lastSequence();
+    m_latencyTracer->markDownlink(sequence, utils::TracePoint::Decoded);
+    playDecodedPcm(pcm, decoded_samples);
+    m_latencyTracer->markDownlink(sequence, utils::TracePoint::SinkWritten);
+}
+
+void ConversationManager::playDecodedPcm(const opus_int16* pcm, int samples) {
+    // 零拷贝包装解码结果（仅在本函数内使用，下游append时才真正拷贝）
+    const QByteArray pcm_data = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(pcm), samples * m_serverChannels * 2);
+
     // 新增：累积TTS音频数据
-    if (m_isTtsAccumulating && !pcm_data.isEmpty()) {
+    if (m_isTtsAccumulating) {
         m_currentTtsPcm.append(pcm_data);
     }
 
@@ -421,6 +648,7 @@ void ConversationManager::onMqttMessageReceived(const QJsonObject& message) {
         bool isFinal = message["is_final"].toBool(false);
         
         utils::Logger::instance().info(QString("📝 STT: %1 (final=%2)").arg(text).arg(isFinal));
+        m_latencyTracer->markTurn(utils::TurnPoint::Stt);
         emit sttTextReceived(text);
         
         // 修改：即使is_final为false也保存STT消息，因为服务器可能不发送final=true
@@ -438,19 +666,25 @@ void ConversationManager::onMqttMessageReceived(const QJsonObject& message) {
         emit ttsTextReceived(text);
 
         if (state == "start" || state == "sentence_start") {
+            m_latencyTracer->markTurn(utils::TurnPoint::TtsStart);
+
             // TTS开始：初始化累积
             m_currentTtsText = text;
             m_currentTtsPcm.clear();
             m_currentTtsStartTime = QDateTime::currentMSecsSinceEpoch();
             m_isTtsAccumulating = true;
-            
+
+            // 上一句尚在缓冲中的音频先播完，再为新的音频流重建序列基准
+            flushJitterBuffer();
+            m_jitterBuffer->reset();
             m_codec->resetDecoderState();
             
             // 立即发射消息开始信号，让UI显示文字（音频在后台继续播放）
             emit ttsMessageStarted(m_currentTtsText, m_currentTtsStartTime);
         }
         else if (state == "end" || state == "sentence_end" || state == "stop") {
-            // TTS结束：保存完整消息
+            // TTS结束：缓冲中剩余的音频计入本条消息后再保存
+            flushJitterBuffer();
             m_isTtsAccumulating = false;
             
             // 通知DeviceSession保存消息（携带累积的PCM数据）
@@ -474,27 +708,15 @@ void ConversationManager::onMqttMessageReceived(const QJsonObject& message) {
         QString action = message["action"].toString();
         
         if (action == "audio_end") {
-            // 服务器音频发送完毕，切回聆听
-            // 服务器音频发送完毕
-            
-            if (m_isPlaying) {
-                m_audioDevice->stopPlayback();
-                m_playbackBuffer->close();
-                m_playbackBuffer->buffer().clear();
-                m_playbackBuffer->open(QIODevice::ReadWrite);
-                m_isPlaying = false;
-                emit isPlayingChanged(false);
-            }
+            // 服务器音频发送完毕：缓冲中剩余的帧照常播完，播放设备排空后再切回聆听/空闲
+            flushJitterBuffer();
+            m_jitterBuffer->reset();
 
-            // 如果在auto模式，自动切回聆听并开始录音
-            if (m_mode == ConversationMode::Auto) {
-                switchToListening();
-                if (!m_isRecording) {
-                    startConversation();
-                }
+            if (m_isPlaying) {
+                m_playbackDraining = true;
+                m_audioDevice->drainPlayback();  // 完成后经onPlaybackFinished结束本轮
             } else {
-                // manual模式，切换到空闲
-                switchToIdle();
+                finishSpeakingTurn();
             }
         }
     }
@@ -514,9 +736,12 @@ void ConversationManager::onWebSocketConnected() {
     // WebSocket音频通道已开启
 }
 
-void ConversationManager::onWebSocketAudioReceived(const QByteArray& opus_data) {
-    // 与UDP模式相同的处理逻辑
-    receiveDecodedAudio(opus_data);
+void ConversationManager::onWebSocketAudioReceived(const QByteArray& message, qsizetype offset, qsizetype size) {
+    // 与UDP模式相同的处理逻辑（TCP保序，按到达顺序编号入抖动缓冲）
+    // 抖动缓冲只持有原消息的引用，解码时直接读取其中的负载
+    const quint32 sequence = m_wsRxSequence++;
+    m_latencyTracer->markDownlink(sequence, utils::TracePoint::Received);
+    enqueueReceivedAudio(sequence, OpusPacket(message, offset, size));
 }
 
 void ConversationManager::onWebSocketJsonReceived(const QString& jsonData) {
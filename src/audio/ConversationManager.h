@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T22:30:00Z
+Updated: 2026-10-17T16:30:00Z
 File: ConversationManager.h
 Desc: 对话状态机管理器（支持auto/manual/realtime三种模式）
 */
@@ -12,13 +12,19 @@ Desc: 对话状态机管理器（支持auto/manual/realtime三种模式）
 #define CONVERSATION_MANAGER_H
 
 #include "AudioDevice.h"
+#include "AudioCaptureWorker.h"
 #include "OpusCodec.h"
+#include "JitterBuffer.h"
 #include "../network/MqttManager.h"
 #include "../network/UdpManager.h"
 #include "../network/WebSocketManager.h"
 #include <QObject>
 #include <QString>
 #include <QBuffer>
+#include <QTimer>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QVariantMap>
 #include <memory>
 
 namespace xiaozhi {
@@ -69,6 +75,8 @@ class ConversationManager : public QObject {
     Q_PROPERTY(bool isRecording READ isRecording NOTIFY isRecordingChanged)
     Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged)
     Q_PROPERTY(bool udpChannelOpened READ udpChannelOpened NOTIFY udpChannelOpenedChanged)
+    Q_PROPERTY(QVariantMap jitterStats READ jitterStats NOTIFY jitterStatsChanged)
+    Q_PROPERTY(QVariantMap packetStats READ packetStats NOTIFY packetStatsChanged)
 
 public:
     /**
@@ -112,6 +120,31 @@ public:
     int serverSampleRate() const { return m_serverSampleRate; }
     int serverChannels() const { return m_serverChannels; }
 
+    /**
+     * @brief 下行抖动缓冲统计（depth/targetDepth/jitterMs/late/lost/duplicated等）
+     */
+    QVariantMap jitterStats() const;
+
+    /**
+     * @brief 下行UDP包序列统计（received/lost/reordered/duplicated/late，来自防重放窗口）
+     */
+    QVariantMap packetStats() const { return m_packetStats; }
+
+    /**
+     * @brief 替换上行采集数据源（无头压测用合成/文件PCM，为空恢复麦克风）
+     */
+    void setPcmSourceFactory(PcmSourceFactory factory);
+
+    /**
+     * @brief 端到端延迟统计（各阶段count/meanUs/p50Us/p90Us/p99Us/maxUs，需启用Debug/latencyTrace）
+     */
+    Q_INVOKABLE QVariantMap latencyStats() const;
+
+    /**
+     * @brief 导出本会话的Chrome trace（chrome://tracing或Perfetto打开）
+     */
+    Q_INVOKABLE bool exportLatencyTrace(const QString& path) const;
+
     // ========== QML可调用方法 ==========
 
     /**
@@ -165,6 +198,16 @@ signals:
      */
     void udpChannelOpenedChanged(bool opened);
 
+    /**
+     * @brief 抖动缓冲统计更新（播放期间约每秒一次）
+     */
+    void jitterStatsChanged();
+
+    /**
+     * @brief 下行包序列统计更新（收包期间约每秒一次）
+     */
+    void packetStatsChanged();
+
     /**
      * @brief 收到STT文本
      */
@@ -203,13 +246,15 @@ private slots:
 
     /**
      * @brief 收到UDP音频数据
+     * @param opus_data Opus数据
+     * @param sequence 包头序列号（用于抖动缓冲重排/丢包检测）
      */
-    void onUdpAudioReceived(const QByteArray& opus_data);
+    void onUdpAudioReceived(const QByteArray& opus_data, quint32 sequence);
 
     /**
-     * @brief 录音设备数据就绪
+     * @brief 音频线程录音启动失败
      */
-    void onAudioReady(const QByteArray& pcm_data);
+    void onCaptureFailed(const QString& error);
 
     /**
      * @brief 收到MQTT消息
@@ -223,14 +268,27 @@ private slots:
 
     /**
      * @brief 收到WebSocket音频数据
+     * @param message 收到的原始二进制消息（隐式共享）
+     * @param offset Opus负载在message中的偏移
+     * @param size Opus负载长度
      */
-    void onWebSocketAudioReceived(const QByteArray& opus_data);
+    void onWebSocketAudioReceived(const QByteArray& message, qsizetype offset, qsizetype size);
 
     /**
      * @brief 收到WebSocket JSON消息
      */
     void onWebSocketJsonReceived(const QString& jsonData);
 
+    /**
+     * @brief 播放设备待播放数据低于提前量：继续从抖动缓冲取帧解码
+     */
+    void onPlaybackDataRequested();
+
+    /**
+     * @brief 播放设备排空完成（audio_end之后）
+     */
+    void onPlaybackFinished();
+
 private:
     /**
      * @brief 切换到聆听状态
@@ -248,14 +306,68 @@ private:
     void switchToIdle();
 
     /**
-     * @brief 发送编码加密后的音频数据
+     * @brief 创建上行音频工作者并移入指定的音频线程
+     * @param thread 音频线程（传输工作者所在的网络音频线程）
+     * @param udpWorker 同线程直接发送的UDP工作者（WebSocket模式为nullptr）
+     * @param wsWorker 同线程直接发送的WebSocket工作者（UDP模式为nullptr）
+     */
+    void setupCaptureWorker(QThread* thread, network::UdpWorker* udpWorker,
+                            network::WebSocketWorker* wsWorker = nullptr);
+
+    /**
+     * @brief 在音频线程中停止并销毁上行音频工作者（经NetworkThreadPool::retire，不等待）
+     */
+    void shutdownCaptureWorker();
+
+    /**
+     * @brief 按配置创建延迟追踪器（在创建上行音频工作者之前调用）
      */
-    void sendEncodedAudio(const QByteArray& pcm_data);
+    void setupLatencyTracer();
 
     /**
      * @brief 接收解密解码后的音频数据
      */
-    void receiveDecodedAudio(const QByteArray& opus_data);
+    void receiveDecodedAudio(QByteArrayView opus_data);
+
+    /**
+     * @brief 下行音频入抖动缓冲，并按需补充播放设备
+     */
+    void enqueueReceivedAudio(quint32 sequence, const OpusPacket& packet);
+
+    /**
+     * @brief 从抖动缓冲出队解码，直到播放设备中有PLAYOUT_LEAD_FRAMES帧提前量
+     */
+    void fillPlayout();
+
+    /**
+     * @brief 处理抖动缓冲出队结果（解码或补偿）
+     */
+    void playJitterFrame(JitterBuffer::PopResult result, const OpusPacket& packet);
+
+    /**
+     * @brief 丢包补偿：下一包已到时用其带内FEC恢复，否则PLC
+     */
+    void concealMissingFrame();
+
+    /**
+     * @brief 冲刷抖动缓冲：立即解码剩余帧（TTS分句结束时保证音频完整）
+     */
+    void flushJitterBuffer();
+
+    /**
+     * @brief 丢弃抖动缓冲中的帧（中止/关闭通道时）
+     */
+    void stopPlayout();
+
+    /**
+     * @brief 本轮播放结束：切回聆听（auto）或空闲（manual）
+     */
+    void finishSpeakingTurn();
+
+    /**
+     * @brief 累积TTS并写入播放设备（pcm指向解码器复用缓冲区）
+     */
+    void playDecodedPcm(const opus_int16* pcm, int samples);
 
     // 协议类型
     ProtocolType m_protocolType;
@@ -281,9 +393,8 @@ private:
     bool m_isPlaying;
     bool m_udpChannelOpened;
     
-    // PCM缓冲区（用于累积到一帧）
-    QByteArray m_pcmBuffer;
-    int m_targetFrameSize;  // 目标帧大小（字节）
+    // 上行音频：采集→分帧→编码→发送全部在高优先级音频线程中进行
+    AudioCaptureWorker* m_captureWorker = nullptr;  // 生命周期由shutdownCaptureWorker管理（与传输工作者同线程）
     
     // 播放缓冲区
     std::unique_ptr<QBuffer> m_playbackBuffer;
@@ -294,6 +405,17 @@ private:
     qint64 m_currentTtsStartTime;       // TTS开始时间
     bool m_isTtsAccumulating = false;   // 是否正在累积TTS
 
+    // 下行抖动缓冲（按包头序列号重排，播放设备拉取驱动出队）
+    std::unique_ptr<JitterBuffer> m_jitterBuffer;
+    QElapsedTimer m_rxClock;            // 到达时间基准（抖动估计）
+    QElapsedTimer m_statsClock;         // 统计通知节流
+    bool m_playbackDraining = false;    // audio_end后等待播放设备排空
+    quint32 m_wsRxSequence = 0;         // WebSocket下行合成序列号（TCP保序，按到达顺序编号）
+    int m_serverFrameDuration = 60;     // 服务器帧时长（ms）
+    QVariantMap m_packetStats;          // 下行UDP包序列统计（UDP线程定期推送）
+    std::shared_ptr<utils::LatencyTracer> m_latencyTracer;  // 端到端延迟追踪（与音频/UDP线程共享）
+    static constexpr int PLAYOUT_LEAD_FRAMES = 3;  // 提前解码写入播放设备的帧数，吸收GUI线程调度抖动
+
     // 服务器音频参数（用于外部持久化）
     int m_serverSampleRate = 24000;
     int m_serverChannels = 1;
@@ -0,0 +1,175 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T16:30:00Z
+File: JitterBuffer.cpp
+Desc: 自适应抖动缓冲实现
+*/
+
+#include "JitterBuffer.h"
+#include <QtMath>
+#include <cstdlib>
+
+namespace xiaozhi {
+namespace audio {
+
+namespace {
+constexpr int JITTER_DEPTH_FACTOR = 3;      // 目标深度覆盖约3倍抖动
+constexpr int HARD_LIMIT_MS = 3000;         // 不可靠传输的缓冲上限（毫秒），防止积压导致延迟无限增长
+}
+
+JitterBuffer::JitterBuffer(int frameDurationMs, int minDepth, int maxDepth)
+    : m_frameDurationMs(frameDurationMs > 0 ? frameDurationMs : 60)
+    , m_minDepth(qMax(1, minDepth))
+    , m_maxDepth(qMax(m_minDepth, maxDepth))
+    , m_hardLimit(0)
+    , m_reliable(false)
+    , m_targetDepth(m_minDepth)
+    , m_hasReference(false)
+    , m_lastExtSequence(0)
+    , m_started(false)
+    , m_hasPlayPosition(false)
+    , m_nextPlay(0)
+    , m_hasTransit(false)
+    , m_prevTransitMs(0)
+    , m_jitterMs(0.0)
+{
+    m_hardLimit = qMax(m_maxDepth * 2, HARD_LIMIT_MS / m_frameDurationMs);
+}
+
+void JitterBuffer::reset() {
+    m_packets.clear();
+    m_hasReference = false;
+    m_lastExtSequence = 0;
+    m_started = false;
+    m_hasPlayPosition = false;
+    m_nextPlay = 0;
+    m_hasTransit = false;
+    m_prevTransitMs = 0;
+    // 抖动估计与目标深度保留：新音频流通常仍走同一条网络路径
+}
+
+qint64 JitterBuffer::unwrap(quint32 sequence) {
+    if (!m_hasReference) {
+        m_hasReference = true;
+        m_lastExtSequence = sequence;
+        return m_lastExtSequence;
+    }
+
+    // 以最近序列号为基准，按32位有符号差值展开（正确处理回绕）
+    const qint32 delta = static_cast<qint32>(sequence - static_cast<quint32>(m_lastExtSequence));
+    const qint64 ext = m_lastExtSequence + delta;
+    if (ext > m_lastExtSequence) {
+        m_lastExtSequence = ext;
+    }
+    return ext;
+}
+
+void JitterBuffer::updateJitter(qint64 extSequence, qint64 arrivalMs) {
+    // 传输时间 = 到达时间 - 媒体时间（序列号 × 帧时长），常量偏移不影响差值
+    const qint64 transit = arrivalMs - extSequence * m_frameDurationMs;
+    if (m_hasTransit) {
+        const double d = static_cast<double>(std::llabs(transit - m_prevTransitMs));
+        m_jitterMs += (d - m_jitterMs) / 16.0;
+    }
+    m_prevTransitMs = transit;
+    m_hasTransit = true;
+
+    const int depth = 1 + qCeil(JITTER_DEPTH_FACTOR * m_jitterMs / m_frameDurationMs);
+    m_targetDepth = qBound(m_minDepth, depth, m_maxDepth);
+}
+
+bool JitterBuffer::push(quint32 sequence, const OpusPacket& packet, qint64 arrivalMs) {
+    qint64 ext = unwrap(sequence);
+
+    if (m_hasPlayPosition) {
+        if (ext < m_nextPlay) {
+            // 播放点已越过该位置（已播放或已补偿）
+            ++m_stats.late;
+            return false;
+        }
+        if (!m_reliable && ext - m_nextPlay > m_hardLimit) {
+            // 序列号大幅跳跃（服务器重置序列），视为新音频流
+            reset();
+            ext = unwrap(sequence);
+        }
+    }
+
+    if (m_packets.count(ext) != 0) {
+        ++m_stats.duplicated;
+        return false;
+    }
+
+    updateJitter(ext, arrivalMs);
+    m_packets.emplace(ext, packet);
+    ++m_stats.received;
+
+    // 不可靠传输超过上限时丢弃最旧的帧，限制端到端延迟
+    // 可靠传输的积压来自服务器突发下发，丢弃会截断语句，保留全部帧
+    while (!m_reliable && static_cast<int>(m_packets.size()) > m_hardLimit) {
+        m_packets.erase(m_packets.begin());
+        ++m_stats.overflowDropped;
+        if (m_hasPlayPosition) {
+            m_nextPlay = m_packets.begin()->first;
+        }
+    }
+    m_stats.peakDepth = qMax(m_stats.peakDepth, static_cast<int>(m_packets.size()));
+    return true;
+}
+
+JitterBuffer::PopResult JitterBuffer::pop(OpusPacket& packet, bool flushing) {
+    if (m_packets.empty()) {
+        if (m_started && !flushing) {
+            ++m_stats.underruns;
+        }
+        // 缓冲耗尽：重新预缓冲
+        m_started = false;
+        return PopResult::Empty;
+    }
+
+    if (!m_started) {
+        if (!flushing && static_cast<int>(m_packets.size()) < m_targetDepth) {
+            return PopResult::Empty;
+        }
+        // 预缓冲完成：从最早的包开始播放，跳过的空洞计为丢失
+        const qint64 first = m_packets.begin()->first;
+        if (m_hasPlayPosition && first > m_nextPlay) {
+            m_stats.lost += static_cast<quint64>(first - m_nextPlay);
+        }
+        m_nextPlay = first;
+        m_hasPlayPosition = true;
+        m_started = true;
+    }
+
+    auto it = m_packets.begin();
+    if (it->first == m_nextPlay) {
+        packet = std::move(it->second);
+        m_packets.erase(it);
+        ++m_nextPlay;
+        ++m_stats.played;
+        return PopResult::Packet;
+    }
+
+    // 当前位置缺包（后续包已到），由调用方补偿
+    ++m_nextPlay;
+    ++m_stats.lost;
+    return PopResult::Missing;
+}
+
+const OpusPacket* JitterBuffer::peekNext() const {
+    auto it = m_packets.find(m_nextPlay);
+    return it != m_packets.end() ? &it->second : nullptr;
+}
+
+JitterBufferStats JitterBuffer::stats() const {
+    JitterBufferStats s = m_stats;
+    s.depth = static_cast<int>(m_packets.size());
+    s.targetDepth = m_targetDepth;
+    s.jitterMs = m_jitterMs;
+    return s;
+}
+
+} // namespace audio
+} // namespace xiaozhi
@@ -0,0 +1,187 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T16:30:00Z
+File: JitterBuffer.h
+Desc: 自适应抖动缓冲（按序列号重排/去重，根据到达抖动调整缓冲深度）
+*/
+
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QtGlobal>
+#include <map>
+
+namespace xiaozhi {
+namespace audio {
+
+/**
+ * @brief 下行Opus包（以偏移/长度引用收到的原始消息，不拷贝负载）
+ *
+ * WebSocket v2/v3消息带协议包头，负载直接引用隐式共享的原消息，
+ * 从套接字到解码器不再拷出；UDP负载已单独成块，offset为0
+ */
+struct OpusPacket {
+    QByteArray message;     // 收到的原始消息（隐式共享）
+    qsizetype offset = 0;   // 负载在message中的偏移
+    qsizetype size = 0;     // 负载长度
+
+    OpusPacket() = default;
+    explicit OpusPacket(const QByteArray& payload)
+        : message(payload), size(payload.size()) {}
+    OpusPacket(const QByteArray& msg, qsizetype payloadOffset, qsizetype payloadSize)
+        : message(msg), offset(payloadOffset), size(payloadSize) {}
+
+    /**
+     * @brief 负载视图（message存活期间有效）
+     */
+    QByteArrayView payload() const { return QByteArrayView(message).sliced(offset, size); }
+};
+
+/**
+ * @brief 抖动缓冲统计信息
+ */
+struct JitterBufferStats {
+    int depth = 0;              // 当前缓冲帧数
+    int targetDepth = 0;        // 当前目标缓冲深度（帧）
+    double jitterMs = 0.0;      // 到达抖动估计（RFC 3550算法，毫秒）
+    quint64 received = 0;       // 入队包数
+    quint64 played = 0;         // 按序播放的包数
+    quint64 late = 0;           // 播放点之后才到达的包（丢弃）
+    quint64 lost = 0;           // 播放时仍缺失的帧（由PLC/FEC补偿）
+    quint64 duplicated = 0;     // 重复包
+    quint64 overflowDropped = 0;// 缓冲溢出时丢弃的旧帧（仅不可靠传输）
+    int peakDepth = 0;          // 历史最大缓冲帧数
+    quint64 underruns = 0;      // 缓冲耗尽次数（重新进入预缓冲）
+};
+
+/**
+ * @brief 自适应抖动缓冲
+ *
+ * 位于网络接收与解码播放之间：
+ * - 按包头序列号重排乱序包、丢弃重复包和迟到包
+ * - 以"序列号 × 帧时长"作为媒体时钟估计到达抖动（服务器时间戳单位不统一，不直接使用）
+ * - 目标深度 = 1 + ceil(3 × 抖动 / 帧时长)，限定在[minDepth, maxDepth]
+ * - 预缓冲达到目标深度后开始出队，耗尽后重新预缓冲
+ * - 不可靠传输（UDP）超过上限时丢弃最旧帧限制延迟；可靠传输（WebSocket）不丢帧，
+ *   服务器快于实时下发整句TTS时缓冲随之增长，由播放端按实际速率消费
+ *
+ * 非线程安全，由ConversationManager在其所在线程驱动
+ */
+class JitterBuffer {
+public:
+    /**
+     * @brief 出队结果
+     */
+    enum class PopResult {
+        Packet,     // 取到按序的包
+        Missing,    // 当前播放位置缺包（调用方应做PLC/FEC补偿）
+        Empty       // 预缓冲中或缓冲已空，本周期无输出
+    };
+
+    /**
+     * @param frameDurationMs 每包时长（毫秒）
+     * @param minDepth 最小目标深度（帧）
+     * @param maxDepth 最大目标深度（帧）
+     */
+    explicit JitterBuffer(int frameDurationMs = 60, int minDepth = 1, int maxDepth = 8);
+
+    /**
+     * @brief 清空缓冲并重置序列基准（新音频流开始时调用）
+     *
+     * 统计计数保留，便于观察整个会话
+     */
+    void reset();
+
+    /**
+     * @brief 设置是否为可靠传输（可靠传输不因溢出丢帧、不因序列跳跃重置）
+     */
+    void setReliableTransport(bool reliable) { m_reliable = reliable; }
+
+    /**
+     * @brief 入队一个包
+     * @param sequence 包序列号（32位，允许回绕）
+     * @param packet Opus包（只增加原消息的引用计数）
+     * @param arrivalMs 到达时间（单调时钟，毫秒）
+     * @return 被接受返回true；重复或迟到返回false
+     */
+    bool push(quint32 sequence, const OpusPacket& packet, qint64 arrivalMs);
+
+    /**
+     * @brief 出队一帧（每个播放周期调用一次）
+     * @param packet 输出：PopResult::Packet时为该包
+     * @param flushing 流结束冲刷：忽略预缓冲门限，缓冲为空时返回Empty
+     */
+    PopResult pop(OpusPacket& packet, bool flushing = false);
+
+    /**
+     * @brief 取下一播放位置的包（用于Missing后做FEC恢复），不存在返回nullptr
+     */
+    const OpusPacket* peekNext() const;
+
+    /**
+     * @brief 最近一次pop返回Packet时该包的原始32位序列号（用于延迟追踪关联）
+     */
+    quint32 lastSequence() const { return static_cast<quint32>(m_nextPlay - 1); }
+
+    /**
+     * @brief 是否处于预缓冲阶段
+     */
+    bool isBuffering() const { return !m_started; }
+
+    /**
+     * @brief 当前缓冲帧数
+     */
+    int depth() const { return static_cast<int>(m_packets.size()); }
+
+    /**
+     * @brief 帧时长（毫秒）
+     */
+    int frameDurationMs() const { return m_frameDurationMs; }
+
+    /**
+     * @brief 获取统计信息
+     */
+    JitterBufferStats stats() const;
+
+private:
+    /**
+     * @brief 将32位序列号展开为单调递增的64位序列号
+     */
+    qint64 unwrap(quint32 sequence);
+
+    /**
+     * @brief 更新抖动估计与目标深度
+     */
+    void updateJitter(qint64 extSequence, qint64 arrivalMs);
+
+    std::map<qint64, OpusPacket> m_packets;  // 展开序列号 -> 包（有序）
+    int m_frameDurationMs;
+    int m_minDepth;
+    int m_maxDepth;
+    int m_hardLimit;                         // 不可靠传输的缓冲上限（帧），超过后丢弃最旧帧以限制延迟
+    bool m_reliable;                         // 可靠传输：保序不丢包，缓冲不设上限
+    int m_targetDepth;
+
+    bool m_hasReference;                     // 是否已有序列基准
+    qint64 m_lastExtSequence;                // 最近展开的序列号（用于回绕展开）
+    bool m_started;                          // 是否已开始出队
+    bool m_hasPlayPosition;                  // 是否已有播放位置（晚于此位置的包才有效）
+    qint64 m_nextPlay;                       // 下一个播放位置
+
+    // 抖动估计（RFC 3550: J += (|D| - J) / 16）
+    bool m_hasTransit;
+    qint64 m_prevTransitMs;
+    double m_jitterMs;
+
+    JitterBufferStats m_stats;
+};
+
+} // namespace audio
+} // namespace xiaozhi
+
+#endif // JITTER_BUFFER_H
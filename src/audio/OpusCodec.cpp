@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T22:00:00Z
+Updated: 2026-10-16T09:10:00Z
 File: OpusCodec.cpp
 Desc: Opus音频编解码器实现
 */
@@ -24,6 +24,8 @@ OpusCodec::OpusCodec()
     , decoder_sample_rate_(0)
     , decoder_channels_(0)
     , decoder_frame_size_(0)
+    , last_decoded_samples_(0)
+    , allocation_count_(0)
 {
 }
 
@@ -89,27 +91,69 @@ QByteArray OpusCodec::encode(const QByteArray& pcm_data) {
         return QByteArray();
     }
     
-    // 准备输出缓冲区
-    QByteArray opus_data(MAX_PACKET_SIZE, 0);
-    
-    // 编码
-    int encoded_bytes = opus_encode(
-        encoder_,
+    // 先编码到复用缓冲区，再按实际长度拷贝一次（避免先分配4000字节再收缩）
+    int encoded_bytes = encode(
         reinterpret_cast<const opus_int16*>(pcm_data.constData()),
         encoder_frame_size_,
-        reinterpret_cast<unsigned char*>(opus_data.data()),
+        encode_scratch_.data(),
         MAX_PACKET_SIZE
     );
+    if (encoded_bytes < 0) {
+        return QByteArray();
+    }
+    
+    ++allocation_count_;
+    return QByteArray(reinterpret_cast<const char*>(encode_scratch_.data()), encoded_bytes);
+}
+
+int OpusCodec::encode(const opus_int16* pcm, int samples, unsigned char* out, int out_capacity) {
+    if (!encoder_) {
+        utils::Logger::instance().error("❌ Opus编码器未初始化");
+        return -1;
+    }
+    
+    if (samples != encoder_frame_size_) {
+        utils::Logger::instance().error(QString("❌ PCM样本数不匹配: 期望%1, 实际%2")
+            .arg(encoder_frame_size_)
+            .arg(samples));
+        return -1;
+    }
+    
+    // 编码
+    int encoded_bytes = opus_encode(encoder_, pcm, samples, out, out_capacity);
     
     if (encoded_bytes < 0) {
         utils::Logger::instance().error(QString("❌ Opus编码失败: %1").arg(opus_strerror(encoded_bytes)));
-        return QByteArray();
+        return -1;
     }
     
-    // 调整数据大小
-    opus_data.resize(encoded_bytes);
+    return encoded_bytes;
+}
+
+bool OpusCodec::setEncoderInbandFec(bool enabled, int packet_loss_percent) {
+    if (!encoder_) {
+        utils::Logger::instance().error("❌ Opus编码器未初始化");
+        return false;
+    }
     
-    return opus_data;
+    int error = opus_encoder_ctl(encoder_, OPUS_SET_INBAND_FEC(enabled ? 1 : 0));
+    if (error != OPUS_OK) {
+        utils::Logger::instance().error(QString("❌ 设置Opus带内FEC失败: %1").arg(opus_strerror(error)));
+        return false;
+    }
+    
+    // 丢包率提示决定编码器为FEC分配多少码率（0表示不预留）
+    int loss = qBound(0, packet_loss_percent, 100);
+    error = opus_encoder_ctl(encoder_, OPUS_SET_PACKET_LOSS_PERC(loss));
+    if (error != OPUS_OK) {
+        utils::Logger::instance().error(QString("❌ 设置Opus丢包率提示失败: %1").arg(opus_strerror(error)));
+        return false;
+    }
+    
+    utils::Logger::instance().info(QString(" Opus带内FEC: %1 (丢包率提示=%2%)")
+        .arg(enabled ? "启用" : "禁用")
+        .arg(loss));
+    return true;
 }
 
 // ========== 解码器 ==========
@@ -128,6 +172,8 @@ bool OpusCodec::initDecoder(int sample_rate, int channels) {
     decoder_sample_rate_ = sample_rate;
     decoder_channels_ = channels;
     decoder_frame_size_ = (sample_rate * FRAME_DURATION_MS) / 1000;
+    last_decoded_samples_ = decoder_frame_size_;
+    ensureDecodeScratch();
     
     utils::Logger::instance().info(QString(" Opus解码器初始化成功: %1Hz %2声道 帧大小=%3样本")
         .arg(sample_rate)
@@ -138,40 +184,102 @@ bool OpusCodec::initDecoder(int sample_rate, int channels) {
 }
 
 QByteArray OpusCodec::decode(const QByteArray& opus_data) {
+    const opus_int16* pcm = nullptr;
+    int decoded_samples = decode(
+        reinterpret_cast<const unsigned char*>(opus_data.constData()),
+        opus_data.size(),
+        &pcm
+    );
+    
+    if (decoded_samples <= 0) {
+        return QByteArray();
+    }
+    
+    // 按实际解码长度拷贝一次（不再预分配12KB再收缩）
+    ++allocation_count_;
+    return QByteArray(reinterpret_cast<const char*>(pcm), decoded_samples * decoder_channels_ * 2);
+}
+
+int OpusCodec::decode(const unsigned char* data, int size, const opus_int16** pcm_out) {
     if (!decoder_) {
         utils::Logger::instance().error("❌ Opus解码器未初始化");
-        return QByteArray();
+        return -1;
     }
     
-    if (opus_data.isEmpty()) {
+    if (!data || size <= 0) {
         utils::Logger::instance().debug("Opus数据为空，跳过解码");
-        return QByteArray();
+        return -1;
     }
     
-    //  ESP32对齐：准备足够大的缓冲区支持可变帧大小
-    const int MAX_FRAME_SIZE = 6000;
-    QByteArray pcm_data(MAX_FRAME_SIZE * decoder_channels_ * 2, 0);
-    
-    // 解码
+    //  ESP32对齐：复用缓冲区足够大，支持可变帧大小
     int decoded_samples = opus_decode(
         decoder_,
-        reinterpret_cast<const unsigned char*>(opus_data.constData()),
-        opus_data.size(),
-        reinterpret_cast<opus_int16*>(pcm_data.data()),
-        MAX_FRAME_SIZE,
+        data,
+        size,
+        decode_scratch_.data(),
+        MAX_DECODE_FRAME_SIZE,
         0  // 不使用FEC
     );
     
     if (decoded_samples < 0) {
         // 解码失败，静默跳过（可能是包损坏）
         // 不要打印日志，避免刷屏
-        return QByteArray();
+        return -1;
+    }
+    
+    last_decoded_samples_ = decoded_samples;
+    if (pcm_out) {
+        *pcm_out = decode_scratch_.data();
+    }
+    return decoded_samples;
+}
+
+int OpusCodec::decodeLost(const opus_int16** pcm_out) {
+    if (!decoder_) {
+        return -1;
     }
     
-    // 调整数据大小
-    pcm_data.resize(decoded_samples * decoder_channels_ * 2);
+    // data=NULL 触发libopus的PLC，补偿时长必须是2.5ms的整数倍，沿用上一个包的时长
+    int samples = last_decoded_samples_ > 0 ? last_decoded_samples_ : decoder_frame_size_;
+    int decoded_samples = opus_decode(decoder_, nullptr, 0, decode_scratch_.data(), samples, 0);
+    if (decoded_samples < 0) {
+        return -1;
+    }
     
-    return pcm_data;
+    if (pcm_out) {
+        *pcm_out = decode_scratch_.data();
+    }
+    return decoded_samples;
+}
+
+int OpusCodec::decodeFec(const unsigned char* next_data, int next_size, const opus_int16** pcm_out) {
+    if (!decoder_) {
+        return -1;
+    }
+    
+    if (!next_data || next_size <= 0) {
+        return decodeLost(pcm_out);
+    }
+    
+    // decode_fec=1：从下一个包的LBRR数据中恢复丢失帧，frame_size必须等于丢失帧时长
+    int samples = last_decoded_samples_ > 0 ? last_decoded_samples_ : decoder_frame_size_;
+    int decoded_samples = opus_decode(decoder_, next_data, next_size, decode_scratch_.data(), samples, 1);
+    if (decoded_samples < 0) {
+        return decodeLost(pcm_out);
+    }
+    
+    if (pcm_out) {
+        *pcm_out = decode_scratch_.data();
+    }
+    return decoded_samples;
+}
+
+void OpusCodec::ensureDecodeScratch() {
+    const size_t required = static_cast<size_t>(MAX_DECODE_FRAME_SIZE) * decoder_channels_;
+    if (decode_scratch_.size() < required) {
+        decode_scratch_.resize(required);
+        ++allocation_count_;
+    }
 }
 
 void OpusCodec::resetDecoderState() {
@@ -179,6 +287,7 @@ void OpusCodec::resetDecoderState() {
         // 重置解码器内部状态（清除缓冲区）
         opus_decoder_ctl(decoder_, OPUS_RESET_STATE);
     }
+    last_decoded_samples_ = decoder_frame_size_;
 }
 
 bool OpusCodec::setDecoderSampleRate(int target_sample_rate) {
@@ -204,6 +313,7 @@ bool OpusCodec::setDecoderSampleRate(int target_sample_rate) {
     // 更新解码器参数
     decoder_sample_rate_ = target_sample_rate;
     decoder_frame_size_ = (target_sample_rate * FRAME_DURATION_MS) / 1000;
+    last_decoded_samples_ = decoder_frame_size_;
     
     utils::Logger::instance().info(QString(" Opus解码器已重建: %1Hz %2声道 (ESP32对齐)")
         .arg(target_sample_rate).arg(decoder_channels_));
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T22:00:00Z
+Updated: 2026-10-16T09:10:00Z
 File: OpusCodec.h
 Desc: Opus音频编解码器（对齐ESP32参数：16kHz单声道60ms帧）
 */
@@ -12,7 +12,10 @@ Desc: Opus音频编解码器（对齐ESP32参数：16kHz单声道60ms帧）
 #define OPUS_CODEC_H
 
 #include <QByteArray>
+#include <QtGlobal>
+#include <array>
 #include <memory>
+#include <vector>
 #include <opus/opus.h>
 
 namespace xiaozhi {
@@ -61,7 +64,25 @@ public:
      * @return Opus编码数据，失败返回空数组
      */
     QByteArray encode(const QByteArray& pcm_data);
-    
+
+    /**
+     * @brief 编码一帧PCM到调用方提供的缓冲区（热路径，零堆分配）
+     * @param pcm PCM样本（16位有符号整数，交错排列）
+     * @param samples 每声道样本数（必须等于getEncoderFrameSize()）
+     * @param out 输出缓冲区
+     * @param out_capacity 输出缓冲区容量（字节，建议maxPacketSize()）
+     * @return 编码后的字节数，失败返回-1
+     */
+    int encode(const opus_int16* pcm, int samples, unsigned char* out, int out_capacity);
+
+    /**
+     * @brief 设置编码器带内FEC与丢包率提示
+     * @param enabled 是否启用带内FEC（OPUS_SET_INBAND_FEC）
+     * @param packet_loss_percent 预期丢包率（0-100，OPUS_SET_PACKET_LOSS_PERC）
+     * @return 成功返回true
+     */
+    bool setEncoderInbandFec(bool enabled, int packet_loss_percent);
+
     /**
      * @brief 获取编码器每帧样本数
      * @return 样本数（16kHz * 60ms = 960）
@@ -84,7 +105,35 @@ public:
      * @return PCM数据（16位有符号整数），失败返回空数组
      */
     QByteArray decode(const QByteArray& opus_data);
-    
+
+    /**
+     * @brief 解码Opus包到编解码器内部复用缓冲区（热路径，零堆分配）
+     * @param data Opus数据
+     * @param size 数据长度（字节）
+     * @param pcm_out 输出：指向内部PCM缓冲区，下一次解码前有效
+     * @return 解码得到的每声道样本数，失败返回-1
+     */
+    int decode(const unsigned char* data, int size, const opus_int16** pcm_out);
+
+    /**
+     * @brief 丢包补偿（PLC）：为一个丢失的包生成补偿音频
+     * @param pcm_out 输出：指向内部PCM缓冲区，下一次解码前有效
+     * @return 生成的每声道样本数（与上一个包时长一致），失败返回-1
+     */
+    int decodeLost(const opus_int16** pcm_out);
+
+    /**
+     * @brief 带内FEC恢复：用下一个包携带的冗余数据重建紧邻其前的丢失包
+     *
+     * 若该包未携带FEC数据，libopus会自动退化为PLC
+     *
+     * @param next_data 丢失包之后收到的第一个Opus包
+     * @param next_size 数据长度（字节）
+     * @param pcm_out 输出：指向内部PCM缓冲区，下一次解码前有效
+     * @return 恢复的每声道样本数，失败返回-1
+     */
+    int decodeFec(const unsigned char* next_data, int next_size, const opus_int16** pcm_out);
+
     /**
      * @brief 重置解码器状态（清除内部缓冲）
      */
@@ -121,7 +170,24 @@ public:
      */
     bool isDecoderReady() const { return decoder_ != nullptr; }
 
+    /**
+     * @brief 编解码器累计堆分配次数（内部缓冲扩容 + 旧QByteArray接口的返回值）
+     * 
+     * 稳态下只走span接口时该计数保持不变，可用于验证热路径零分配
+     */
+    quint64 allocationCount() const { return allocation_count_; }
+
+    /**
+     * @brief Opus单包最大尺寸（encode输出缓冲区建议容量）
+     */
+    static constexpr int maxPacketSize() { return MAX_PACKET_SIZE; }
+
 private:
+    /**
+     * @brief 确保解码缓冲区容量足够（仅在初始化/声道变化时扩容）
+     */
+    void ensureDecodeScratch();
+
     // 编码器
     OpusEncoder* encoder_;
     int encoder_sample_rate_;
@@ -133,10 +199,17 @@ private:
     int decoder_sample_rate_;
     int decoder_channels_;
     int decoder_frame_size_;     // 每帧样本数
-    
+    int last_decoded_samples_;   // 上一个包的样本数（PLC/FEC按此时长补偿）
+
     // 常量
     static constexpr int FRAME_DURATION_MS = 60;  // 帧时长（毫秒）
     static constexpr int MAX_PACKET_SIZE = 4000;  // Opus包最大尺寸
+    static constexpr int MAX_DECODE_FRAME_SIZE = 6000;  // 单包最大解码样本数（每声道，覆盖120ms@48kHz）
+
+    // 复用缓冲区（避免每帧分配）
+    std::array<unsigned char, MAX_PACKET_SIZE> encode_scratch_;  // 旧encode接口的中间缓冲
+    std::vector<opus_int16> decode_scratch_;                     // 解码输出缓冲
+    quint64 allocation_count_;                                   // 堆分配计数
 };
 
 } // namespace audio
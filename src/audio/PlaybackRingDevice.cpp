@@ -0,0 +1,73 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:00:00Z
+File: PlaybackRingDevice.cpp
+Desc: 拉模式播放数据源实现
+*/
+
+#include "PlaybackRingDevice.h"
+
+namespace xiaozhi {
+namespace audio {
+
+PlaybackRingDevice::PlaybackRingDevice(QObject* parent)
+    : QIODevice(parent)
+    , m_ring(nullptr)
+{
+}
+
+qint64 PlaybackRingDevice::bytesAvailable() const {
+    const qint64 buffered = m_ring ? static_cast<qint64>(m_ring->size()) : 0;
+    return buffered + QIODevice::bytesAvailable();
+}
+
+qint64 PlaybackRingDevice::readData(char* data, qint64 maxlen) {
+    if (maxlen <= 0) {
+        return 0;
+    }
+
+    qint64 got = 0;
+    if (m_ring) {
+        got = static_cast<qint64>(m_ring->read(data, static_cast<size_t>(maxlen)));
+    }
+
+    // 只交出实际数据；取空计为欠载（仅统计"有数据→取空"的转变，空闲期间不重复计数）
+    if (got == 0) {
+        if (!m_starved.exchange(true, std::memory_order_acq_rel)) {
+            m_underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        m_starved.store(false, std::memory_order_release);
+    }
+
+    if (m_refillRequested.exchange(false, std::memory_order_acq_rel)) {
+        emit spaceAvailable();
+    }
+
+    // 低水位通知只发一次，生产者补充数据后重新请求
+    qint64 watermark = m_demandWatermark.load(std::memory_order_acquire);
+    if (watermark > 0 && m_ring && static_cast<qint64>(m_ring->size()) < watermark
+        && m_demandWatermark.compare_exchange_strong(watermark, 0, std::memory_order_acq_rel)) {
+        emit dataRequested();
+    }
+    return got;
+}
+
+void PlaybackRingDevice::notifyDataAvailable() {
+    // 取空后部分后端停止轮询、等待readyRead才继续拉取
+    if (m_starved.load(std::memory_order_acquire)) {
+        emit readyRead();
+    }
+}
+
+qint64 PlaybackRingDevice::writeData(const char* data, qint64 len) {
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return -1;
+}
+
+} // namespace audio
+} // namespace xiaozhi
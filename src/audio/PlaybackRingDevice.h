@@ -0,0 +1,96 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:00:00Z
+File: PlaybackRingDevice.h
+Desc: 拉模式播放数据源（以播放环形缓冲为后端的只读QIODevice）
+*/
+
+#ifndef PLAYBACK_RING_DEVICE_H
+#define PLAYBACK_RING_DEVICE_H
+
+#include "SpscRingBuffer.h"
+#include <QIODevice>
+#include <atomic>
+
+namespace xiaozhi {
+namespace audio {
+
+/**
+ * @brief 拉模式播放数据源
+ *
+ * 交给QAudioSink::start(QIODevice*)，由音频后端按自身节奏调用readData拉取PCM：
+ * - readData是环形缓冲唯一的消费者，可能运行在音频后端线程
+ * - 只返回实际可用的数据，不补静音：补静音会把输出设备内部缓冲填满静音，
+ *   真实音频排在其后增加延迟，也会掩盖欠载
+ * - 实时流永不结束（atEnd恒为false），取空时后端进入Idle（欠载）而非停止；
+ *   生产者写入后调用notifyDataAvailable，按readyRead唤醒等待中的后端
+ * - 生产者存在积压时调用requestRefill，下次拉取后发出spaceAvailable，
+ *   由生产者线程（队列连接）继续搬运，保持单生产者约定
+ * - 生产者调用requestData设置水位，拉取后缓冲低于水位时发出一次dataRequested，
+ *   播放节奏由音频后端的拉取驱动，生产者无需定时器
+ */
+class PlaybackRingDevice : public QIODevice {
+    Q_OBJECT
+
+public:
+    explicit PlaybackRingDevice(QObject* parent = nullptr);
+
+    /**
+     * @brief 设置后端环形缓冲（不持有所有权，需在播放停止时调用）
+     */
+    void setRingBuffer(SpscRingBuffer* ring) { m_ring = ring; }
+
+    bool isSequential() const override { return true; }
+    bool atEnd() const override { return false; }
+    qint64 bytesAvailable() const override;
+
+    /**
+     * @brief 生产者写入数据后调用：拉取端曾取空时发出readyRead（生产者线程）
+     */
+    void notifyDataAvailable();
+
+    /**
+     * @brief 请求在下次拉取后发出spaceAvailable（任意线程）
+     */
+    void requestRefill() { m_refillRequested.store(true, std::memory_order_release); }
+
+    /**
+     * @brief 请求在缓冲低于指定字节数时发出一次dataRequested（任意线程，一次性）
+     */
+    void requestData(qint64 lowWatermark) { m_demandWatermark.store(lowWatermark, std::memory_order_release); }
+
+    /**
+     * @brief 拉取时缓冲由有数据转为取空的次数（欠载），含每段音频播放结束
+     */
+    quint64 underrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+
+signals:
+    /**
+     * @brief 环形缓冲已被消费，生产者可继续写入积压数据
+     */
+    void spaceAvailable();
+
+    /**
+     * @brief 缓冲已低于requestData设置的水位，生产者应继续解码写入
+     */
+    void dataRequested();
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override;
+    qint64 writeData(const char* data, qint64 len) override;
+
+private:
+    SpscRingBuffer* m_ring;
+    std::atomic<bool> m_starved{true};          // 上次拉取是否取空（消费者写，生产者读）
+    std::atomic<bool> m_refillRequested{false};
+    std::atomic<qint64> m_demandWatermark{0};   // >0表示已请求低水位通知
+    std::atomic<quint64> m_underruns{0};
+};
+
+} // namespace audio
+} // namespace xiaozhi
+
+#endif // PLAYBACK_RING_DEVICE_H
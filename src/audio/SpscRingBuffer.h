@@ -0,0 +1,188 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T10:50:00Z
+File: SpscRingBuffer.h
+Desc: 无锁单生产者/单消费者字节环形缓冲（容量为2的幂，读写索引按缓存行隔离）
+*/
+
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace xiaozhi {
+namespace audio {
+
+/**
+ * @brief 无锁SPSC字节环形缓冲
+ *
+ * - 容量向上取整为2的幂，索引单调递增，用掩码取模（无需额外空位区分满/空）
+ * - 写索引仅由生产者修改、读索引仅由消费者修改，两者分处不同缓存行避免伪共享
+ * - 生产者以release发布写索引，消费者以acquire读取，反之亦然
+ * - 读写均不搬移已有数据；writeRegion/readRegion提供连续区域，可直接作为I/O缓冲
+ *
+ * 线程约定：write/writeRegion/commitWrite只能在生产者线程调用，
+ * read/readRegion/commitRead只能在消费者线程调用；clear需在两端都静止时调用
+ */
+class SpscRingBuffer {
+public:
+    /**
+     * @param capacity 期望容量（字节），向上取整为2的幂
+     */
+    explicit SpscRingBuffer(size_t capacity)
+        : m_capacity(roundUpPowerOfTwo(capacity))
+        , m_mask(m_capacity - 1)
+        , m_data(new char[m_capacity])
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    /**
+     * @brief 总容量（字节）
+     */
+    size_t capacity() const { return m_capacity; }
+
+    /**
+     * @brief 当前可读字节数（任意线程调用时为近似值）
+     */
+    size_t size() const {
+        return m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 当前可写字节数（任意线程调用时为近似值）
+     */
+    size_t freeSpace() const { return m_capacity - size(); }
+
+    bool isEmpty() const { return size() == 0; }
+
+    // ========== 生产者 ==========
+
+    /**
+     * @brief 写入数据（空间不足时只写入能容纳的部分）
+     * @return 实际写入字节数
+     */
+    size_t write(const char* data, size_t len) {
+        size_t written = 0;
+        while (written < len) {
+            char* region = nullptr;
+            size_t n = writeRegion(&region);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - written) {
+                n = len - written;
+            }
+            std::memcpy(region, data + written, n);
+            commitWrite(n);
+            written += n;
+        }
+        return written;
+    }
+
+    /**
+     * @brief 获取下一段连续可写区域（至多到缓冲末尾，回绕部分需再次调用）
+     * @param region 输出：可写区域起始地址
+     * @return 区域长度（字节），缓冲已满时为0
+     */
+    size_t writeRegion(char** region) {
+        const size_t w = m_writeIndex.load(std::memory_order_relaxed);
+        const size_t r = m_readIndex.load(std::memory_order_acquire);
+        const size_t free = m_capacity - (w - r);
+        const size_t offset = w & m_mask;
+        const size_t contiguous = m_capacity - offset;
+        *region = m_data.get() + offset;
+        return free < contiguous ? free : contiguous;
+    }
+
+    /**
+     * @brief 提交已写入writeRegion的字节
+     */
+    void commitWrite(size_t len) {
+        m_writeIndex.store(m_writeIndex.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    // ========== 消费者 ==========
+
+    /**
+     * @brief 读取数据（可读不足时只读取现有部分）
+     * @return 实际读取字节数
+     */
+    size_t read(char* data, size_t len) {
+        size_t total = 0;
+        while (total < len) {
+            const char* region = nullptr;
+            size_t n = readRegion(&region);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - total) {
+                n = len - total;
+            }
+            std::memcpy(data + total, region, n);
+            commitRead(n);
+            total += n;
+        }
+        return total;
+    }
+
+    /**
+     * @brief 获取下一段连续可读区域（至多到缓冲末尾，回绕部分需再次调用）
+     * @param region 输出：可读区域起始地址
+     * @return 区域长度（字节），缓冲为空时为0
+     */
+    size_t readRegion(const char** region) const {
+        const size_t r = m_readIndex.load(std::memory_order_relaxed);
+        const size_t w = m_writeIndex.load(std::memory_order_acquire);
+        const size_t available = w - r;
+        const size_t offset = r & m_mask;
+        const size_t contiguous = m_capacity - offset;
+        *region = m_data.get() + offset;
+        return available < contiguous ? available : contiguous;
+    }
+
+    /**
+     * @brief 标记已消费readRegion中的字节
+     */
+    void commitRead(size_t len) {
+        m_readIndex.store(m_readIndex.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    /**
+     * @brief 清空缓冲（消费者侧丢弃全部可读数据）
+     */
+    void clear() {
+        m_readIndex.store(m_writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t v) {
+        size_t p = 1;
+        while (p < v) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<char[]> m_data;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_writeIndex{0};  // 生产者独占写
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_readIndex{0};   // 消费者独占写（对象按缓存行对齐，尾部自然留白）
+};
+
+} // namespace audio
+} // namespace xiaozhi
+
+#endif // SPSC_RING_BUFFER_H
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:35:00Z
+Updated: 2026-10-16T23:40:00Z
 File: main.cpp
 Desc: 程序入口
 */
@@ -16,8 +16,10 @@ Desc: 程序入口
 #include <QIcon>
 #include "version/version_info.h"
 #include "models/AppModel.h"
+#include "utils/Config.h"
 #include "utils/Logger.h"
 #include "network/UpdateManager.h"
+#include "storage/ThumbnailImageProvider.h"
 
 int main(int argc, char *argv[]) {
     // 启用高DPI缩放
@@ -49,6 +51,12 @@ int main(int argc, char *argv[]) {
     // 注册AppModel到QML上下文
     engine.rootContext()->setContextProperty("appModel", &appModel);
 
+    // 注册聊天记录缩略图提供器（引擎持有，先于appModel销毁）
+    engine.addImageProvider(QLatin1String(xiaozhi::storage::THUMBNAIL_PROVIDER_ID),
+                            new xiaozhi::storage::ThumbnailImageProvider(
+                                appModel.imageCacheManager(),
+                                qint64(xiaozhi::utils::Config::instance().getThumbnailCacheMB()) * 1024 * 1024));
+
     // 加载主QML文件
     const QUrl url(QStringLiteral("qrc:/main.qml"));
     
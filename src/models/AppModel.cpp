@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T06:30:00Z
+Updated: 2026-10-16T23:40:00Z
 File: AppModel.cpp
 Desc: 应用模型实现（使用MAC生成固定deviceId）
 */
@@ -11,6 +11,7 @@ Desc: 应用模型实现（使用MAC生成固定deviceId）
 #include "AppModel.h"
 #include "../audio/ConversationManager.h"
 #include "../utils/Config.h"
+#include "../utils/ImagePreprocessor.h"
 #include "../utils/Logger.h"
 #include "../version/version_info.h"
 #include <QUuid>
@@ -561,35 +562,56 @@ void AppModel::sendImageMessage(const QString& imagePath, const QString& text) {
             localPath = localPath.mid(8);  // 移除 "file:///"
         }
         
-        device->sendImageMessage(localPath, text);
-        
-        // 保存图片到缓存目录
-        qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
-        QString imageRelativePath;
-        QString imageAbsolutePath;
-        if (m_imageCacheManager) {
-            imageRelativePath = m_imageCacheManager->saveImageCache(m_currentDeviceId, localPath, timestamp);
-            // 立即解析为绝对路径用于UI显示
-            if (!imageRelativePath.isEmpty()) {
-                imageAbsolutePath = m_imageCacheManager->resolveFullPath(imageRelativePath);
-            }
+        // 在预处理线程池中校正方向、缩放、重新压缩；上传与缓存使用同一份结果
+        const QString deviceId = m_currentDeviceId;
+        const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+        utils::ImagePreprocessor::instance().process(localPath, utils::ImagePreprocessor::optionsFromConfig(), this,
+            [this, deviceId, text, timestamp](const utils::PreparedImage& image) {
+                onImagePrepared(deviceId, image, text, timestamp);
+            });
+    }
+}
+
+void AppModel::onImagePrepared(const QString& deviceId, const utils::PreparedImage& image,
+                               const QString& text, qint64 timestamp) {
+    if (!image.isValid()) {
+        addLog(image.error);
+        return;
+    }
+
+    // 预处理期间设备可能已被删除
+    auto device = m_deviceSessions.value(deviceId);
+    if (!device) {
+        return;
+    }
+    device->sendPreparedImage(image, text);
+    
+    // 保存图片到缓存目录（与上传内容一致，附带缩略图）
+    QString imageRelativePath;
+    QString imageAbsolutePath;
+    if (m_imageCacheManager) {
+        imageRelativePath = m_imageCacheManager->saveImageCache(deviceId, image, timestamp);
+        // 立即解析为绝对路径用于UI显示
+        if (!imageRelativePath.isEmpty()) {
+            imageAbsolutePath = m_imageCacheManager->resolveFullPath(imageRelativePath);
         }
-        
-        // 立即在UI显示用户发送的消息（带图片标识和预览）
-        xiaozhi::models::ChatMessage userMsg;
-        userMsg.deviceId = m_currentDeviceId;
-        userMsg.messageType = "image";
-        userMsg.textContent = QString("📷 %1").arg(text.isEmpty() ? "发送图片" : text);
-        userMsg.audioFilePath = "";
-        userMsg.imagePath = imageAbsolutePath;  // UI使用绝对路径
-        userMsg.timestamp = timestamp;
-        userMsg.isFinal = true;
-        userMsg.createdAt = QDateTime::currentDateTime();
-        
-        // 注意：saveChatMessage会保存到数据库，我们需要传递相对路径给数据库
-        // 但UI需要绝对路径，所以这里需要特殊处理
-        saveChatMessage(userMsg, QByteArray());
     }
+    
+    // 立即在UI显示用户发送的消息（带图片标识和预览）
+    xiaozhi::models::ChatMessage userMsg;
+    userMsg.deviceId = deviceId;
+    userMsg.messageType = "image";
+    userMsg.textContent = QString("📷 %1").arg(text.isEmpty() ? "发送图片" : text);
+    userMsg.audioFilePath = "";
+    userMsg.imagePath = imageAbsolutePath;  // UI使用绝对路径
+    userMsg.thumbnailUrl = m_imageCacheManager ? m_imageCacheManager->thumbnailUrl(imageRelativePath) : QString();
+    userMsg.timestamp = timestamp;
+    userMsg.isFinal = true;
+    userMsg.createdAt = QDateTime::currentDateTime();
+    
+    // 注意：saveChatMessage会保存到数据库，我们需要传递相对路径给数据库
+    // 但UI需要绝对路径，所以这里需要特殊处理
+    saveChatMessage(userMsg, QByteArray());
 }
 
 void AppModel::disconnectDevice(const QString& deviceId) {
@@ -878,11 +900,12 @@ void AppModel::loadChatMessages(const QString& deviceId) {
                 msg.audioFilePath = absolutePath;
             }
             
-            // 解析图片路径
+            // 解析图片路径（气泡显示缩略图，原图仅在查看大图时加载）
             if (!msg.imagePath.isEmpty() && m_imageCacheManager) {
                 QString absolutePath = m_imageCacheManager->resolveFullPath(msg.imagePath);
                 // 验证文件是否存在
                 if (QFileInfo::exists(absolutePath)) {
+                    msg.thumbnailUrl = m_imageCacheManager->thumbnailUrl(msg.imagePath);
                     msg.imagePath = absolutePath;
                 } else {
                     qCWarning(appModel) << "加载消息时发现图片文件不存在:" << absolutePath;
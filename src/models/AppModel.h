@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T23:05:00Z
+Updated: 2026-10-16T23:40:00Z
 File: AppModel.h
 Desc: 应用模型（QML绑定的核心控制器，管理多个设备会话）
 */
@@ -77,6 +77,11 @@ public:
     QVariantList chatMessages() const;
     QObject* updateManager() const { return m_updateManager.get(); }
 
+    /**
+     * @brief 图片缓存管理器（供缩略图提供器使用）
+     */
+    storage::ImageCacheManager* imageCacheManager() const { return m_imageCacheManager.get(); }
+
     // ========== QML可调用方法 ==========
 
     /**
@@ -237,6 +242,12 @@ private:
      */
     network::DeviceSession* getCurrentDevice();
 
+    /**
+     * @brief 图片预处理完成：发送、写入缓存并显示到聊天记录
+     */
+    void onImagePrepared(const QString& deviceId, const utils::PreparedImage& image,
+                         const QString& text, qint64 timestamp);
+
     /**
      * @brief 加载已保存的设备
      */
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-01-12T08:30:00Z
+Updated: 2026-10-16T23:40:00Z
 File: ChatMessage.h
 Desc: 聊天消息数据结构定义
 */
@@ -35,6 +35,7 @@ struct ChatMessage {
     
     // 运行时状态（不存数据库）
     bool isPlaying = false;       // 音频是否正在播放
+    QString thumbnailUrl;         // 图片缩略图URL（image://thumbnail/...）
     
     /**
      * @brief 默认构造函数
@@ -66,6 +67,7 @@ struct ChatMessage {
         map["timestamp"] = timestamp;
         map["isFinal"] = isFinal;
         map["isPlaying"] = isPlaying;
+        map["thumbnailUrl"] = thumbnailUrl;
         map["createdAt"] = createdAt.toString("yyyy-MM-dd hh:mm:ss");
         return map;
     }
@@ -84,6 +86,7 @@ struct ChatMessage {
         msg.timestamp = map["timestamp"].toLongLong();
         msg.isFinal = map["isFinal"].toBool();
         msg.isPlaying = map["isPlaying"].toBool();
+        msg.thumbnailUrl = map["thumbnailUrl"].toString();
         msg.createdAt = QDateTime::fromString(map["createdAt"].toString(), "yyyy-MM-dd hh:mm:ss");
         return msg;
     }
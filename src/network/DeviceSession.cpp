@@ -3,18 +3,20 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T06:30:00Z
+Updated: 2026-10-17T15:00:00Z
 File: DeviceSession.cpp
 Desc: 设备会话管理器实现（使用MAC生成固定UUID，确保设备身份持久化）
 */
 
 #include "DeviceSession.h"
+#include "NetworkThreadPool.h"
 #include "../models/ChatMessage.h"
 #include "../utils/Logger.h"
 #include <QUuid>
 #include <QTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
 #include <QJsonObject>
 
 namespace xiaozhi {
@@ -91,6 +93,13 @@ DeviceSession::DeviceSession(const QString& deviceId,
 }
 
 DeviceSession::~DeviceSession() {
+    // 取消未完成的图片上传
+    const QList<ImageUploadWorker*> uploads = m_imageUploads;
+    m_imageUploads.clear();
+    for (ImageUploadWorker* worker : uploads) {
+        NetworkThreadPool::instance().retire(worker);
+    }
+
     disconnect();
 }
 
@@ -184,6 +193,18 @@ void DeviceSession::sendTestAudio() {
 }
 
 void DeviceSession::sendImageMessage(const QString& imagePath, const QString& text) {
+    utils::ImagePreprocessor::instance().process(imagePath, utils::ImagePreprocessor::optionsFromConfig(), this,
+        [this, text](const utils::PreparedImage& image) {
+            sendPreparedImage(image, text);
+        });
+}
+
+void DeviceSession::sendPreparedImage(const utils::PreparedImage& image, const QString& text) {
+    if (!image.isValid()) {
+        emit logMessage(m_deviceId, image.error);
+        return;
+    }
+
     // 检查连接状态（支持WebSocket和MQTT）
     if (!isConnected()) {
         emit logMessage(m_deviceId, "未连接，无法发送消息");
@@ -196,51 +217,26 @@ void DeviceSession::sendImageMessage(const QString& imagePath, const QString& te
         return;
     }
 
-    // 读取图片文件
-    QFile imageFile(imagePath);
-    if (!imageFile.open(QIODevice::ReadOnly)) {
-        emit logMessage(m_deviceId, QString("无法读取图片: %1").arg(imagePath));
-        utils::Logger::instance().error(QString("[%1] 图片读取失败: %2").arg(m_deviceId, imagePath));
-        return;
-    }
-
-    QByteArray imageData = imageFile.readAll();
-    imageFile.close();
+    // 图片格式（扩展名，预处理后可能已转为jpg/webp）
+    const QString format = image.format;
+    const QString fileName = QFileInfo(image.sourcePath).fileName();
+    const bool useWebSocket = m_websocketConnected && m_websocketManager;
 
-    // 转换为Base64
-    QString base64Image = imageData.toBase64();
-    
-    // 获取图片格式（扩展名）
-    QString format = QFileInfo(imagePath).suffix().toLower();
-    if (format.isEmpty()) {
-        format = "jpg";  // 默认格式
-    }
+    // 消息JSON以占位符代替图片数据，图片在网络线程中分块编码进最终帧
+    QJsonObject dataObj;
+    dataObj["image"] = QString::fromLatin1(ImageUploadWorker::IMAGE_PLACEHOLDER);
+    dataObj["url"] = "";
+    dataObj["format"] = format;
 
-    QString fileName = QFileInfo(imagePath).fileName();
-    
-    // 根据协议类型发送
-    if (m_websocketConnected && m_websocketManager) {
+    QJsonObject message;
+    if (useWebSocket) {
         // WebSocket协议：简化的JSON格式（对齐ESP32）
-        QJsonObject message;
         message["session_id"] = m_sessionId;
         message["type"] = "image";
         message["text"] = text.isEmpty() ? "这张图片里有什么？" : text;
-        
-        // data字段
-        QJsonObject dataObj;
-        dataObj["image"] = base64Image;
-        dataObj["url"] = "";
-        dataObj["format"] = format;
         message["data"] = dataObj;
-        
-        QJsonDocument doc(message);
-        QString jsonStr = doc.toJson(QJsonDocument::Compact);
-        
-        m_websocketManager->sendJsonMessage(jsonStr);
-            
     } else if (m_mqttConnected && m_mqttManager) {
         // MQTT协议：完整格式消息
-        QJsonObject message;
         message["type"] = "image";
         message["text"] = text.isEmpty() ? "这张图片里有什么？" : text;
         message["session_id"] = m_sessionId;
@@ -258,20 +254,67 @@ void DeviceSession::sendImageMessage(const QString& imagePath, const QString& te
         message["audio_params"] = audioParams;
         
         // data结构
-        QJsonObject dataObj;
-        dataObj["image"] = base64Image;
-        dataObj["url"] = "";
-        dataObj["format"] = format;
         message["data"] = dataObj;
-        
         message["payload"] = QJsonObject();
+    } else {
+        return;
+    }
+    const QByteArray jsonTemplate = QJsonDocument(message).toJson(QJsonDocument::Compact);
+
+    auto* worker = new ImageUploadWorker();
+    worker->setTextFrame(useWebSocket);
+    worker->moveToThread(NetworkThreadPool::instance().acquire(NetworkThreadPool::Lane::Io));
+    m_imageUploads.append(worker);
+
+    connect(worker, &ImageUploadWorker::progress, this,
+            [this, fileName](qint64 encodedBytes, qint64 totalBytes) {
+        // 编码完成算99%，交给传输层后为100%
+        const int percent = static_cast<int>(encodedBytes * 99 / qMax<qint64>(1, totalBytes));
+        emit imageUploadProgress(m_deviceId, fileName, percent);
+    });
+    // 投递到传输层（编码期间连接可能已变化；写入失败由传输层经errorOccurred报告）
+    auto reportQueued = [this, fileName](bool queued) {
+        if (queued) {
+            emit imageUploadProgress(m_deviceId, fileName, 100);
+            emit logMessage(m_deviceId, QString("发送图片: %1").arg(fileName));
+        } else {
+            emit logMessage(m_deviceId, QString("连接已断开，图片未发送: %1").arg(fileName));
+        }
+    };
+    connect(worker, &ImageUploadWorker::textFrameReady, this,
+            [this, worker, reportQueued](const QString& frame) {
+        finishImageUpload(worker);
+        reportQueued(m_websocketConnected && m_websocketManager && m_websocketManager->sendJsonMessage(frame));
+    });
+    connect(worker, &ImageUploadWorker::frameReady, this,
+            [this, worker, reportQueued](const QByteArray& frame) {
+        finishImageUpload(worker);
+        const bool queued = m_mqttConnected && m_mqttManager;
+        if (queued) {
+            m_mqttManager->sendRawPayload(m_otaConfig.mqtt.publish_topic, frame, "image");
+        }
+        reportQueued(queued);
+    });
+    connect(worker, &ImageUploadWorker::failed, this,
+            [this, worker](const QString& error) {
+        finishImageUpload(worker);
+        emit logMessage(m_deviceId, error);
+    });
 
-        // 发送到MQTT
-        QString topic = m_otaConfig.mqtt.publish_topic;
-        m_mqttManager->sendRawMessage(topic, message);
+    emit imageUploadProgress(m_deviceId, fileName, 0);
+    QMetaObject::invokeMethod(worker, [worker, image, jsonTemplate]() {
+        if (image.data.isEmpty()) {
+            worker->start(image.sourcePath, jsonTemplate);
+        } else {
+            worker->startWithData(image.data, jsonTemplate);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void DeviceSession::finishImageUpload(ImageUploadWorker* worker) {
+    if (m_imageUploads.removeOne(worker)) {
+        NetworkThreadPool::instance().retire(worker);
     }
-    
-    emit logMessage(m_deviceId, QString("发送图片: %1").arg(fileName));
 }
 
 void DeviceSession::disconnect() {
@@ -295,6 +338,7 @@ void DeviceSession::onOtaConfigReceived(const OtaConfig& config) {
     m_otaConfig = config;
 
     emit logMessage(m_deviceId, "连接成功");
+    emit otaCompleted(m_deviceId);
 
     // 提取激活码并格式化显示
     if (!config.activation.code.isEmpty()) {
@@ -451,6 +495,9 @@ void DeviceSession::onUdpConfigReceived(const UdpConfig& config, const QString&
             config.serverChannels,        // 传递服务器声道数
             config.serverFrameDuration    // 传递服务器帧时长
         );
+        if (m_pcmSourceFactory) {
+            m_conversationManager->setPcmSourceFactory(m_pcmSourceFactory);
+        }
         
         // 连接对话管理器的信号到设备会话
         connect(m_conversationManager.get(), &audio::ConversationManager::sttTextReceived,
@@ -475,6 +522,8 @@ void DeviceSession::onUdpConfigReceived(const UdpConfig& config, const QString&
                 this, &DeviceSession::onTtsMessageCompleted);
         connect(m_conversationManager.get(), &audio::ConversationManager::sttMessageCompleted,
                 this, &DeviceSession::onSttMessageCompleted);
+
+        emit conversationReady(m_deviceId);
     }
 
     // 发送IoT描述符（延迟1秒）
@@ -585,6 +634,9 @@ void DeviceSession::onWebSocketConnected() {
             m_websocketManager->serverChannels(),
             m_websocketManager->serverFrameDuration()
         );
+        if (m_pcmSourceFactory) {
+            m_conversationManager->setPcmSourceFactory(m_pcmSourceFactory);
+        }
         
         // 连接对话管理器的信号
         connect(m_conversationManager.get(), &audio::ConversationManager::sttTextReceived,
@@ -609,6 +661,8 @@ void DeviceSession::onWebSocketConnected() {
                 this, &DeviceSession::onTtsMessageCompleted);
         connect(m_conversationManager.get(), &audio::ConversationManager::sttMessageCompleted,
                 this, &DeviceSession::onSttMessageCompleted);
+
+        emit conversationReady(m_deviceId);
     }
 }
 
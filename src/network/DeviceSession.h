@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T06:30:00Z
+Updated: 2026-10-16T22:30:00Z
 File: DeviceSession.h
 Desc: 设备会话管理器（每个智能体设备独立实例，网络隔离，基于MAC生成固定UUID）
 */
@@ -16,8 +16,10 @@ Desc: 设备会话管理器（每个智能体设备独立实例，网络隔离
 #include "MqttManager.h"
 #include "UdpManager.h"
 #include "WebSocketManager.h"
+#include "ImageUploadWorker.h"
 #include "../audio/ConversationManager.h"
 #include "../audio/AudioDevice.h"
+#include "../utils/ImagePreprocessor.h"
 #include <QObject>
 #include <QString>
 #include <memory>
@@ -86,6 +88,13 @@ public:
         m_websocketEnabled = enabled;
     }
 
+    /**
+     * @brief 替换上行采集数据源（无头压测用，需在对话管理器创建前设置）
+     */
+    void setPcmSourceFactory(audio::PcmSourceFactory factory) {
+        m_pcmSourceFactory = std::move(factory);
+    }
+
     // ========== 静态工具方法 ==========
 
     /**
@@ -118,12 +127,21 @@ public:
     void sendTextMessage(const QString& text);
 
     /**
-     * @brief 发送图片识别消息
+     * @brief 发送图片识别消息（先按Config预处理，再调用sendPreparedImage）
      * @param imagePath 图片文件路径
      * @param text 可选的文字描述
      */
     void sendImageMessage(const QString& imagePath, const QString& text = QString());
 
+    /**
+     * @brief 发送已预处理的图片
+     *
+     * 读取与Base64编码在网络线程中分块进行，完成后直接发送消息帧，进度见imageUploadProgress
+     * @param image 预处理结果（data为空时上传原图文件）
+     * @param text 可选的文字描述
+     */
+    void sendPreparedImage(const utils::PreparedImage& image, const QString& text = QString());
+
     /**
      * @brief 发送测试音频
      */
@@ -156,6 +174,18 @@ signals:
      */
     void activationCodeReceived(const QString& deviceId, const QString& code);
 
+    /**
+     * @brief OTA配置获取完成
+     * @param deviceId 设备ID
+     */
+    void otaCompleted(const QString& deviceId);
+
+    /**
+     * @brief 对话管理器已创建（可通过conversationManager()访问）
+     * @param deviceId 设备ID
+     */
+    void conversationReady(const QString& deviceId);
+
     /**
      * @brief 连接状态变化
      * @param deviceId 设备ID
@@ -172,6 +202,14 @@ signals:
      */
     void chatMessageReceived(const QString& deviceId, const xiaozhi::models::ChatMessage& message, const QByteArray& pcmData = QByteArray());
 
+    /**
+     * @brief 图片消息编码进度
+     * @param deviceId 设备ID
+     * @param fileName 图片文件名
+     * @param percent 进度（0-100，100表示已交给传输层发送）
+     */
+    void imageUploadProgress(const QString& deviceId, const QString& fileName, int percent);
+
 private slots:
     // OTA回调
     void onOtaConfigReceived(const OtaConfig& config);
@@ -200,6 +238,11 @@ private slots:
     void onSttMessageCompleted(const QString& text, qint64 timestamp);
 
 private:
+    /**
+     * @brief 结束一个图片上传工作者（在其所属网络线程中销毁）
+     */
+    void finishImageUpload(ImageUploadWorker* worker);
+
     // 设备基本信息
     QString m_deviceId;
     QString m_deviceName;
@@ -227,6 +270,10 @@ private:
     // 对话管理器
     std::unique_ptr<audio::ConversationManager> m_conversationManager;
     audio::AudioDevice* m_audioDevice;  // 外部引用
+    audio::PcmSourceFactory m_pcmSourceFactory;  // 为空时使用麦克风
+
+    // 进行中的图片上传（工作者位于共享网络线程）
+    QList<ImageUploadWorker*> m_imageUploads;
 };
 
 } // namespace network
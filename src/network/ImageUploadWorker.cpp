@@ -0,0 +1,171 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T15:00:00Z
+File: ImageUploadWorker.cpp
+Desc: 图片消息流式构建工作者实现
+*/
+
+#include "ImageUploadWorker.h"
+#include "../utils/Logger.h"
+#include <QBuffer>
+#include <QFile>
+#include <cstring>
+
+namespace xiaozhi {
+namespace network {
+
+ImageUploadWorker::ImageUploadWorker(QObject* parent)
+    : QObject(parent)
+    , m_totalBytes(0)
+    , m_encodedBytes(0)
+    , m_writePos(0)
+    , m_active(false)
+    , m_textFrame(false)
+{
+}
+
+ImageUploadWorker::~ImageUploadWorker() {
+    cancel();
+}
+
+void ImageUploadWorker::setTextFrame(bool textFrame) {
+    m_textFrame = textFrame;
+}
+
+void ImageUploadWorker::start(const QString& imagePath, const QByteArray& jsonTemplate) {
+    auto file = std::make_unique<QFile>(imagePath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        fail(QString("无法读取图片: %1").arg(imagePath));
+        return;
+    }
+    begin(std::move(file), jsonTemplate);
+}
+
+void ImageUploadWorker::startWithData(const QByteArray& imageData, const QByteArray& jsonTemplate) {
+    auto buffer = std::make_unique<QBuffer>();
+    buffer->setData(imageData);
+    buffer->open(QIODevice::ReadOnly);
+    begin(std::move(buffer), jsonTemplate);
+}
+
+void ImageUploadWorker::begin(std::unique_ptr<QIODevice> source, const QByteArray& jsonTemplate) {
+    cancel();
+
+    const qsizetype marker = jsonTemplate.indexOf(IMAGE_PLACEHOLDER);
+    if (marker < 0) {
+        fail("图片消息模板无效");
+        return;
+    }
+
+    m_source = std::move(source);
+    m_totalBytes = m_source->size();
+    if (m_totalBytes <= 0) {
+        fail("图片为空");
+        return;
+    }
+
+    // 前缀 + Base64 + 后缀一次性分配，之后按块原地写入
+    const qsizetype placeholderSize = static_cast<qsizetype>(std::strlen(IMAGE_PLACEHOLDER));
+    const qsizetype base64Size = static_cast<qsizetype>((m_totalBytes + 2) / 3 * 4);
+    m_suffix = jsonTemplate.mid(marker + placeholderSize);
+    m_frame.resize(marker + base64Size + m_suffix.size());
+    std::memcpy(m_frame.data(), jsonTemplate.constData(), static_cast<size_t>(marker));
+    m_writePos = marker;
+    m_encodedBytes = 0;
+    m_readBuffer.resize(CHUNK_BYTES);
+    m_active = true;
+
+    QMetaObject::invokeMethod(this, &ImageUploadWorker::encodeNextChunk, Qt::QueuedConnection);
+}
+
+void ImageUploadWorker::cancel() {
+    m_active = false;
+    m_source.reset();
+    m_frame = QByteArray();
+    m_suffix = QByteArray();
+    m_readBuffer = QByteArray();
+}
+
+void ImageUploadWorker::encodeNextChunk() {
+    if (!m_active) {
+        return;
+    }
+
+    const qint64 want = qMin(CHUNK_BYTES, m_totalBytes - m_encodedBytes);
+    const qint64 got = m_source->read(m_readBuffer.data(), want);
+    if (got != want) {
+        // 文件在读取期间被截断或读错误
+        fail(QString("图片读取失败: %1").arg(m_source->errorString()));
+        return;
+    }
+
+    m_writePos += encodeBase64(m_readBuffer.constData(), static_cast<qsizetype>(got), m_frame.data() + m_writePos);
+    m_encodedBytes += got;
+    emit progress(m_encodedBytes, m_totalBytes);
+
+    if (m_encodedBytes < m_totalBytes) {
+        // 让出事件循环，同线程其他工作者的事件得以处理
+        QMetaObject::invokeMethod(this, &ImageUploadWorker::encodeNextChunk, Qt::QueuedConnection);
+        return;
+    }
+
+    std::memcpy(m_frame.data() + m_writePos, m_suffix.constData(), static_cast<size_t>(m_suffix.size()));
+    m_source.reset();
+    m_active = false;
+
+    // 交出帧缓冲（隐式共享，跨线程投递不拷贝）
+    QByteArray frame;
+    frame.swap(m_frame);
+    m_suffix = QByteArray();
+    m_readBuffer = QByteArray();
+
+    if (m_textFrame) {
+        // 在本线程转换，先释放UTF-8帧再投递，峰值只多一份QString
+        const QString text = QString::fromUtf8(frame);
+        frame = QByteArray();
+        emit textFrameReady(text);
+        return;
+    }
+    emit frameReady(frame);
+}
+
+void ImageUploadWorker::fail(const QString& error) {
+    utils::Logger::instance().error(error);
+    cancel();
+    emit failed(error);
+}
+
+qsizetype ImageUploadWorker::encodeBase64(const char* in, qsizetype size, char* out) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    char* dst = out;
+
+    qsizetype i = 0;
+    for (; i + 3 <= size; i += 3) {
+        const quint32 v = (static_cast<quint32>(src[i]) << 16) | (static_cast<quint32>(src[i + 1]) << 8) | src[i + 2];
+        *dst++ = table[(v >> 18) & 0x3F];
+        *dst++ = table[(v >> 12) & 0x3F];
+        *dst++ = table[(v >> 6) & 0x3F];
+        *dst++ = table[v & 0x3F];
+    }
+
+    const qsizetype rest = size - i;
+    if (rest > 0) {
+        quint32 v = static_cast<quint32>(src[i]) << 16;
+        if (rest == 2) {
+            v |= static_cast<quint32>(src[i + 1]) << 8;
+        }
+        *dst++ = table[(v >> 18) & 0x3F];
+        *dst++ = table[(v >> 12) & 0x3F];
+        *dst++ = rest == 2 ? table[(v >> 6) & 0x3F] : '=';
+        *dst++ = '=';
+    }
+
+    return static_cast<qsizetype>(dst - out);
+}
+
+} // namespace network
+} // namespace xiaozhi
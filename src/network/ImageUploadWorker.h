@@ -0,0 +1,132 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T15:00:00Z
+File: ImageUploadWorker.h
+Desc: 图片消息流式构建工作者（分块读取并Base64编码进预分配的消息帧，带进度）
+*/
+
+#ifndef IMAGE_UPLOAD_WORKER_H
+#define IMAGE_UPLOAD_WORKER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <memory>
+
+namespace xiaozhi {
+namespace network {
+
+/**
+ * @brief 图片消息流式构建工作者
+ *
+ * 运行在NetworkThreadPool的Io线程中。消息JSON先在调用方以占位符代替图片数据序列化为模板，
+ * 这里按模板前缀+Base64+后缀一次性分配完整帧，按块读取文件并直接编码写入帧内；
+ * 每块之间回到事件循环，同线程的MQTT/OTA工作者不被阻塞。
+ * 整个过程只有一份文件大小4/3的帧缓冲，不再经过QString/QJsonObject中转。
+ * WebSocket文本帧只能以QString发送，setTextFrame(true)时在本线程完成转换，
+ * 不占用WebSocket所在的共享实时音频线程
+ */
+class ImageUploadWorker : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 模板中图片数据字段的占位值（"image": IMAGE_PLACEHOLDER）
+     */
+    static constexpr const char* IMAGE_PLACEHOLDER = "__xiaozhi_image_base64__";
+
+    explicit ImageUploadWorker(QObject* parent = nullptr);
+    ~ImageUploadWorker();
+
+    /**
+     * @brief 设置输出形式（须在start之前、移入工作线程前调用）
+     * @param textFrame true时完成后发出textFrameReady，否则发出frameReady
+     */
+    void setTextFrame(bool textFrame);
+
+public slots:
+    /**
+     * @brief 开始构建（在工作线程中执行）
+     * @param imagePath 图片文件路径
+     * @param jsonTemplate 紧凑序列化的消息JSON（图片字段为IMAGE_PLACEHOLDER）
+     */
+    void start(const QString& imagePath, const QByteArray& jsonTemplate);
+
+    /**
+     * @brief 以内存中的图片数据开始构建（预处理后的图片）
+     * @param imageData 图片数据（隐式共享，不拷贝）
+     * @param jsonTemplate 紧凑序列化的消息JSON（图片字段为IMAGE_PLACEHOLDER）
+     */
+    void startWithData(const QByteArray& imageData, const QByteArray& jsonTemplate);
+
+    /**
+     * @brief 取消构建并释放缓冲
+     */
+    void cancel();
+
+signals:
+    /**
+     * @brief 编码进度（每块一次）
+     * @param encodedBytes 已编码的原始字节数
+     * @param totalBytes 图片总字节数
+     */
+    void progress(qint64 encodedBytes, qint64 totalBytes);
+
+    /**
+     * @brief 消息帧构建完成（UTF-8 JSON，所有权转交接收方）
+     */
+    void frameReady(const QByteArray& frame);
+
+    /**
+     * @brief 消息帧构建完成（已转换为QString，供WebSocket文本帧直接发送）
+     */
+    void textFrameReady(const QString& frame);
+
+    /**
+     * @brief 构建失败
+     */
+    void failed(const QString& error);
+
+private slots:
+    /**
+     * @brief 读取并编码下一块
+     */
+    void encodeNextChunk();
+
+private:
+    /**
+     * @brief 以已打开的数据源开始构建
+     */
+    void begin(std::unique_ptr<QIODevice> source, const QByteArray& jsonTemplate);
+
+    /**
+     * @brief 失败时清理并发出failed
+     */
+    void fail(const QString& error);
+
+    /**
+     * @brief 标准Base64编码写入out（size非3的倍数时补齐'='），返回写入字节数
+     */
+    static qsizetype encodeBase64(const char* in, qsizetype size, char* out);
+
+    std::unique_ptr<QIODevice> m_source;  // 图片数据源（文件或内存缓冲）
+    QByteArray m_frame;          // 完整消息帧（一次性分配）
+    QByteArray m_suffix;         // 模板后缀（写入Base64后追加）
+    QByteArray m_readBuffer;     // 复用的读块缓冲
+    qint64 m_totalBytes;
+    qint64 m_encodedBytes;
+    qsizetype m_writePos;        // 帧内下一个Base64写入位置
+    bool m_active;
+    bool m_textFrame;            // 完成时转换为QString
+
+    static constexpr qint64 CHUNK_BYTES = 192 * 1024;  // 3的倍数，分块编码可直接拼接
+};
+
+} // namespace network
+} // namespace xiaozhi
+
+#endif // IMAGE_UPLOAD_WORKER_H
@@ -3,25 +3,81 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:31:00Z
+Updated: 2026-10-17T18:00:00Z
 File: MqttManager.cpp
 Desc: MQTT连接管理器实现（复刻esp32_simulator_gui.py第358-803行）
 */
 
 #include "MqttManager.h"
+#include "NetworkThreadPool.h"
+#include "ReconnectThrottle.h"
+#include "TlsSessionCache.h"
 #include "../utils/Logger.h"
 #include "../utils/Config.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QDateTime>
-#include <QCoreApplication>
-#include <QFile>
-#include <QDir>
+#include <QMutexLocker>
+#include <QSslCertificate>
+#include <QSslSocket>
 #include <chrono>
+#include <list>
 
 namespace xiaozhi {
 namespace network {
 
+namespace {
+constexpr size_t MAX_OUTBOUND_QUEUE = 64;       // 发送队列上限（控制消息，正常远小于此）
+constexpr size_t MAX_PUBLISH_IN_FLIGHT = 8;     // 同时交给paho的消息数
+constexpr qint64 PUBLISH_STATS_INTERVAL_MS = 1000;
+constexpr int CONNECT_TIMEOUT_MS = 5000;        // 单个候选的连接超时
+constexpr int PROBE_WATCHDOG_GRACE_MS = 1000;   // paho超时后仍未回调时的看门狗余量
+constexpr int PROBE_STAGGER_MS = 250;           // 传输层探测相邻候选的错开间隔（RFC 8305）
+
+/**
+ * @brief 正在断开的MQTT客户端（进程级）
+ *
+ * 工作者销毁或换用新客户端时旧客户端可能仍在断开：连同监听器移交到这里保持存活，
+ * 不在共享Io线程上wait()。每次移交时顺带释放已断开完成的
+ */
+class ClosingClients {
+public:
+    static ClosingClients& instance() {
+        static ClosingClients instance;
+        return instance;
+    }
+
+    void add(std::unique_ptr<mqtt::async_client> client, mqtt::token_ptr token,
+             std::shared_ptr<void> connectListener, std::shared_ptr<void> publishListener) {
+        QMutexLocker locker(&m_mutex);
+        m_entries.remove_if([](const Entry& entry) { return entry.token->is_complete(); });
+        if (!token || token->is_complete()) {
+            client.reset();     // 已断开：先于监听器释放
+            return;
+        }
+
+        Entry entry;
+        entry.connectListener = std::move(connectListener);
+        entry.publishListener = std::move(publishListener);
+        entry.token = std::move(token);
+        entry.client = std::move(client);
+        m_entries.push_back(std::move(entry));
+    }
+
+private:
+    // 成员逆序析构：客户端先于令牌与监听器释放
+    struct Entry {
+        std::shared_ptr<void> connectListener;
+        std::shared_ptr<void> publishListener;
+        mqtt::token_ptr token;
+        std::unique_ptr<mqtt::async_client> client;
+    };
+
+    QMutex m_mutex;
+    std::list<Entry> m_entries;
+};
+}
+
 // ============================================================================
 // MqttCallback实现
 // ============================================================================
@@ -64,33 +120,156 @@ void MqttCallback::message_arrived(mqtt::const_message_ptr msg) {
                              Q_ARG(QString, payload));
 }
 
+// ============================================================================
+// MqttConnectListener实现
+// ============================================================================
+
+MqttConnectListener::MqttConnectListener(QObject* parent)
+    : m_parent(parent)
+{
+}
+
+void MqttConnectListener::on_success(const mqtt::token& tok) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_parent) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_parent, "onConnectProbeFinished",
+                             Qt::QueuedConnection,
+                             Q_ARG(quint64, static_cast<quint64>(reinterpret_cast<quintptr>(tok.get_user_context()))),
+                             Q_ARG(bool, true));
+}
+
+void MqttConnectListener::on_failure(const mqtt::token& tok) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_parent) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_parent, "onConnectProbeFinished",
+                             Qt::QueuedConnection,
+                             Q_ARG(quint64, static_cast<quint64>(reinterpret_cast<quintptr>(tok.get_user_context()))),
+                             Q_ARG(bool, false));
+}
+
+void MqttConnectListener::detach() {
+    QMutexLocker locker(&m_mutex);
+    m_parent = nullptr;
+}
+
+// ============================================================================
+// MqttPublishListener实现
+// ============================================================================
+
+MqttPublishListener::MqttPublishListener(QObject* parent)
+    : m_parent(parent)
+{
+}
+
+void MqttPublishListener::on_success(const mqtt::token& tok) {
+    const quint64 id = static_cast<quint64>(reinterpret_cast<quintptr>(tok.get_user_context()));
+    QMutexLocker locker(&m_mutex);
+    if (!m_parent) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_parent, "onPublishFinished",
+                             Qt::QueuedConnection,
+                             Q_ARG(quint64, id),
+                             Q_ARG(bool, true),
+                             Q_ARG(int, 0));
+}
+
+void MqttPublishListener::on_failure(const mqtt::token& tok) {
+    const quint64 id = static_cast<quint64>(reinterpret_cast<quintptr>(tok.get_user_context()));
+    QMutexLocker locker(&m_mutex);
+    if (!m_parent) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_parent, "onPublishFinished",
+                             Qt::QueuedConnection,
+                             Q_ARG(quint64, id),
+                             Q_ARG(bool, false),
+                             Q_ARG(int, tok.get_return_code()));
+}
+
+void MqttPublishListener::detach() {
+    QMutexLocker locker(&m_mutex);
+    m_parent = nullptr;
+}
+
 // ============================================================================
 // MqttWorker实现
 // ============================================================================
 
 MqttWorker::MqttWorker(QObject* parent)
     : QObject(parent)
+    , m_connectListener(std::make_shared<MqttConnectListener>(this))
+    , m_publishListener(std::make_shared<MqttPublishListener>(this))
     , m_connected(false)
     , m_reconnectTimer(new QTimer(this))
+    , m_transportRace(new TransportRace(this))
+    , m_probeTimeoutTimer(new QTimer(this))
+    , m_nextProbeContext(1)
+    , m_activeProbe(-1)
+    , m_pendingProbe(-1)
+    , m_cacheOnResolve(false)
+    , m_autoReconnect(false)
+    , m_reconnecting(false)
+    , m_reconnectTokenHeld(false)
+    , m_fastPath(false)
+    , m_fastPathFailed(false)
+    , m_hasLastGood(false)
+    , m_lastGoodPort(0)
+    , m_lastGoodSSL(false)
+    , m_nextPublishId(1)
+    , m_published(0)
+    , m_publishFailed(0)
+    , m_publishDropped(0)
+    , m_maxQueued(0)
+    , m_latencySumMs(0)
+    , m_latencyMaxMs(0)
 {
-    // 设置重连定时器
-    m_reconnectTimer->setInterval(5000); // 5秒后重连
+    m_publishClock.start();
+
+    // 设置重连定时器（间隔由退避与全局令牌桶决定）
     m_reconnectTimer->setSingleShot(true);
     connect(m_reconnectTimer, &QTimer::timeout, this, &MqttWorker::attemptReconnect);
+
+    // 当前候选的连接看门狗
+    m_probeTimeoutTimer->setSingleShot(true);
+    connect(m_probeTimeoutTimer, &QTimer::timeout, this, &MqttWorker::onConnectProbeTimeout);
+
+    // 多候选时先并发探测传输层，胜出端点上才发起MQTT连接
+    m_transportRace->setStaggerMs(PROBE_STAGGER_MS);
+    m_transportRace->setTimeoutMs(CONNECT_TIMEOUT_MS);
+    connect(m_transportRace, &TransportRace::won, this, &MqttWorker::onTransportRaceWon);
+    connect(m_transportRace, &TransportRace::resolved, this, &MqttWorker::onTransportRaceResolved);
+    connect(m_transportRace, &TransportRace::failed, this, &MqttWorker::onTransportRaceFailed);
 }
 
 MqttWorker::~MqttWorker() {
-    if (m_client && m_connected) {
-        try {
-            m_client->disconnect()->wait();
-        } catch (...) {
-        }
-    }
+    cancelConnectProbes();
+    // 移交出去的客户端仍可能回调监听器：先解除与本对象的关联
+    m_connectListener->detach();
+    m_publishListener->detach();
+    releaseClient();
 }
 
 void MqttWorker::connectToMqtt(const MqttConfig& config) {
     m_config = config;
 
+    // 上层发起的新连接：复位退避，断线后自动重连
+    m_autoReconnect = true;
+    m_reconnecting = false;
+    m_reconnectTokenHeld = false;
+    m_reconnectTimer->stop();
+    m_backoff.reset();
+    connectWithDiscovery();
+}
+
+void MqttWorker::connectWithDiscovery() {
+    m_fastPath = false;
+    const MqttConfig& config = m_config;
+
     // 解析服务器地址和端口
     QString host;
     int port = 0;  // 0表示未指定
@@ -106,64 +285,42 @@ void MqttWorker::connectToMqtt(const MqttConfig& config) {
         portSpecified = false;
     }
 
+    // 按优先顺序收集候选(端口, 协议)，随后并发探测，首个可达者胜出
+    QList<QPair<int, bool>> candidates;
+    auto addCandidate = [&candidates](int candidatePort, bool useSSL) {
+        const QPair<int, bool> candidate(candidatePort, useSSL);
+        if (!candidates.contains(candidate)) {
+            candidates.append(candidate);
+        }
+    };
+
     // 情况1：OTA没有指定端口（需要尝试8883和1883）
     if (!portSpecified) {
         utils::Logger::instance().info(QString(" 服务器未指定端口: %1").arg(host));
         
-        // 检查8883端口缓存
-        if (utils::Config::instance().hasMqttPortProtocol(8883)) {
-            port = 8883;
-            bool useSSL = utils::Config::instance().getMqttPortProtocol(8883);
-            utils::Logger::instance().info(QString(" 使用缓存: 端口8883 → %1").arg(useSSL ? "TLS" : "TCP"));
-            if (tryConnect(host, port, useSSL)) {
-                return;  // 成功
+        // 已缓存的端口协议优先
+        for (int cachedPort : {8883, 1883}) {
+            if (utils::Config::instance().hasMqttPortProtocol(cachedPort)) {
+                bool useSSL = utils::Config::instance().getMqttPortProtocol(cachedPort);
+                utils::Logger::instance().info(QString(" 使用缓存: 端口%1 → %2").arg(cachedPort).arg(useSSL ? "TLS" : "TCP"));
+                addCandidate(cachedPort, useSSL);
             }
         }
         
-        // 检查1883端口缓存
-        if (utils::Config::instance().hasMqttPortProtocol(1883)) {
-            port = 1883;
-            bool useSSL = utils::Config::instance().getMqttPortProtocol(1883);
-            utils::Logger::instance().info(QString(" 使用缓存: 端口1883 → %1").arg(useSSL ? "TLS" : "TCP"));
-            if (tryConnect(host, port, useSSL)) {
-                return;  // 成功
-            }
-        }
-        
-        // 无缓存：先尝试8883（TLS）
-        utils::Logger::instance().info(" 未指定端口：优先尝试8883(TLS)");
-        port = 8883;
-        if (tryConnect(host, port, true)) {
-            utils::Config::instance().setMqttPortProtocol(port, true);
-            utils::Logger::instance().info(" 端口8883(TLS)连接成功并已缓存");
-            return;
-        }
-        
-        // 8883失败，尝试1883（TCP）
-        utils::Logger::instance().warn("8883(TLS)连接失败，尝试1883(TCP)");
-        port = 1883;
-        if (tryConnect(host, port, false)) {
-            utils::Config::instance().setMqttPortProtocol(port, false);
-            utils::Logger::instance().info(" 端口1883(TCP)连接成功并已缓存");
-            return;
-        }
-        
-        // 两个标准端口都失败
-        emit errorOccurred(QString("MQTT连接失败: 无法连接到%1 (尝试了8883和1883端口)").arg(host));
-        return;
+        // 无缓存时：8883(TLS)优先，失败后才尝试1883(TCP)
+        addCandidate(8883, true);
+        addCandidate(1883, false);
     }
-
-    // 情况2：OTA指定了端口（原有逻辑）
-    bool useSSL;
-    bool tryAlternate = false;
-    
-    if (utils::Config::instance().hasMqttPortProtocol(port)) {
+    // 情况2：OTA指定了端口
+    else if (utils::Config::instance().hasMqttPortProtocol(port)) {
         // 有缓存：直接使用缓存的协议
-        useSSL = utils::Config::instance().getMqttPortProtocol(port);
+        bool useSSL = utils::Config::instance().getMqttPortProtocol(port);
         utils::Logger::instance().info(QString(" 使用缓存协议: 端口%1 → %2")
             .arg(port).arg(useSSL ? "TLS" : "TCP"));
+        addCandidate(port, useSSL);
     } else {
-        // 无缓存：根据端口号智能判断优先协议
+        // 无缓存：根据端口号智能判断优先协议，首选失败后尝试备选协议
+        bool useSSL;
         if (port >= 8000 && port < 9000) {
             // 8xxx端口：优先TLS
             useSSL = true;
@@ -177,136 +334,409 @@ void MqttWorker::connectToMqtt(const MqttConfig& config) {
             useSSL = true;
             utils::Logger::instance().info(QString(" 端口%1：默认优先TLS").arg(port));
         }
-        tryAlternate = true;  // 标记需要备选尝试
+        addCandidate(port, useSSL);
+        addCandidate(port, !useSSL);
     }
 
-    // 尝试连接
-    bool success = tryConnect(host, port, useSSL);
-    
-    if (!success && tryAlternate) {
-        // 首选协议失败，尝试备选协议
-        utils::Logger::instance().warn(QString("%1连接失败，尝试切换到%2")
-            .arg(useSSL ? "TLS" : "TCP")
-            .arg(useSSL ? "TCP" : "TLS"));
-        
-        useSSL = !useSSL;
-        success = tryConnect(host, port, useSSL);
+    startConnectProbes(host, candidates);
+}
+
+void MqttWorker::startConnectProbes(const QString& host, const QList<QPair<int, bool>>& candidates) {
+    // 上一轮未结束的探测全部作废（仍在握手的客户端保留到其回调到达）
+    cancelConnectProbes();
+
+    m_probeHost = host;
+    for (const auto& candidate : candidates) {
+        ConnectProbe probe;
+        probe.port = candidate.first;
+        probe.useSSL = candidate.second;
+
+        // 重连同一端点时复用原客户端：paho在客户端句柄内保存TLS会话，
+        // 再次connect时自动恢复会话（一次往返），新建客户端则需完整握手
+        if (m_client && !m_client->is_connected() &&
+            (!m_disconnectToken || m_disconnectToken->is_complete()) &&
+            m_client->get_server_uri() == probeUri(probe.port, probe.useSSL).toStdString()) {
+            probe.client = std::move(m_client);
+            m_disconnectToken.reset();
+            m_connected = false;
+        }
+        m_probes.push_back(std::move(probe));
     }
-    
-    if (success) {
-        // 连接成功，保存协议到缓存
-        utils::Config::instance().setMqttPortProtocol(port, useSSL);
-        utils::Logger::instance().info(QString(" 端口%1协议已缓存: %2")
-            .arg(port).arg(useSSL ? "TLS" : "TCP"));
-    } else {
-        emit errorOccurred(QString("MQTT连接失败: 无法连接到%1:%2").arg(host).arg(port));
+    // 未被复用的旧客户端不再需要
+    releaseClient();
+
+    m_probeTimer.start();
+    launchNextProbe();
+}
+
+void MqttWorker::launchNextProbe() {
+    QList<int> remaining;
+    for (int i = 0; i < static_cast<int>(m_probes.size()); ++i) {
+        if (!m_probes[i].failed) {
+            remaining.append(i);
+        }
+    }
+
+    if (remaining.isEmpty()) {
+        failConnectProbes();
+        return;
+    }
+    if (remaining.size() == 1) {
+        // 只剩一个候选：探测传输层只会多一次往返，直接连接
+        m_transportRace->cancel();
+        connectProbe(remaining.first());
+        return;
+    }
+
+    // 多个候选：错开并发探测传输层，只在首个可达者上发起MQTT CONNECT（同一client_id只有一个会话）
+    QList<TransportCandidate> candidates;
+    for (int index : remaining) {
+        TransportCandidate candidate;
+        candidate.host = m_probeHost;
+        candidate.port = m_probes[index].port;
+        candidate.useSSL = m_probes[index].useSSL;
+        candidates.append(candidate);
     }
+    m_raceProbes = remaining;
+    m_transportRace->setSslConfiguration(probeSslConfiguration());
+    m_transportRace->start(candidates);
 }
 
-bool MqttWorker::tryConnect(const QString& host, int port, bool useSSL) {
+void MqttWorker::connectProbe(int index) {
+    // 被取消的客户端仍在握手：等其回调后再发起，同一client_id同时只有一个CONNECT
+    if (hasBlockingRetiredProbe()) {
+        m_pendingProbe = index;
+        m_probeTimeoutTimer->start(CONNECT_TIMEOUT_MS + PROBE_WATCHDOG_GRACE_MS);
+        return;
+    }
+    m_pendingProbe = -1;
+
+    ConnectProbe& probe = m_probes[index];
     try {
-        QString protocol = useSSL ? "ssl" : "tcp";
-        QString serverUri = QString("%1://%2:%3").arg(protocol, host).arg(port);
-        
         // 已移除敏感的MQTT连接详情日志
 
-        // 创建MQTT客户端
-        m_client = std::make_unique<mqtt::async_client>(
-            serverUri.toStdString(),
-            m_config.client_id.toStdString()
-        );
+        if (!probe.client) {
+            probe.client = std::make_unique<mqtt::async_client>(
+                probeUri(probe.port, probe.useSSL).toStdString(),
+                m_config.client_id.toStdString()
+            );
+        }
+
+        // 用户上下文携带探测编号：过期/已取消探测的回调据此识别
+        probe.context = m_nextProbeContext++;
+        m_activeProbe = index;
+        probe.client->connect(buildConnectOptions(probe.useSSL),
+                              reinterpret_cast<void*>(static_cast<quintptr>(probe.context)),
+                              *m_connectListener);
+    } catch (...) {
+        // 客户端创建或发起连接失败：在剩余候选中继续
+        m_activeProbe = -1;
+        probe.failed = true;
+        launchNextProbe();
+        return;
+    }
+
+    // paho自身在CONNECT_TIMEOUT_MS后结束连接，看门狗只防回调丢失
+    m_probeTimeoutTimer->start(CONNECT_TIMEOUT_MS + PROBE_WATCHDOG_GRACE_MS);
+}
+
+void MqttWorker::onTransportRaceWon(int index, qint64 elapsedMs) {
+    if (index < 0 || index >= m_raceProbes.size()) {
+        return;
+    }
+    const int probeIndex = m_raceProbes[index];
+    utils::Logger::instance().info(QString(" 端口%1(%2)可达，用时%3ms，发起MQTT连接")
+        .arg(m_probes[probeIndex].port).arg(m_probes[probeIndex].useSSL ? "TLS" : "TCP").arg(elapsedMs));
+    connectProbe(probeIndex);
+}
+
+void MqttWorker::onTransportRaceResolved(int preferredIndex) {
+    if (!m_cacheOnResolve) {
+        return;  // 尚未连上：连上时读取preferredIndex()
+    }
+    m_cacheOnResolve = false;
+    const TransportCandidate& preferred = m_transportRace->candidate(preferredIndex);
+    cachePortProtocol(preferred.port, preferred.useSSL);
+}
+
+void MqttWorker::onTransportRaceFailed() {
+    QStringList unreachable;
+    for (int index : m_raceProbes) {
+        m_probes[index].failed = true;
+        unreachable.append(QString("%1(%2)").arg(m_probes[index].port).arg(m_probes[index].useSSL ? "TLS" : "TCP"));
+    }
+    utils::Logger::instance().warn(QString("候选端口均不可达: %1").arg(unreachable.join(", ")));
+    launchNextProbe();
+}
+
+void MqttWorker::onConnectProbeFinished(quint64 context, bool success) {
+    auto retired = m_retiredProbes.find(context);
+    if (retired != m_retiredProbes.end()) {
+        // 已取消的探测迟到连上：断开后再释放，断开完成的回调同样走到这里
+        RetiredProbe& probe = retired->second;
+        probe.blocking = false;
+        bool closing = false;
+        if (success && !probe.closing && probe.client->is_connected()) {
+            probe.closing = true;
+            try {
+                probe.client->disconnect(0, reinterpret_cast<void*>(static_cast<quintptr>(context)),
+                                         *m_connectListener);
+                closing = true;
+            } catch (...) {
+            }
+        }
+        if (!closing) {
+            m_retiredProbes.erase(retired);
+        }
+        // 本轮在等这个客户端结束：现在可以发起连接
+        if (m_pendingProbe >= 0 && !hasBlockingRetiredProbe()) {
+            m_probeTimeoutTimer->stop();
+            connectProbe(m_pendingProbe);
+        }
+        return;
+    }
+
+    if (m_activeProbe < 0 || m_probes[m_activeProbe].context != context) {
+        return;  // 已作废的一轮
+    }
+
+    m_probeTimeoutTimer->stop();
+    ConnectProbe& probe = m_probes[m_activeProbe];
+    m_activeProbe = -1;
+
+    if (!success) {
+        utils::Logger::instance().warn(QString("端口%1(%2)连接失败")
+            .arg(probe.port).arg(probe.useSSL ? "TLS" : "TCP"));
+        // 传输层可达但MQTT连接失败（认证、TLS参数等）：在剩余候选中继续
+        probe.failed = true;
+        launchNextProbe();
+        return;
+    }
 
-        // 设置回调
+    // 连上即胜出：接管客户端，其余候选直接丢弃
+    m_client = std::move(probe.client);
+    if (!m_callback) {
+        // 回调对象随工作者存活（复用的客户端上可能仍挂着它）
         m_callback = std::make_unique<MqttCallback>(this);
-        m_client->set_callback(*m_callback);
+    }
+    m_client->set_callback(*m_callback);
+
+    const int port = probe.port;
+    const bool useSSL = probe.useSSL;
+    m_probeTimeoutTimer->stop();
+    m_probes.clear();
+    m_pendingProbe = -1;
+
+    // 排在胜者之前的候选仍在探测：出结果后再按最高优先的可达候选写缓存
+    if (m_transportRace->isResolving()) {
+        m_cacheOnResolve = true;
+        utils::Logger::instance().info(QString(" 端口%1(%2)连接成功，用时%3ms，更高优先候选探测未结束，稍后写入缓存")
+            .arg(port).arg(useSSL ? "TLS" : "TCP").arg(m_probeTimer.elapsed()));
+    } else if (m_transportRace->preferredIndex() >= 0) {
+        const TransportCandidate& preferred = m_transportRace->candidate(m_transportRace->preferredIndex());
+        cachePortProtocol(preferred.port, preferred.useSSL);
+    } else {
+        cachePortProtocol(port, useSSL);
+    }
 
-        // 配置连接选项
-        mqtt::connect_options connOpts;
-        connOpts.set_keep_alive_interval(120); // 120秒心跳
-        connOpts.set_clean_session(true);
-        
-        if (!m_config.username.isEmpty()) {
-            connOpts.set_user_name(m_config.username.toStdString());
+    // 记录最近可用端点，断线重连时直接使用
+    m_hasLastGood = true;
+    m_lastGoodHost = m_probeHost;
+    m_lastGoodPort = port;
+    m_lastGoodSSL = useSSL;
+    m_fastPath = false;
+    m_fastPathFailed = false;
+    m_reconnecting = false;
+    m_backoff.reset();
+
+    m_connected = true;
+    emit connected();
+}
+
+void MqttWorker::cachePortProtocol(int port, bool useSSL) {
+    // 看门狗放弃的TLS尝试仍未结束时，不把明文结果写入缓存（避免降级被固化）
+    bool tlsPending = false;
+    for (const auto& entry : m_retiredProbes) {
+        tlsPending = tlsPending || (entry.second.useSSL && !entry.second.closing);
+    }
+    if (!useSSL && tlsPending) {
+        utils::Logger::instance().info(QString(" 端口%1(TCP)可用，TLS尝试未结束，暂不缓存，用时%2ms")
+            .arg(port).arg(m_probeTimer.elapsed()));
+        return;
+    }
+    utils::Config::instance().setMqttPortProtocol(port, useSSL);
+    utils::Logger::instance().info(QString(" 端口%1(%2)已缓存，用时%3ms")
+        .arg(port).arg(useSSL ? "TLS" : "TCP").arg(m_probeTimer.elapsed()));
+}
+
+void MqttWorker::onConnectProbeTimeout() {
+    if (m_activeProbe < 0) {
+        if (m_pendingProbe < 0) {
+            return;
         }
-        if (!m_config.password.isEmpty()) {
-            connOpts.set_password(m_config.password.toStdString());
+        // 等待的已取消客户端超过paho连接超时仍无回调：不再等待
+        for (auto& entry : m_retiredProbes) {
+            entry.second.blocking = false;
         }
+        connectProbe(m_pendingProbe);
+        return;
+    }
+    ConnectProbe& probe = m_probes[m_activeProbe];
+    utils::Logger::instance().warn(QString("端口%1(%2)连接超时")
+        .arg(probe.port).arg(probe.useSSL ? "TLS" : "TCP"));
+    probe.failed = true;
+    // 回调未到的客户端移入退役表保持存活，再在剩余候选中继续
+    retireActiveProbe(false);
+    launchNextProbe();
+}
 
-        // 只在8883端口时启用TLS/SSL配置
-        if (useSSL) {
-            // SSL/TLS加密已启用
-            
-            mqtt::ssl_options sslopts;
-            sslopts.set_verify(true);
-            sslopts.set_enable_server_cert_auth(true);
-            
-            // 1. 优先从Qt资源系统读取（打包到程序中）
-            QString certPath = ":/cacert.pem";
-            if (QFile::exists(certPath)) {
-                // 从资源中提取到临时文件（OpenSSL需要文件路径）
-                QString tempCertPath = QDir::temp().filePath("xiaozhi_cacert.pem");
-                // 如果临时文件已存在，先删除
-                if (QFile::exists(tempCertPath)) {
-                    QFile::remove(tempCertPath);
-                }
-                if (QFile::copy(certPath, tempCertPath)) {
-                    QFile::setPermissions(tempCertPath, QFile::ReadOwner | QFile::WriteOwner);
-                    sslopts.set_trust_store(tempCertPath.toStdString());
-                    // 已加载CA证书
-                } else {
-                    // 尝试外部证书
-                }
-            }
-            
-            // 如果内置证书加载失败，尝试外部证书
-            if (!QFile::exists(certPath) || !QFile::exists(QDir::temp().filePath("xiaozhi_cacert.pem"))) {
-                // 2. 尝试程序目录
-                certPath = QCoreApplication::applicationDirPath() + "/cacert.pem";
-                if (QFile::exists(certPath)) {
-                    sslopts.set_trust_store(certPath.toStdString());
-                    // 已加载外部CA证书
-                } else {
-                    // 3. 尝试当前目录
-                    certPath = "cacert.pem";
-                    if (QFile::exists(certPath)) {
-                        sslopts.set_trust_store(certPath.toStdString());
-                        // 已加载CA证书
-                    } else {
-                        // 未找到CA证书
-                    }
-                }
-            }
-            
-            connOpts.set_ssl(sslopts);
-        } else {
-            // TCP连接
+bool MqttWorker::hasBlockingRetiredProbe() const {
+    for (const auto& entry : m_retiredProbes) {
+        if (entry.second.blocking) {
+            return true;
         }
+    }
+    return false;
+}
 
-        // 同步连接（设置超时为5秒）
-        m_client->connect(connOpts)->wait_for(std::chrono::seconds(5));
+void MqttWorker::retireActiveProbe(bool blocking) {
+    if (m_activeProbe < 0) {
+        return;
+    }
+    ConnectProbe& probe = m_probes[m_activeProbe];
+    m_activeProbe = -1;
+    if (!probe.client) {
+        return;
+    }
+    RetiredProbe retired;
+    retired.useSSL = probe.useSSL;
+    retired.blocking = blocking;
+    retired.client = std::move(probe.client);
+    m_retiredProbes.emplace(probe.context, std::move(retired));
+}
+
+void MqttWorker::cancelConnectProbes() {
+    m_probeTimeoutTimer->stop();
+    m_transportRace->cancel();
+    m_raceProbes.clear();
+    m_cacheOnResolve = false;
+
+    // 正在握手的客户端必须等到连接回调（paho仍持有该连接），未发起的候选直接释放
+    retireActiveProbe(true);
+    m_probes.clear();
+    m_pendingProbe = -1;
+}
+
+void MqttWorker::failConnectProbes() {
+    QStringList tried;
+    for (const ConnectProbe& probe : m_probes) {
+        tried.append(QString("%1(%2)").arg(probe.port).arg(probe.useSSL ? "TLS" : "TCP"));
+    }
+    const QString host = m_probeHost;
+    cancelConnectProbes();
+
+    if (m_fastPath) {
+        // 最近可用端点不再可用：下一次重连重新探测全部候选
+        m_fastPath = false;
+        m_fastPathFailed = true;
+    }
+
+    emit errorOccurred(QString("MQTT连接失败: 无法连接到%1 (尝试了%2)").arg(host, tried.join(", ")));
+
+    if (m_reconnecting) {
+        scheduleReconnect();
+    }
+}
+
+QSslConfiguration MqttWorker::probeSslConfiguration() const {
+    // 与buildConnectOptions的TLS选项一致：校验服务器证书，CA取自同一证书包
+    // 证书包在进程内只解析一次
+    static const QList<QSslCertificate> caCertificates = [] {
+        const QString trustStore = TlsSessionCache::instance().trustStorePath();
+        return trustStore.isEmpty() ? QList<QSslCertificate>()
+                                    : QSslCertificate::fromPath(trustStore, QSsl::Pem);
+    }();
+
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setPeerVerifyMode(QSslSocket::VerifyPeer);
+    if (!caCertificates.isEmpty()) {
+        config.setCaCertificates(caCertificates);
+    }
+    return config;
+}
+
+QString MqttWorker::probeUri(int port, bool useSSL) const {
+    return QString("%1://%2:%3").arg(useSSL ? "ssl" : "tcp", m_probeHost).arg(port);
+}
+
+mqtt::connect_options MqttWorker::buildConnectOptions(bool useSSL) const {
+    // 配置连接选项
+    mqtt::connect_options connOpts;
+    connOpts.set_keep_alive_interval(120); // 120秒心跳
+    connOpts.set_clean_session(true);
+    connOpts.set_connect_timeout(std::chrono::milliseconds(CONNECT_TIMEOUT_MS));
+    
+    if (!m_config.username.isEmpty()) {
+        connOpts.set_user_name(m_config.username.toStdString());
+    }
+    if (!m_config.password.isEmpty()) {
+        connOpts.set_password(m_config.password.toStdString());
+    }
+
+    // 只在TLS候选时启用TLS/SSL配置
+    if (useSSL) {
+        // SSL/TLS加密已启用
         
-        m_connected = true;
-        emit connected();
+        mqtt::ssl_options sslopts;
+        sslopts.set_verify(true);
+        sslopts.set_enable_server_cert_auth(true);
+        
+        // CA证书包在进程内只提取一次（不再每次连接删除重写临时文件）
+        const QString trustStore = TlsSessionCache::instance().trustStorePath();
+        if (!trustStore.isEmpty()) {
+            sslopts.set_trust_store(trustStore.toStdString());
+        }
         
-        return true;  // 连接成功
+        connOpts.set_ssl(sslopts);
+    }
 
-    } catch (const mqtt::exception& e) {
-        // 连接失败
-        return false;
+    return connOpts;
+}
+
+void MqttWorker::releaseClient() {
+    if (!m_client) {
+        return;
+    }
+
+    mqtt::token_ptr token = std::move(m_disconnectToken);
+    try {
+        // 移交后不再向本工作者转发连接事件与消息
+        m_client->disable_callbacks();
+        if (!token && m_client->is_connected()) {
+            token = m_client->disconnect();
+        }
     } catch (...) {
-        // 连接失败
-        return false;
     }
+    m_connected = false;
+    ClosingClients::instance().add(std::move(m_client), std::move(token), m_connectListener, m_publishListener);
 }
 
 void MqttWorker::disconnect() {
+    // 主动断开：停止自动重连
+    m_autoReconnect = false;
+    m_reconnecting = false;
+    m_reconnectTokenHeld = false;
+    m_reconnectTimer->stop();
+    cancelConnectProbes();
+    clearPublishQueue();
     if (m_client && m_connected) {
         try {
-            m_client->disconnect()->wait();
-            m_connected = false;
+            // 不在共享线程上等待：客户端保留到断开完成，复用或销毁时再处理
+            m_disconnectToken = m_client->disconnect();
         } catch (const mqtt::exception& e) {
             emit errorOccurred(QString("MQTT断开失败: %1").arg(e.what()));
         }
+        m_connected = false;
     }
 }
 
@@ -422,7 +852,8 @@ void MqttWorker::sendStopListening(const QString& sessionId) {
     listenMsg["type"] = "listen";
     listenMsg["state"] = "stop";
 
-    publish(m_config.publish_topic, listenMsg, 0);
+    // 插队：用户松开按键后服务器应尽快开始识别
+    publish(m_config.publish_topic, listenMsg, 0, true);
 }
 
 void MqttWorker::sendAbort(const QString& sessionId, const QString& reason) {
@@ -434,7 +865,8 @@ void MqttWorker::sendAbort(const QString& sessionId, const QString& reason) {
         abortMsg["reason"] = reason;
     }
 
-    publish(m_config.publish_topic, abortMsg, 0);
+    // 插队：打断（barge-in）不能排在其他控制消息之后
+    publish(m_config.publish_topic, abortMsg, 0, true);
 }
 
 void MqttWorker::sendGoodbye(const QString& sessionId) {
@@ -458,20 +890,34 @@ void MqttWorker::sendRawMessage(const QString& topic, const QJsonObject& message
     publish(topic, message, 0);
 }
 
+void MqttWorker::sendRawPayload(const QString& topic, const QByteArray& payload, const QString& type) {
+    // paho的消息负载为std::string，入队时拷贝一次
+    publishPayload(topic, payload.toStdString(), type, 0);
+}
+
 void MqttWorker::onMqttConnected() {
-    emit connected();
+    // 连接结果统一由探测回调发出（复用的客户端重连时paho也会触发此回调，避免重复通知）
 }
 
 void MqttWorker::onMqttDisconnected(int rc) {
     m_connected = false;
+    clearPublishQueue();
     emit disconnected(rc);
     
-    // 启动自动重连
-    if (rc != 0) {
-        m_reconnectTimer->start();
+    // 启动自动重连（退避 + 全局限速）
+    if (rc != 0 && m_autoReconnect) {
+        m_reconnecting = true;
+        scheduleReconnect();
     }
 }
 
+void MqttWorker::scheduleReconnect() {
+    const int delayMs = m_backoff.nextDelayMs();
+    m_reconnectTokenHeld = false;
+    m_reconnectTimer->start(delayMs);
+    utils::Logger::instance().info(QString(" MQTT将在%1ms后重连（第%2次）").arg(delayMs).arg(m_backoff.attempts()));
+}
+
 void MqttWorker::onMqttMessage(const QString& topic, const QString& payload) {
     try {
         // 解析JSON消息
@@ -524,32 +970,168 @@ void MqttWorker::onMqttMessage(const QString& topic, const QString& payload) {
 }
 
 void MqttWorker::attemptReconnect() {
-    if (!m_connected && !m_config.endpoint.isEmpty()) {
-        connectToMqtt(m_config);
+    if (m_connected || !m_autoReconnect || m_config.endpoint.isEmpty()) {
+        return;
+    }
+
+    // 全局令牌桶：服务器重启后所有设备的重连在进程内错开
+    if (!m_reconnectTokenHeld) {
+        const int waitMs = ReconnectThrottle::instance().reserveDelayMs();
+        if (waitMs > 0) {
+            m_reconnectTokenHeld = true;
+            m_reconnectTimer->start(waitMs);
+            return;
+        }
     }
+    m_reconnectTokenHeld = false;
+
+    // 快速路径：直接连最近可用端点（复用客户端以恢复TLS会话），失败后再完整探测
+    const QString host = m_config.endpoint.section(':', 0, 0);
+    if (m_hasLastGood && !m_fastPathFailed && host == m_lastGoodHost) {
+        QList<QPair<int, bool>> candidates;
+        candidates.append(qMakePair(m_lastGoodPort, m_lastGoodSSL));
+        m_fastPath = true;
+        startConnectProbes(host, candidates);
+        return;
+    }
+
+    m_fastPathFailed = false;
+    connectWithDiscovery();
 }
 
-bool MqttWorker::publish(const QString& topic, const QJsonObject& message, int qos) {
+bool MqttWorker::publish(const QString& topic, const QJsonObject& message, int qos, bool priority) {
     if (!m_client || !m_connected) {
         return false;
     }
 
-    try {
-        QJsonDocument doc(message);
-        QString payloadStr = doc.toJson(QJsonDocument::Compact);
-        
-        // 已移除MQTT发送消息详情日志（敏感信息）
-        
-        auto msg = mqtt::make_message(topic.toStdString(), payloadStr.toStdString());
-        msg->set_qos(qos);
-        
-        m_client->publish(msg)->wait();
-        return true;
+    return publishPayload(topic, QJsonDocument(message).toJson(QJsonDocument::Compact).toStdString(),
+                          message["type"].toString(), qos, priority);
+}
 
-    } catch (const mqtt::exception& e) {
-        utils::Logger::instance().error(QString("MQTT发送失败: %1").arg(e.what()));
+bool MqttWorker::publishPayload(const QString& topic, std::string payload, const QString& type,
+                                int qos, bool priority) {
+    if (!m_client || !m_connected) {
         return false;
     }
+
+    OutboundMessage outbound;
+    outbound.id = m_nextPublishId++;
+    outbound.topic = topic.toStdString();
+    outbound.payload = std::move(payload);
+    outbound.type = type;
+    outbound.qos = qos;
+    outbound.priority = priority;
+    outbound.enqueuedMs = m_publishClock.elapsed();
+
+    // 已移除MQTT发送消息详情日志（敏感信息）
+
+    if (m_outbound.size() >= MAX_OUTBOUND_QUEUE) {
+        // 队列已满：高优先级消息挤掉最新的普通消息，普通消息直接丢弃
+        if (!priority || m_outbound.back().priority) {
+            ++m_publishDropped;
+            utils::Logger::instance().warn(QString("MQTT发送队列已满，丢弃消息: %1").arg(outbound.type));
+            publishQueueStats(true);
+            return false;
+        }
+        m_outbound.pop_back();
+        ++m_publishDropped;
+    }
+
+    if (priority) {
+        // 插到已有高优先级消息之后、普通消息之前
+        auto it = m_outbound.begin();
+        while (it != m_outbound.end() && it->priority) {
+            ++it;
+        }
+        m_outbound.insert(it, std::move(outbound));
+    } else {
+        m_outbound.push_back(std::move(outbound));
+    }
+    m_maxQueued = qMax(m_maxQueued, static_cast<int>(m_outbound.size()));
+
+    pumpPublishQueue();
+    return true;
+}
+
+void MqttWorker::pumpPublishQueue() {
+    while (!m_outbound.empty() && m_inFlight.size() < MAX_PUBLISH_IN_FLIGHT) {
+        if (!m_client || !m_connected) {
+            return;
+        }
+
+        const quint64 id = m_outbound.front().id;
+        auto msg = mqtt::make_message(m_outbound.front().topic, m_outbound.front().payload);
+        msg->set_qos(m_outbound.front().qos);
+        auto inserted = m_inFlight.emplace(id, std::move(m_outbound.front())).first;
+        m_outbound.pop_front();
+
+        try {
+            // 以发布编号作为用户上下文，完成时由监听器投递回本线程
+            m_client->publish(msg, reinterpret_cast<void*>(static_cast<quintptr>(id)), *m_publishListener);
+        } catch (const mqtt::exception& e) {
+            const QString type = inserted->second.type;
+            const qint64 latencyMs = m_publishClock.elapsed() - inserted->second.enqueuedMs;
+            m_inFlight.erase(inserted);
+            ++m_publishFailed;
+            utils::Logger::instance().error(QString("MQTT发送失败: %1").arg(e.what()));
+            emit publishCompleted(type, false, latencyMs);
+        }
+    }
+    publishQueueStats(false);
+}
+
+void MqttWorker::onPublishFinished(quint64 id, bool success, int returnCode) {
+    auto it = m_inFlight.find(id);
+    if (it == m_inFlight.end()) {
+        return;  // 断开时已清理，或来自重连前的旧客户端
+    }
+
+    const QString type = it->second.type;
+    const qint64 latencyMs = m_publishClock.elapsed() - it->second.enqueuedMs;
+    m_inFlight.erase(it);
+
+    if (success) {
+        ++m_published;
+        m_latencySumMs += latencyMs;
+        m_latencyMaxMs = qMax(m_latencyMaxMs, latencyMs);
+    } else {
+        ++m_publishFailed;
+        utils::Logger::instance().error(QString("MQTT发送失败: %1 (rc=%2)").arg(type).arg(returnCode));
+    }
+    emit publishCompleted(type, success, latencyMs);
+
+    pumpPublishQueue();
+}
+
+void MqttWorker::clearPublishQueue() {
+    if (m_outbound.empty() && m_inFlight.empty()) {
+        return;
+    }
+
+    // 未发出的消息在重连后已无意义（会话已失效），直接丢弃
+    m_publishDropped += m_outbound.size();
+    m_publishFailed += m_inFlight.size();
+    m_outbound.clear();
+    m_inFlight.clear();
+    publishQueueStats(true);
+}
+
+void MqttWorker::publishQueueStats(bool force) {
+    if (!force && m_statsClock.isValid() && m_statsClock.elapsed() < PUBLISH_STATS_INTERVAL_MS) {
+        return;
+    }
+    m_statsClock.restart();
+
+    QVariantMap stats;
+    stats["queued"] = static_cast<int>(m_outbound.size());
+    stats["inFlight"] = static_cast<int>(m_inFlight.size());
+    stats["maxQueued"] = m_maxQueued;
+    stats["published"] = m_published;
+    stats["failed"] = m_publishFailed;
+    stats["dropped"] = m_publishDropped;
+    stats["avgLatencyMs"] = m_published > 0 ? static_cast<double>(m_latencySumMs) / m_published : 0.0;
+    stats["maxLatencyMs"] = m_latencyMaxMs;
+    emit publishStatsUpdated(stats);
 }
 
 void MqttWorker::handleEsp32Message(const QJsonObject& message) {
@@ -571,10 +1153,10 @@ void MqttWorker::handleEsp32Message(const QJsonObject& message) {
 
 MqttManager::MqttManager(QObject* parent)
     : QObject(parent)
-    , m_workerThread(new QThread(this))
+    , m_workerThread(NetworkThreadPool::instance().acquire(NetworkThreadPool::Lane::Io))
     , m_worker(new MqttWorker())
 {
-    // 将worker移到工作线程
+    // 将worker移到共享网络线程
     m_worker->moveToThread(m_workerThread);
 
     // 连接信号
@@ -604,6 +1186,8 @@ MqttManager::MqttManager(QObject* parent)
             m_worker, &MqttWorker::sendMcpMessage);
     connect(this, &MqttManager::sendRawMessageInternal,
             m_worker, &MqttWorker::sendRawMessage);
+    connect(this, &MqttManager::sendRawPayloadInternal,
+            m_worker, &MqttWorker::sendRawPayload);
 
     connect(m_worker, &MqttWorker::connected,
             this, &MqttManager::connected);
@@ -613,17 +1197,21 @@ MqttManager::MqttManager(QObject* parent)
             this, &MqttManager::messageReceived);
     connect(m_worker, &MqttWorker::udpConfigReceived,
             this, &MqttManager::udpConfigReceived);
+    connect(m_worker, &MqttWorker::publishCompleted,
+            this, &MqttManager::publishCompleted);
+    connect(m_worker, &MqttWorker::publishStatsUpdated,
+            this, [this](const QVariantMap& stats) {
+        m_publishStats = stats;
+        emit publishStatsUpdated(stats);
+    });
     connect(m_worker, &MqttWorker::errorOccurred,
             this, &MqttManager::errorOccurred);
 
-    // 启动工作线程
-    m_workerThread->start();
 }
 
 MqttManager::~MqttManager() {
-    m_workerThread->quit();
-    m_workerThread->wait();
-    delete m_worker;
+    // 共享线程继续服务其他设备，只在其中销毁本工作者
+    NetworkThreadPool::instance().retire(m_worker);
 }
 
 void MqttManager::connectToMqtt(const MqttConfig& config) {
@@ -678,6 +1266,10 @@ void MqttManager::sendRawMessage(const QString& topic, const QJsonObject& messag
     emit sendRawMessageInternal(topic, message);
 }
 
+void MqttManager::sendRawPayload(const QString& topic, const QByteArray& payload, const QString& type) {
+    emit sendRawPayloadInternal(topic, payload, type);
+}
+
 } // namespace network
 } // namespace xiaozhi
 
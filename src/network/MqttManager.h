@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:31:00Z
+Updated: 2026-10-17T18:00:00Z
 File: MqttManager.h
 Desc: MQTT连接管理器（线程方式，复刻esp32_simulator_gui.py第358-803行）
 */
@@ -12,12 +12,23 @@ Desc: MQTT连接管理器（线程方式，复刻esp32_simulator_gui.py第358-80
 #define MQTT_MANAGER_H
 
 #include "NetworkTypes.h"
+#include "ReconnectThrottle.h"
+#include "TransportRace.h"
 #include <QObject>
 #include <QThread>
 #include <QTimer>
 #include <QJsonObject>
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include <QList>
+#include <QMutex>
+#include <QPair>
 #include <mqtt/async_client.h>
+#include <deque>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace xiaozhi {
 namespace network {
@@ -38,8 +49,72 @@ private:
     QObject* m_parent;
 };
 
+/**
+ * @brief MQTT候选端点连接结果回调（paho线程中调用，转发到工作线程）
+ * 注意：此类不继承QObject，以用户上下文携带探测编号。
+ * 断开中的客户端移交后可能晚于工作者被回调，工作者析构前detach
+ */
+class MqttConnectListener : public virtual mqtt::iaction_listener {
+public:
+    explicit MqttConnectListener(QObject* parent);
+
+    void on_success(const mqtt::token& tok) override;
+    void on_failure(const mqtt::token& tok) override;
+
+    /**
+     * @brief 解除与工作者的关联（之后的回调直接丢弃）
+     */
+    void detach();
+
+private:
+    QMutex m_mutex;
+    QObject* m_parent;
+};
+
+/**
+ * @brief MQTT发布完成回调（paho线程中调用，转发到工作线程）
+ * 注意：此类不继承QObject，以用户上下文携带发布编号。
+ * 断开中的客户端移交后可能晚于工作者被回调，工作者析构前detach
+ */
+class MqttPublishListener : public virtual mqtt::iaction_listener {
+public:
+    explicit MqttPublishListener(QObject* parent);
+
+    void on_success(const mqtt::token& tok) override;
+    void on_failure(const mqtt::token& tok) override;
+
+    /**
+     * @brief 解除与工作者的关联（之后的回调直接丢弃）
+     */
+    void detach();
+
+private:
+    QMutex m_mutex;
+    QObject* m_parent;
+};
+
 /**
  * @brief MQTT工作线程
+ *
+ * 发布全部异步：消息先进入有界发送队列，按在途窗口交给paho，
+ * 完成结果经MqttPublishListener回到本线程；不再逐条wait()阻塞工作线程。
+ * abort与listen stop插队到队首（仅排在其他高优先级消息之后），保证打断及时送达
+ *
+ * 连接同样异步，分两步：多个候选(端口, TLS)先由TransportRace并发探测传输层
+ * （TCP建连，TLS候选含握手，按PROBE_STAGGER_MS错开发起），首个可达者胜出、其余立即中止；
+ * 随后只在胜出端点上以原client_id发起MQTT CONNECT，因此不会有两个同ID的会话互相踢下线。
+ * 端口被过滤时回退耗时约为一个错开间隔，而不是逐个等待连接超时。
+ * TLS握手进行中的高优先候选不会被明文抢先；排在胜者之前的候选出结果后才写入端口协议缓存，
+ * 避免一次慢握手把降级结果固化。胜出端点MQTT连接失败时在剩余候选中重新探测。
+ * 被取消的客户端保持存活到其连接回调，迟到连上的再断开。
+ * 只有一个候选（含断线重连的快速路径）时跳过探测直接连接；
+ * 重连同一端点时复用原客户端句柄，由paho恢复TLS会话。
+ *
+ * 断线重连按指数退避（decorrelated jitter）间隔，并受进程级ReconnectThrottle限速；
+ * 重连先直连最近可用端点，失败后才重新探测全部候选
+ *
+ * 工作者位于共享Io线程，断开不wait()：客户端保留到断开完成，
+ * 销毁或换用新客户端时移交给进程级的关闭队列（连同监听器）
  */
 class MqttWorker : public QObject {
     Q_OBJECT
@@ -124,6 +199,14 @@ public slots:
      */
     void sendRawMessage(const QString& topic, const QJsonObject& message);
 
+    /**
+     * @brief 发送已序列化的消息（大消息流式构建后直接入队，不再解析/序列化）
+     * @param topic MQTT主题
+     * @param payload UTF-8 JSON
+     * @param type 消息type字段（统计与回调用）
+     */
+    void sendRawPayload(const QString& topic, const QByteArray& payload, const QString& type);
+
 signals:
     /**
      * @brief MQTT连接成功
@@ -145,6 +228,20 @@ signals:
      */
     void udpConfigReceived(const UdpConfig& config, const QString& sessionId);
 
+    /**
+     * @brief 消息发布完成
+     * @param type 消息type字段
+     * @param success 是否成功交付（QoS0为写入套接字，QoS1为收到PUBACK）
+     * @param latencyMs 从入队到完成的耗时
+     */
+    void publishCompleted(const QString& type, bool success, qint64 latencyMs);
+
+    /**
+     * @brief 发送队列统计更新（有发布活动时约每秒一次）
+     * @param stats queued/inFlight/maxQueued/published/failed/dropped/avgLatencyMs/maxLatencyMs
+     */
+    void publishStatsUpdated(const QVariantMap& stats);
+
     /**
      * @brief 发生错误
      */
@@ -171,11 +268,77 @@ private slots:
      */
     void attemptReconnect();
 
+    /**
+     * @brief 发布完成（由MqttPublishListener投递）
+     */
+    void onPublishFinished(quint64 id, bool success, int returnCode);
+
+    /**
+     * @brief 候选端点连接或已取消客户端断开完成（由MqttConnectListener投递）
+     */
+    void onConnectProbeFinished(quint64 context, bool success);
+
+    /**
+     * @brief 当前候选超过paho连接超时仍无回调
+     */
+    void onConnectProbeTimeout();
+
+    /**
+     * @brief 传输层探测决出可达候选（在其上发起MQTT连接）
+     */
+    void onTransportRaceWon(int index, qint64 elapsedMs);
+
+    /**
+     * @brief 排在胜者之前的候选均已出结果（决定写入缓存的端口协议）
+     */
+    void onTransportRaceResolved(int preferredIndex);
+
+    /**
+     * @brief 参与探测的候选传输层全部不可达
+     */
+    void onTransportRaceFailed();
+
 private:
     /**
-     * @brief 发布MQTT消息
+     * @brief 待发送消息
+     */
+    struct OutboundMessage {
+        quint64 id = 0;
+        std::string topic;
+        std::string payload;
+        QString type;               // 消息type字段（统计与回调用）
+        int qos = 0;
+        bool priority = false;      // 插队消息（abort/listen stop）
+        qint64 enqueuedMs = 0;
+    };
+
+    /**
+     * @brief 发布MQTT消息（入队后立即返回）
+     * @param priority 为true时插到队首（排在已有高优先级消息之后）
+     * @return 是否已入队
+     */
+    bool publish(const QString& topic, const QJsonObject& message, int qos = 0, bool priority = false);
+
+    /**
+     * @brief 发布已序列化的负载（入队后立即返回）
+     */
+    bool publishPayload(const QString& topic, std::string payload, const QString& type,
+                        int qos = 0, bool priority = false);
+
+    /**
+     * @brief 按在途窗口将队列中的消息交给paho异步发布
+     */
+    void pumpPublishQueue();
+
+    /**
+     * @brief 丢弃队列与在途记录（断开时，在途计为失败）
+     */
+    void clearPublishQueue();
+
+    /**
+     * @brief 发布发送队列统计（force为false时按间隔节流）
      */
-    bool publish(const QString& topic, const QJsonObject& message, int qos = 0);
+    void publishQueueStats(bool force);
 
     /**
      * @brief 处理ESP32支持的消息类型
@@ -183,15 +346,144 @@ private:
     void handleEsp32Message(const QJsonObject& message);
 
     /**
-     * @brief 尝试连接MQTT（支持自动协议切换）
+     * @brief 候选端点探测
+     */
+    struct ConnectProbe {
+        int port = 0;
+        bool useSSL = false;
+        quint64 context = 0;        // 发起连接时分配的探测编号
+        bool failed = false;        // 传输层不可达或MQTT连接失败
+        std::unique_ptr<mqtt::async_client> client;
+    };
+
+    /**
+     * @brief 已取消但连接回调未到的客户端
+     */
+    struct RetiredProbe {
+        bool useSSL = false;
+        bool blocking = false;      // 新候选须等其回调后再发起（被取消而非超时放弃）
+        bool closing = false;       // 迟到连上，正在断开
+        std::unique_ptr<mqtt::async_client> client;
+    };
+
+    /**
+     * @brief 按配置收集候选端点并发起探测
+     */
+    void connectWithDiscovery();
+
+    /**
+     * @brief 按退避间隔安排下一次重连
+     */
+    void scheduleReconnect();
+
+    /**
+     * @brief 对候选(端口, TLS)发起连接探测
      */
-    bool tryConnect(const QString& host, int port, bool useSSL);
+    void startConnectProbes(const QString& host, const QList<QPair<int, bool>>& candidates);
 
+    /**
+     * @brief 在尚未失败的候选中继续：多个时并发探测传输层，一个时直接连接，没有时结束本轮
+     */
+    void launchNextProbe();
+
+    /**
+     * @brief 在指定候选上发起MQTT连接（有被取消的客户端仍在握手时等其回调）
+     */
+    void connectProbe(int index);
+
+    /**
+     * @brief 写入端口协议缓存（已取消的TLS尝试未结束时不缓存明文结果）
+     */
+    void cachePortProtocol(int port, bool useSSL);
+
+    /**
+     * @brief TLS探测的证书配置（与paho的ssl_options一致）
+     */
+    QSslConfiguration probeSslConfiguration() const;
+
+    /**
+     * @brief 本轮所有候选均失败或超时
+     */
+    void failConnectProbes();
+
+    /**
+     * @brief 取消本轮探测（握手中的客户端移入m_retiredProbes等待其回调，传输层探测一并中止）
+     */
+    void cancelConnectProbes();
+
+    /**
+     * @brief 当前握手中的客户端移入m_retiredProbes
+     * @param blocking 为true时后续候选等其回调后再发起
+     */
+    void retireActiveProbe(bool blocking);
+
+    /**
+     * @brief 是否有必须等待回调的已取消客户端
+     */
+    bool hasBlockingRetiredProbe() const;
+
+    /**
+     * @brief 候选端点的服务器URI（ssl://或tcp://）
+     */
+    QString probeUri(int port, bool useSSL) const;
+
+    /**
+     * @brief 构建连接选项（含TLS证书配置）
+     */
+    mqtt::connect_options buildConnectOptions(bool useSSL) const;
+
+    /**
+     * @brief 交出当前客户端：未断开的先异步断开，断开完成前由关闭队列保持存活
+     */
+    void releaseClient();
+
+    // 监听器先于客户端声明，确保晚于客户端析构；与移交出去的断开中客户端共享
+    std::shared_ptr<MqttConnectListener> m_connectListener;
+    std::shared_ptr<MqttPublishListener> m_publishListener;
     std::unique_ptr<mqtt::async_client> m_client;
+    mqtt::token_ptr m_disconnectToken;                      // 主动断开进行中（不在工作线程上等待）
     std::unique_ptr<MqttCallback> m_callback;
     MqttConfig m_config;
     bool m_connected;
     QTimer* m_reconnectTimer;
+
+    // 连接探测
+    std::vector<ConnectProbe> m_probes;                     // 本轮候选（按优先顺序）
+    std::unordered_map<quint64, RetiredProbe> m_retiredProbes;  // 探测编号 → 等待回调的已取消客户端
+    QString m_probeHost;
+    TransportRace* m_transportRace;                         // 传输层并发探测
+    QList<int> m_raceProbes;                                // 参与传输层探测的候选序号（按探测序）
+    QTimer* m_probeTimeoutTimer;                            // 当前候选的回调看门狗
+    QElapsedTimer m_probeTimer;                             // 本轮耗时
+    quint64 m_nextProbeContext;
+    int m_activeProbe;                                      // 正在MQTT握手的候选（-1表示无）
+    int m_pendingProbe;                                     // 等待已取消客户端回调后再连接的候选（-1表示无）
+    bool m_cacheOnResolve;                                  // 已连上，待传输层探测出结果后写缓存
+
+    // 断线重连
+    ReconnectBackoff m_backoff;
+    bool m_autoReconnect;                                   // 上层发起连接后、主动断开前为true
+    bool m_reconnecting;                                    // 处于断线重连周期（探测失败会继续退避）
+    bool m_reconnectTokenHeld;                              // 已预约全局令牌，定时器到期即可重连
+    bool m_fastPath;                                        // 本轮探测为最近可用端点直连
+    bool m_fastPathFailed;                                  // 直连失败，下一次完整探测
+    bool m_hasLastGood;
+    QString m_lastGoodHost;
+    int m_lastGoodPort;
+    bool m_lastGoodSSL;
+
+    // 异步发送队列（仅工作线程访问）
+    std::deque<OutboundMessage> m_outbound;                 // 待交给paho的消息
+    std::unordered_map<quint64, OutboundMessage> m_inFlight; // 已交给paho、等待完成的消息
+    quint64 m_nextPublishId;
+    QElapsedTimer m_publishClock;                           // 入队/完成时间基准
+    QElapsedTimer m_statsClock;                             // 统计发布节流
+    quint64 m_published;
+    quint64 m_publishFailed;
+    quint64 m_publishDropped;
+    int m_maxQueued;
+    qint64 m_latencySumMs;
+    qint64 m_latencyMaxMs;
 };
 
 /**
@@ -279,6 +571,19 @@ public:
      */
     void sendRawMessage(const QString& topic, const QJsonObject& message);
 
+    /**
+     * @brief 发送已序列化的消息（大消息流式构建后直接入队，不再解析/序列化）
+     * @param topic MQTT主题
+     * @param payload UTF-8 JSON
+     * @param type 消息type字段（统计与回调用）
+     */
+    void sendRawPayload(const QString& topic, const QByteArray& payload, const QString& type);
+
+    /**
+     * @brief 最近一次发送队列统计（queued/inFlight/published/failed/dropped/延迟等）
+     */
+    QVariantMap publishStats() const { return m_publishStats; }
+
 signals:
     /**
      * @brief MQTT连接成功
@@ -300,6 +605,16 @@ signals:
      */
     void udpConfigReceived(const UdpConfig& config, const QString& sessionId);
 
+    /**
+     * @brief 消息发布完成
+     */
+    void publishCompleted(const QString& type, bool success, qint64 latencyMs);
+
+    /**
+     * @brief 发送队列统计更新
+     */
+    void publishStatsUpdated(const QVariantMap& stats);
+
     /**
      * @brief 发生错误
      */
@@ -319,10 +634,12 @@ signals:
     void sendGoodbyeInternal(const QString& sessionId);
     void sendMcpMessageInternal(const QString& sessionId, const QJsonObject& payload);
     void sendRawMessageInternal(const QString& topic, const QJsonObject& message);
+    void sendRawPayloadInternal(const QString& topic, const QByteArray& payload, const QString& type);
 
 private:
-    QThread* m_workerThread;
+    QThread* m_workerThread;        // 共享网络线程（NetworkThreadPool::Lane::Io）
     MqttWorker* m_worker;
+    QVariantMap m_publishStats;
 };
 
 } // namespace network
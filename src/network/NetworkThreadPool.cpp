@@ -0,0 +1,161 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T13:00:00Z
+File: NetworkThreadPool.cpp
+Desc: 共享网络线程池实现
+*/
+
+#include "NetworkThreadPool.h"
+#include "../utils/Logger.h"
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace xiaozhi {
+namespace network {
+
+NetworkThreadPool& NetworkThreadPool::instance() {
+    static NetworkThreadPool instance;
+    return instance;
+}
+
+NetworkThreadPool::NetworkThreadPool()
+    : m_shutdown(false)
+{
+    // 控制面线程大多在等网络，少量即可；实时音频线程按核数的一半，留出GUI与播放
+    const int cores = std::max(1, QThread::idealThreadCount());
+    m_maxIoThreads = std::clamp(cores / 2, 2, 4);
+    m_maxAudioThreads = std::clamp(cores / 2, 1, 8);
+
+    // 应用退出前停止线程（静态析构时事件循环已不可用）
+    if (QCoreApplication* app = QCoreApplication::instance()) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, []() {
+            NetworkThreadPool::instance().shutdown();
+        });
+    }
+}
+
+NetworkThreadPool::~NetworkThreadPool() {
+    shutdown();
+}
+
+QThread* NetworkThreadPool::acquire(Lane lane) {
+    QMutexLocker locker(&m_mutex);
+
+    Slot* best = nullptr;
+    int laneThreads = 0;
+    for (Slot& slot : m_slots) {
+        if (slot.lane != lane) {
+            continue;
+        }
+        ++laneThreads;
+        if (!best || slot.load < best->load) {
+            best = &slot;
+        }
+    }
+
+    const int limit = lane == Lane::Audio ? m_maxAudioThreads : m_maxIoThreads;
+    if (!best || (best->load > 0 && laneThreads < limit && !m_shutdown)) {
+        Slot slot;
+        slot.lane = lane;
+        slot.thread = new QThread();
+        slot.thread->setObjectName(QString("%1-%2")
+            .arg(lane == Lane::Audio ? "NetAudio" : "NetIo").arg(laneThreads));
+        slot.thread->start(lane == Lane::Audio ? QThread::TimeCriticalPriority
+                                               : QThread::NormalPriority);
+        m_slots.push_back(slot);
+        best = &m_slots.back();
+    }
+
+    ++best->load;
+    return best->thread;
+}
+
+void NetworkThreadPool::share(QThread* thread) {
+    QMutexLocker locker(&m_mutex);
+    for (Slot& slot : m_slots) {
+        if (slot.thread == thread) {
+            ++slot.load;
+            return;
+        }
+    }
+}
+
+void NetworkThreadPool::retire(QObject* worker) {
+    if (!worker) {
+        return;
+    }
+
+    QThread* thread = worker->thread();
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Slot& slot : m_slots) {
+            if (slot.thread == thread && slot.load > 0) {
+                --slot.load;
+                break;
+            }
+        }
+
+        // 工作者持有套接字/定时器等线程亲和对象，需在所属线程中删除。
+        // 投递与登记在锁内完成：shutdown要么看到登记并在线程停止后补删，要么已先置位走直接删除
+        if (!m_shutdown && thread && thread->isRunning() && thread != QThread::currentThread()) {
+            m_pendingRetire.push_back(worker);
+            QMetaObject::invokeMethod(worker, [this, worker]() {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    auto it = std::find(m_pendingRetire.begin(), m_pendingRetire.end(), worker);
+                    if (it == m_pendingRetire.end()) {
+                        return;
+                    }
+                    m_pendingRetire.erase(it);
+                }
+                delete worker;
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    delete worker;
+}
+
+int NetworkThreadPool::maxThreads(Lane lane) const {
+    return lane == Lane::Audio ? m_maxAudioThreads : m_maxIoThreads;
+}
+
+int NetworkThreadPool::threadCount() const {
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_slots.size());
+}
+
+void NetworkThreadPool::shutdown() {
+    std::vector<Slot> snapshot;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_shutdown) {
+            return;
+        }
+        m_shutdown = true;
+        snapshot = m_slots;
+    }
+
+    // 线程对象保留（工作者的thread()仍指向它们），只停止事件循环
+    for (const Slot& slot : snapshot) {
+        slot.thread->quit();
+        slot.thread->wait();
+    }
+
+    // 事件循环退出后未处理的删除不会再执行：线程已停止，按retire顺序直接删除
+    std::vector<QObject*> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pendingRetire);
+    }
+    for (QObject* worker : pending) {
+        delete worker;
+    }
+}
+
+} // namespace network
+} // namespace xiaozhi
@@ -0,0 +1,100 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T13:00:00Z
+File: NetworkThreadPool.h
+Desc: 共享网络线程池（各设备的OTA/MQTT/UDP工作者按负载分配到少量事件循环线程）
+*/
+
+#ifndef NETWORK_THREAD_POOL_H
+#define NETWORK_THREAD_POOL_H
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <vector>
+
+namespace xiaozhi {
+namespace network {
+
+/**
+ * @brief 共享网络线程池（线程安全）
+ *
+ * 每个设备原先为OTA/MQTT/UDP各开一个QThread，50台设备约150个大多空闲的线程。
+ * 现在所有工作者都移入少量常驻事件循环线程，线程数随CPU核数而非设备数增长：
+ * - Io通道：OTA、MQTT等控制面工作者（普通优先级）
+ * - Audio通道：UDP收发与上行采集编码（TimeCriticalPriority实时音频线程）
+ *
+ * 分配时选负载（已分配工作者数）最小的线程，最小负载非零且未达上限时新建线程；
+ * 与已有工作者同线程的工作者（如上行采集编码）通过share()计入负载。
+ * 工作者必须通过retire()销毁：投递到其所属线程中删除，调用方不等待（不阻塞GUI与其他线程）；
+ * 同一线程上按retire顺序删除。shutdown时尚未执行的删除在线程停止后直接完成，不泄漏
+ */
+class NetworkThreadPool {
+public:
+    enum class Lane {
+        Io,
+        Audio
+    };
+
+    static NetworkThreadPool& instance();
+
+    /**
+     * @brief 为一个工作者分配线程（负载计数+1）
+     */
+    QThread* acquire(Lane lane);
+
+    /**
+     * @brief 登记一个移入已分配线程的工作者（负载计数+1，同样须通过retire销毁）
+     */
+    void share(QThread* thread);
+
+    /**
+     * @brief 在工作者所属线程中异步销毁它并归还线程（负载计数-1）
+     *
+     * 线程已停止（或在其所属线程中调用）时直接删除
+     */
+    void retire(QObject* worker);
+
+    /**
+     * @brief 各通道线程上限
+     */
+    int maxThreads(Lane lane) const;
+
+    /**
+     * @brief 当前线程总数
+     */
+    int threadCount() const;
+
+    /**
+     * @brief 停止全部线程并删除尚未销毁的已retire工作者（应用退出时调用，之后retire直接删除工作者）
+     */
+    void shutdown();
+
+    NetworkThreadPool(const NetworkThreadPool&) = delete;
+    NetworkThreadPool& operator=(const NetworkThreadPool&) = delete;
+
+private:
+    NetworkThreadPool();
+    ~NetworkThreadPool();
+
+    struct Slot {
+        QThread* thread = nullptr;
+        Lane lane = Lane::Io;
+        int load = 0;
+    };
+
+    mutable QMutex m_mutex;
+    std::vector<Slot> m_slots;
+    std::vector<QObject*> m_pendingRetire;     // 已投递删除、尚未在其线程中执行的工作者（按retire顺序）
+    int m_maxIoThreads;
+    int m_maxAudioThreads;
+    bool m_shutdown;
+};
+
+} // namespace network
+} // namespace xiaozhi
+
+#endif // NETWORK_THREAD_POOL_H
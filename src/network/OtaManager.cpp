@@ -3,30 +3,151 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:30:00Z
+Updated: 2026-10-16T19:40:00Z
 File: OtaManager.cpp
 Desc: OTA配置获取管理器实现（复刻esp32_simulator_gui.py第254-356行）
 */
 
 #include "OtaManager.h"
+#include "NetworkThreadPool.h"
 #include "../utils/Logger.h"
+#include "../utils/Config.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
-#include <QEventLoop>
+#include <QHash>
+#include <QPointer>
+#include <QThreadStorage>
 #include <QTimer>
+#include <functional>
 
 namespace xiaozhi {
 namespace network {
 
+// ============================================================================
+// 共享OTA HTTP客户端（每个网络线程一个）
+// ============================================================================
+
+namespace {
+
+/**
+ * @brief 线程内共享的OTA HTTP客户端
+ *
+ * 同线程所有OtaWorker共用一个QNetworkAccessManager（连接池按主机复用keep-alive连接，
+ * https默认协商HTTP/2多路复用）；相同请求键的并发请求只发一次，结果分发给所有等待者
+ */
+class OtaHttpClient {
+public:
+    using Callback = std::function<void(bool success, const OtaConfig& config, const QString& error)>;
+
+    static OtaHttpClient& forCurrentThread() {
+        // 线程退出时由QThreadStorage在该线程中删除
+        static QThreadStorage<OtaHttpClient*> storage;
+        if (!storage.hasLocalData()) {
+            storage.setLocalData(new OtaHttpClient());
+        }
+        return *storage.localData();
+    }
+
+    void post(const QString& key, const QNetworkRequest& request, const QByteArray& body,
+              const OtaRequestOptions& options, QObject* owner, Callback callback) {
+        auto it = m_pending.find(key);
+        if (it != m_pending.end()) {
+            // 相同设备的请求正在进行：合并，等待同一个结果
+            it->waiters.append(qMakePair(QPointer<QObject>(owner), std::move(callback)));
+            return;
+        }
+
+        Pending pending;
+        pending.request = request;
+        pending.body = body;
+        pending.options = options;
+        pending.waiters.append(qMakePair(QPointer<QObject>(owner), std::move(callback)));
+        m_pending.insert(key, std::move(pending));
+        send(key);
+    }
+
+private:
+    struct Pending {
+        QNetworkRequest request;
+        QByteArray body;
+        OtaRequestOptions options;
+        int attempt = 0;
+        QList<QPair<QPointer<QObject>, Callback>> waiters;
+    };
+
+    void send(const QString& key) {
+        auto it = m_pending.find(key);
+        if (it == m_pending.end()) {
+            return;
+        }
+
+        QNetworkRequest request = it->request;
+        request.setTransferTimeout(it->options.timeoutMs);
+        QNetworkReply* reply = m_manager.post(request, it->body);
+        QObject::connect(reply, &QNetworkReply::finished, &m_manager, [this, key, reply]() {
+            reply->deleteLater();
+            onFinished(key, reply);
+        });
+    }
+
+    void onFinished(const QString& key, QNetworkReply* reply) {
+        auto it = m_pending.find(key);
+        if (it == m_pending.end()) {
+            return;
+        }
+
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (reply->error() != QNetworkReply::NoError) {
+            // 连接失败、超时、5xx可重试；4xx等服务器明确拒绝的不重试
+            const bool retryable = status == 0 || status >= 500;
+            if (retryable && it->attempt < it->options.maxRetries) {
+                const int delayMs = it->options.retryDelayMs << it->attempt;
+                ++it->attempt;
+                utils::Logger::instance().warn(QString("OTA请求失败，%1ms后重试(%2/%3): %4")
+                    .arg(delayMs).arg(it->attempt).arg(it->options.maxRetries).arg(reply->errorString()));
+                QTimer::singleShot(delayMs, &m_manager, [this, key]() { send(key); });
+                return;
+            }
+            complete(key, false, OtaConfig(), QString("OTA请求失败: %1").arg(reply->errorString()));
+            return;
+        }
+
+        // 已移除敏感的OTA响应日志（服务器通讯细节）
+
+        const QJsonDocument responseDoc = QJsonDocument::fromJson(reply->readAll());
+        if (!responseDoc.isObject()) {
+            complete(key, false, OtaConfig(), "OTA响应格式错误");
+            return;
+        }
+
+        // 解析OTA配置
+        complete(key, true, OtaConfig::fromJson(responseDoc.object()), QString());
+    }
+
+    void complete(const QString& key, bool success, const OtaConfig& config, const QString& error) {
+        const Pending pending = m_pending.take(key);
+        for (const auto& waiter : pending.waiters) {
+            // 请求期间已销毁的工作者不再回调
+            if (waiter.first) {
+                waiter.second(success, config, error);
+            }
+        }
+    }
+
+    QNetworkAccessManager m_manager;
+    QHash<QString, Pending> m_pending;
+};
+
+} // namespace
+
 // ============================================================================
 // OtaWorker实现
 // ============================================================================
 
 OtaWorker::OtaWorker(QObject* parent)
     : QObject(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
 {
 }
 
@@ -49,41 +170,16 @@ void OtaWorker::requestOtaConfig(const DeviceInfo& deviceInfo, const QString& ot
     request.setRawHeader("User-Agent", "esp32s3/1.6.2");
     request.setRawHeader("Accept-Language", "zh-CN");
 
-    // 发送POST请求（同步等待响应）
-    QNetworkReply* reply = m_networkManager->post(request, postData);
-
-    // 使用事件循环等待响应（模拟Python的同步请求）
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    
-    // 设置30秒超时
-    QTimer::singleShot(30000, &loop, &QEventLoop::quit);
-    
-    loop.exec();
-
-    // 处理响应
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray responseData = reply->readAll();
-        
-        // 已移除敏感的OTA响应日志（服务器通讯细节）
-        
-        QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
-        
-        if (responseDoc.isObject()) {
-            QJsonObject responseObj = responseDoc.object();
-            
-            // 解析OTA配置
-            OtaConfig config = OtaConfig::fromJson(responseObj);
-            
-            emit otaConfigReceived(config);
-        } else {
-            emit errorOccurred("OTA响应格式错误");
-        }
-    } else {
-        emit errorOccurred(QString("OTA请求失败: %1").arg(reply->errorString()));
-    }
-
-    reply->deleteLater();
+    // 异步发送：结果通过回调发出信号，本线程继续服务其他设备
+    const QString key = otaUrl + '\n' + deviceInfo.mac_address + '\n' + deviceInfo.uuid;
+    OtaHttpClient::forCurrentThread().post(key, request, postData, m_options, this,
+        [this](bool success, const OtaConfig& config, const QString& error) {
+            if (success) {
+                emit otaConfigReceived(config);
+            } else {
+                emit errorOccurred(error);
+            }
+        });
 }
 
 // ============================================================================
@@ -92,10 +188,10 @@ void OtaWorker::requestOtaConfig(const DeviceInfo& deviceInfo, const QString& ot
 
 OtaManager::OtaManager(QObject* parent)
     : QObject(parent)
-    , m_workerThread(new QThread(this))
+    , m_workerThread(NetworkThreadPool::instance().acquire(NetworkThreadPool::Lane::Io))
     , m_worker(new OtaWorker())
 {
-    // 将worker移到工作线程
+    // 将worker移到共享网络线程
     m_worker->moveToThread(m_workerThread);
 
     // 连接信号
@@ -108,14 +204,16 @@ OtaManager::OtaManager(QObject* parent)
     connect(m_worker, &OtaWorker::errorOccurred,
             this, &OtaManager::errorOccurred);
 
-    // 启动工作线程
-    m_workerThread->start();
+    // 超时与重试策略取自配置
+    OtaRequestOptions options;
+    options.timeoutMs = utils::Config::instance().getOtaTimeoutMs();
+    options.maxRetries = utils::Config::instance().getOtaMaxRetries();
+    setRequestOptions(options);
 }
 
 OtaManager::~OtaManager() {
-    m_workerThread->quit();
-    m_workerThread->wait();
-    delete m_worker;
+    // 共享线程继续服务其他设备，只在其中销毁本工作者
+    NetworkThreadPool::instance().retire(m_worker);
 }
 
 DeviceInfo OtaManager::generateDeviceInfo(const QString& macAddress, const QString& uuid) {
@@ -132,6 +230,14 @@ void OtaManager::requestOtaConfig(const DeviceInfo& deviceInfo, const QString& o
     emit requestOtaConfigInternal(deviceInfo, otaUrl);
 }
 
+void OtaManager::setRequestOptions(const OtaRequestOptions& options) {
+    // 与请求信号同走队列，保证先于之后的请求生效
+    OtaWorker* worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, options]() {
+        worker->setRequestOptions(options);
+    }, Qt::QueuedConnection);
+}
+
 // ============================================================================
 // DeviceInfo JSON转换实现
 // ============================================================================
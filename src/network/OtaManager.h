@@ -3,7 +3,7 @@ Project: jtxiaozhi-client
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-18T11:20:00Z
+Updated: 2026-10-16T19:40:00Z
 File: OtaManager.h
 Desc: OTA配置获取管理器（线程方式，复刻esp32_simulator_gui.py逻辑）
 */
@@ -21,7 +21,20 @@ namespace xiaozhi {
 namespace network {
 
 /**
- * @brief OTA工作线程
+ * @brief OTA请求策略
+ */
+struct OtaRequestOptions {
+    int timeoutMs = 15000;      // 单次请求的传输超时（无数据进展即中止）
+    int maxRetries = 2;         // 网络错误/超时/5xx时的重试次数
+    int retryDelayMs = 1000;    // 首次重试间隔（之后每次翻倍）
+};
+
+/**
+ * @brief OTA工作者
+ *
+ * 完全异步：请求交给所在线程共享的HTTP客户端后立即返回，不再嵌套事件循环占住线程。
+ * 同一线程上的所有OtaWorker共用一个QNetworkAccessManager（对同一OTA主机复用
+ * keep-alive连接/HTTP2），相同设备（URL+Device-Id+Client-Id）的并发请求合并为一次
  */
 class OtaWorker : public QObject {
     Q_OBJECT
@@ -38,6 +51,11 @@ public slots:
      */
     void requestOtaConfig(const DeviceInfo& deviceInfo, const QString& otaUrl);
 
+    /**
+     * @brief 设置超时与重试策略（对之后发起的请求生效）
+     */
+    void setRequestOptions(const OtaRequestOptions& options) { m_options = options; }
+
 signals:
     /**
      * @brief OTA配置获取成功
@@ -50,7 +68,7 @@ signals:
     void errorOccurred(const QString& error);
 
 private:
-    QNetworkAccessManager* m_networkManager;
+    OtaRequestOptions m_options;
 };
 
 /**
@@ -79,6 +97,11 @@ public:
     void requestOtaConfig(const DeviceInfo& deviceInfo, 
                          const QString& otaUrl = "https://api.tenclass.net/xiaozhi/ota/");
 
+    /**
+     * @brief 设置超时与重试策略（默认取自配置Network/otaTimeoutMs、Network/otaMaxRetries）
+     */
+    void setRequestOptions(const OtaRequestOptions& options);
+
 signals:
     /**
      * @brief OTA配置获取成功
@@ -94,7 +117,7 @@ signals:
     void requestOtaConfigInternal(const DeviceInfo& deviceInfo, const QString& otaUrl);
 
 private:
-    QThread* m_workerThread;
+    QThread* m_workerThread;        // 共享网络线程（NetworkThreadPool::Lane::Io）
     OtaWorker* m_worker;
 };
 
@@ -0,0 +1,92 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T18:30:00Z
+File: ReconnectThrottle.cpp
+Desc: 重连节流实现
+*/
+
+#include "ReconnectThrottle.h"
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cmath>
+
+namespace xiaozhi {
+namespace network {
+
+namespace {
+constexpr double DEFAULT_TOKENS_PER_SECOND = 2.0;  // 整个进程每秒最多发起的重连
+constexpr double DEFAULT_BURST = 4.0;              // 允许的瞬时突发
+}
+
+// ============================================================================
+// ReconnectBackoff实现
+// ============================================================================
+
+ReconnectBackoff::ReconnectBackoff(int baseMs, int capMs)
+    : m_baseMs(baseMs)
+    , m_capMs(capMs)
+    , m_previousMs(baseMs)
+    , m_attempts(0)
+{
+}
+
+int ReconnectBackoff::nextDelayMs() {
+    const int upper = static_cast<int>(std::min<qint64>(m_capMs, static_cast<qint64>(m_previousMs) * 3));
+    const int delay = upper > m_baseMs
+        ? static_cast<int>(QRandomGenerator::global()->bounded(m_baseMs, upper + 1))
+        : m_baseMs;
+    m_previousMs = std::min(delay, m_capMs);
+    ++m_attempts;
+    return m_previousMs;
+}
+
+void ReconnectBackoff::reset() {
+    m_previousMs = m_baseMs;
+    m_attempts = 0;
+}
+
+// ============================================================================
+// ReconnectThrottle实现
+// ============================================================================
+
+ReconnectThrottle& ReconnectThrottle::instance() {
+    static ReconnectThrottle instance;
+    return instance;
+}
+
+ReconnectThrottle::ReconnectThrottle()
+    : m_tokensPerSecond(DEFAULT_TOKENS_PER_SECOND)
+    , m_burst(DEFAULT_BURST)
+    , m_tokens(DEFAULT_BURST)
+    , m_lastRefillMs(0)
+{
+    m_clock.start();
+}
+
+int ReconnectThrottle::reserveDelayMs() {
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 now = m_clock.elapsed();
+    m_tokens = std::min(m_burst, m_tokens + (now - m_lastRefillMs) * m_tokensPerSecond / 1000.0);
+    m_lastRefillMs = now;
+
+    // 先扣令牌再计算等待：不足时为负，后来者依次排到更晚
+    m_tokens -= 1.0;
+    if (m_tokens >= 0.0) {
+        return 0;
+    }
+    return static_cast<int>(std::ceil(-m_tokens * 1000.0 / m_tokensPerSecond));
+}
+
+void ReconnectThrottle::configure(double tokensPerSecond, double burst) {
+    QMutexLocker locker(&m_mutex);
+    m_tokensPerSecond = std::max(0.1, tokensPerSecond);
+    m_burst = std::max(1.0, burst);
+    m_tokens = std::min(m_tokens, m_burst);
+}
+
+} // namespace network
+} // namespace xiaozhi
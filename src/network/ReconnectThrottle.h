@@ -0,0 +1,92 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T18:30:00Z
+File: ReconnectThrottle.h
+Desc: 重连节流（退避抖动计算与进程级重连令牌桶）
+*/
+
+#ifndef RECONNECT_THROTTLE_H
+#define RECONNECT_THROTTLE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QtGlobal>
+
+namespace xiaozhi {
+namespace network {
+
+/**
+ * @brief 单连接的指数退避（decorrelated jitter）
+ *
+ * delay = min(cap, random(base, prev × 3))：相邻两次的间隔随机展开，
+ * 多个设备同时断线后不会按相同节拍齐步重连。非线程安全，由所属工作者独占
+ */
+class ReconnectBackoff {
+public:
+    explicit ReconnectBackoff(int baseMs = 1000, int capMs = 60000);
+
+    /**
+     * @brief 下一次重连前的等待时间（毫秒），并推进退避状态
+     */
+    int nextDelayMs();
+
+    /**
+     * @brief 连接成功后复位
+     */
+    void reset();
+
+    /**
+     * @brief 本轮已连续重连的次数
+     */
+    int attempts() const { return m_attempts; }
+
+private:
+    int m_baseMs;
+    int m_capMs;
+    int m_previousMs;
+    int m_attempts;
+};
+
+/**
+ * @brief 进程级重连令牌桶（所有DeviceSession共享，线程安全）
+ *
+ * 服务器重启时所有设备同时断线，退避之外再限制整个进程的重连速率，
+ * 保护服务器与本机的各个工作线程。令牌不足时不阻塞，而是返回需要推迟的时间（预约令牌）
+ */
+class ReconnectThrottle {
+public:
+    static ReconnectThrottle& instance();
+
+    /**
+     * @brief 预约一个重连令牌
+     * @return 距令牌可用还需等待的毫秒数（0表示可立即重连）
+     */
+    int reserveDelayMs();
+
+    /**
+     * @brief 调整速率（每秒令牌数）与突发容量
+     */
+    void configure(double tokensPerSecond, double burst);
+
+    ReconnectThrottle(const ReconnectThrottle&) = delete;
+    ReconnectThrottle& operator=(const ReconnectThrottle&) = delete;
+
+private:
+    ReconnectThrottle();
+    ~ReconnectThrottle() = default;
+
+    QMutex m_mutex;
+    QElapsedTimer m_clock;
+    double m_tokensPerSecond;
+    double m_burst;
+    double m_tokens;        // 可为负：表示已被预约的未来令牌
+    qint64 m_lastRefillMs;
+};
+
+} // namespace network
+} // namespace xiaozhi
+
+#endif // RECONNECT_THROTTLE_H
@@ -0,0 +1,106 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T18:00:00Z
+File: TlsSessionCache.cpp
+Desc: 进程级TLS缓存实现
+*/
+
+#include "TlsSessionCache.h"
+#include "../utils/Logger.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSslCertificate>
+
+namespace xiaozhi {
+namespace network {
+
+TlsSessionCache& TlsSessionCache::instance() {
+    static TlsSessionCache instance;
+    return instance;
+}
+
+TlsSessionCache::TlsSessionCache()
+    : m_trustStoreResolved(false)
+{
+}
+
+QString TlsSessionCache::trustStorePath() {
+    QMutexLocker locker(&m_mutex);
+    if (!m_trustStoreResolved) {
+        m_trustStorePath = locateTrustStore();
+        m_trustStoreResolved = true;
+    }
+    return m_trustStorePath;
+}
+
+QString TlsSessionCache::locateTrustStore() const {
+    // 1. 优先使用内置资源（打包到程序中），提取到临时文件（OpenSSL需要文件路径）
+    QFile resource(":/cacert.pem");
+    if (resource.open(QIODevice::ReadOnly)) {
+        const QByteArray bundle = resource.readAll();
+        const QString tempCertPath = QDir::temp().filePath("xiaozhi_cacert.pem");
+
+        // 已有内容相同的文件则直接复用（其他实例可能正在读取，避免删除重写）
+        QFile existing(tempCertPath);
+        bool upToDate = false;
+        if (existing.open(QIODevice::ReadOnly)) {
+            upToDate = existing.size() == bundle.size() && existing.readAll() == bundle;
+            existing.close();
+        }
+        if (!upToDate) {
+            // 原子替换：写临时文件后重命名，读取方不会看到半个文件
+            QSaveFile out(tempCertPath);
+            if (out.open(QIODevice::WriteOnly)) {
+                out.write(bundle);
+                upToDate = out.commit();
+            }
+        }
+        if (upToDate) {
+            QFile::setPermissions(tempCertPath, QFile::ReadOwner | QFile::WriteOwner);
+            const int count = QSslCertificate::fromData(bundle, QSsl::Pem).size();
+            utils::Logger::instance().info(QString("🔒 已加载内置CA证书包（%1个证书）").arg(count));
+            return tempCertPath;
+        }
+    }
+
+    // 2. 尝试程序目录
+    QString certPath = QCoreApplication::applicationDirPath() + "/cacert.pem";
+    if (QFile::exists(certPath)) {
+        return certPath;
+    }
+
+    // 3. 尝试当前目录
+    certPath = "cacert.pem";
+    if (QFile::exists(certPath)) {
+        return certPath;
+    }
+
+    utils::Logger::instance().warn("未找到CA证书包，TLS连接将使用系统默认信任库");
+    return QString();
+}
+
+QByteArray TlsSessionCache::sessionTicket(const QString& peer) const {
+    QMutexLocker locker(&m_mutex);
+    return m_sessionTickets.value(peer);
+}
+
+void TlsSessionCache::storeSessionTicket(const QString& peer, const QByteArray& ticket) {
+    if (peer.isEmpty() || ticket.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_sessionTickets.insert(peer, ticket);
+}
+
+void TlsSessionCache::clearSessionTicket(const QString& peer) {
+    QMutexLocker locker(&m_mutex);
+    m_sessionTickets.remove(peer);
+}
+
+} // namespace network
+} // namespace xiaozhi
@@ -0,0 +1,78 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T18:00:00Z
+File: TlsSessionCache.h
+Desc: 进程级TLS缓存（CA证书包只提取一次、WebSocket TLS会话票据复用）
+*/
+
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+namespace xiaozhi {
+namespace network {
+
+/**
+ * @brief 进程级TLS缓存（线程安全）
+ *
+ * - CA证书包：内置的:/cacert.pem在进程内只提取/校验一次，之后所有MQTT连接复用同一路径
+ * - 会话票据：按"主机:端口"保存QSslSocket的TLS会话票据，重连时恢复会话，
+ *   断线重连只需一次往返而非完整握手
+ */
+class TlsSessionCache {
+public:
+    static TlsSessionCache& instance();
+
+    /**
+     * @brief CA证书包路径（OpenSSL信任库文件）
+     *
+     * 首次调用时按 内置资源 → 程序目录 → 当前目录 查找；
+     * 内置资源提取到临时目录（内容未变时不重写）。找不到时返回空
+     */
+    QString trustStorePath();
+
+    /**
+     * @brief 取已保存的会话票据（无则为空）
+     * @param peer "主机:端口"
+     */
+    QByteArray sessionTicket(const QString& peer) const;
+
+    /**
+     * @brief 保存会话票据（空票据忽略）
+     */
+    void storeSessionTicket(const QString& peer, const QByteArray& ticket);
+
+    /**
+     * @brief 丢弃会话票据（服务器拒绝恢复或证书变化时）
+     */
+    void clearSessionTicket(const QString& peer);
+
+    TlsSessionCache(const TlsSessionCache&) = delete;
+    TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+private:
+    TlsSessionCache();
+    ~TlsSessionCache() = default;
+
+    /**
+     * @brief 查找/提取CA证书包（仅首次调用trustStorePath时执行）
+     */
+    QString locateTrustStore() const;
+
+    mutable QMutex m_mutex;
+    bool m_trustStoreResolved;
+    QString m_trustStorePath;
+    QHash<QString, QByteArray> m_sessionTickets;
+};
+
+} // namespace network
+} // namespace xiaozhi
+
+#endif // TLS_SESSION_CACHE_H
@@ -0,0 +1,231 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T18:00:00Z
+File: TransportRace.cpp
+Desc: 传输层候选并发探测实现
+*/
+
+#include "TransportRace.h"
+#include <QSslSocket>
+#include <QTcpSocket>
+
+namespace xiaozhi {
+namespace network {
+
+namespace {
+constexpr int DEFAULT_STAGGER_MS = 250;     // RFC 8305建议的连接尝试间隔
+constexpr int DEFAULT_TIMEOUT_MS = 5000;
+}
+
+TransportRace::TransportRace(QObject* parent)
+    : QObject(parent)
+    , m_sslConfig(QSslConfiguration::defaultConfiguration())
+    , m_staggerTimer(new QTimer(this))
+    , m_staggerMs(DEFAULT_STAGGER_MS)
+    , m_timeoutMs(DEFAULT_TIMEOUT_MS)
+    , m_nextLaunch(0)
+    , m_winner(-1)
+    , m_preferred(-1)
+    , m_running(false)
+    , m_round(0)
+{
+    m_staggerTimer->setSingleShot(true);
+    connect(m_staggerTimer, &QTimer::timeout, this, &TransportRace::launchNext);
+}
+
+TransportRace::~TransportRace() {
+    cancel();
+}
+
+void TransportRace::start(const QList<TransportCandidate>& candidates) {
+    cancel();
+
+    m_probes.clear();
+    for (const TransportCandidate& candidate : candidates) {
+        Probe probe;
+        probe.candidate = candidate;
+        m_probes.push_back(probe);
+    }
+    m_nextLaunch = 0;
+    m_winner = -1;
+    m_running = true;
+    m_clock.start();
+
+    if (m_probes.empty()) {
+        m_running = false;
+        emit failed();
+        return;
+    }
+    launchNext();
+}
+
+void TransportRace::cancel() {
+    finish();
+    m_preferred = -1;
+    ++m_round;
+}
+
+void TransportRace::launchNext() {
+    if (!m_running || m_nextLaunch >= static_cast<int>(m_probes.size())) {
+        return;
+    }
+
+    const int index = m_nextLaunch++;
+    Probe& probe = m_probes[index];
+    probe.state = ProbeState::Connecting;
+
+    if (probe.candidate.useSSL) {
+        auto* socket = new QSslSocket(this);
+        socket->setSslConfiguration(m_sslConfig);
+        connect(socket, &QSslSocket::connected, this, [this, index]() {
+            setState(index, ProbeState::Handshaking);
+        });
+        connect(socket, &QSslSocket::encrypted, this, [this, index]() {
+            setState(index, ProbeState::Reachable);
+        });
+        probe.socket = socket;
+    } else {
+        auto* socket = new QTcpSocket(this);
+        connect(socket, &QTcpSocket::connected, this, [this, index]() {
+            setState(index, ProbeState::Reachable);
+        });
+        probe.socket = socket;
+    }
+    // 证书校验失败同样以errorOccurred结束
+    connect(probe.socket, &QAbstractSocket::errorOccurred, this, [this, index]() {
+        setState(index, ProbeState::Failed);
+    });
+
+    probe.deadline = new QTimer(probe.socket);
+    probe.deadline->setSingleShot(true);
+    connect(probe.deadline, &QTimer::timeout, this, [this, index]() {
+        setState(index, ProbeState::Failed);
+    });
+    probe.deadline->start(m_timeoutMs);
+
+    // 下一个候选按错开间隔发起（本候选提前失败时立即发起）
+    if (m_nextLaunch < static_cast<int>(m_probes.size())) {
+        m_staggerTimer->start(m_staggerMs);
+    }
+
+    QAbstractSocket* socket = probe.socket;
+    if (probe.candidate.useSSL) {
+        static_cast<QSslSocket*>(socket)->connectToHostEncrypted(probe.candidate.host,
+                                                                 static_cast<quint16>(probe.candidate.port));
+    } else {
+        socket->connectToHost(probe.candidate.host, static_cast<quint16>(probe.candidate.port));
+    }
+}
+
+void TransportRace::setState(int index, ProbeState state) {
+    if (!m_running || index >= static_cast<int>(m_probes.size())) {
+        return;
+    }
+    Probe& probe = m_probes[index];
+    if (!probe.socket) {
+        return;  // 已中止或已出结果
+    }
+
+    probe.state = state;
+    if (state == ProbeState::Reachable || state == ProbeState::Failed) {
+        // 只探测可达性，结果已知即释放连接
+        abortProbe(index);
+    }
+
+    if (state == ProbeState::Failed && m_winner < 0 && m_nextLaunch < static_cast<int>(m_probes.size())) {
+        m_staggerTimer->stop();
+        launchNext();
+    }
+    evaluate();
+}
+
+void TransportRace::evaluate() {
+    if (!m_running) {
+        return;
+    }
+
+    if (m_winner < 0) {
+        for (int i = 0; i < static_cast<int>(m_probes.size()); ++i) {
+            const ProbeState state = m_probes[i].state;
+            if (state == ProbeState::Reachable) {
+                m_winner = i;
+                break;
+            }
+            if (state == ProbeState::Handshaking) {
+                break;  // 更高优先的TLS候选已连通、握手中：等其结果，不让后面的明文候选抢先
+            }
+        }
+
+        if (m_winner < 0) {
+            for (const Probe& probe : m_probes) {
+                if (probe.state != ProbeState::Failed) {
+                    return;
+                }
+            }
+            finish();
+            emit failed();
+            return;
+        }
+
+        // 决出胜者：排在其后的候选不再需要
+        m_staggerTimer->stop();
+        m_nextLaunch = static_cast<int>(m_probes.size());
+        for (int i = m_winner + 1; i < static_cast<int>(m_probes.size()); ++i) {
+            abortProbe(i);
+        }
+
+        const quint64 round = m_round;
+        emit won(m_winner, m_clock.elapsed());
+        if (round != m_round || !m_running) {
+            return;  // 接收方已取消或重启
+        }
+    }
+
+    // 排在胜者之前、仍在建连的候选出结果后，给出最高优先的可达候选
+    for (int i = 0; i < m_winner; ++i) {
+        const ProbeState state = m_probes[i].state;
+        if (state == ProbeState::Connecting || state == ProbeState::Handshaking) {
+            return;
+        }
+    }
+    int preferred = m_winner;
+    for (int i = 0; i < m_winner; ++i) {
+        if (m_probes[i].state == ProbeState::Reachable) {
+            preferred = i;
+            break;
+        }
+    }
+    finish();
+    m_preferred = preferred;
+    emit resolved(preferred);
+}
+
+void TransportRace::abortProbe(int index) {
+    Probe& probe = m_probes[index];
+    if (!probe.socket) {
+        return;
+    }
+
+    QAbstractSocket* socket = probe.socket;
+    probe.socket = nullptr;
+    probe.deadline->stop();
+    probe.deadline = nullptr;
+    // 先断开信号：abort()同步发出的错误/断开不再回到本对象
+    QObject::disconnect(socket, nullptr, this, nullptr);
+    socket->abort();
+    socket->deleteLater();
+}
+
+void TransportRace::finish() {
+    m_staggerTimer->stop();
+    for (int i = 0; i < static_cast<int>(m_probes.size()); ++i) {
+        abortProbe(i);
+    }
+    m_running = false;
+}
+
+} // namespace network
+} // namespace xiaozhi
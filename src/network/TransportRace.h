@@ -0,0 +1,178 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T18:00:00Z
+File: TransportRace.h
+Desc: 传输层候选并发探测（happy eyeballs式错开发起，首个可达者胜出）
+*/
+
+#ifndef TRANSPORT_RACE_H
+#define TRANSPORT_RACE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSslConfiguration>
+#include <QString>
+#include <QTimer>
+#include <vector>
+
+class QTcpSocket;
+
+namespace xiaozhi {
+namespace network {
+
+/**
+ * @brief 传输层候选端点
+ */
+struct TransportCandidate {
+    QString host;
+    int port = 0;
+    bool useSSL = false;
+};
+
+/**
+ * @brief 传输层候选并发探测
+ *
+ * 按优先顺序每隔staggerMs发起一个候选（前一个确认失败则立即发起下一个），
+ * 明文候选以TCP连接建立为可达，TLS候选以握手完成（含证书校验）为可达。
+ * 可达的候选只有在排在它之前的候选都已失败或仍停在TCP建连时才胜出：
+ * 端口被过滤时回退耗时受错开间隔约束，而TLS握手进行中的高优先候选不会被明文抢先（防降级）。
+ * 胜出后立即中止排在其后的候选；排在其前、仍在建连的候选继续探测到出结果，
+ * 随后以resolved给出最高优先的可达候选，供调用方写入端口协议缓存。
+ *
+ * 只探测可达性，不保留连接：调用方再在胜出端点上建立真正的协议连接。
+ * 非线程安全，在所属线程的事件循环中运行
+ */
+class TransportRace : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TransportRace(QObject* parent = nullptr);
+    ~TransportRace() override;
+
+    /**
+     * @brief 相邻候选的错开间隔（毫秒）
+     */
+    void setStaggerMs(int staggerMs) { m_staggerMs = staggerMs; }
+
+    /**
+     * @brief 单个候选的探测超时（毫秒，含TLS握手）
+     */
+    void setTimeoutMs(int timeoutMs) { m_timeoutMs = timeoutMs; }
+
+    /**
+     * @brief TLS候选使用的配置（证书校验等）
+     */
+    void setSslConfiguration(const QSslConfiguration& config) { m_sslConfig = config; }
+
+    /**
+     * @brief 开始新一轮探测（先取消上一轮）
+     * @param candidates 按优先顺序排列的候选
+     */
+    void start(const QList<TransportCandidate>& candidates);
+
+    /**
+     * @brief 取消本轮，中止全部探测连接（不再发出任何信号）
+     */
+    void cancel();
+
+    /**
+     * @brief 尚未决出胜者
+     */
+    bool isRacing() const { return m_running && m_winner < 0; }
+
+    /**
+     * @brief 已决出胜者，排在其前的候选仍在探测
+     */
+    bool isResolving() const { return m_running && m_winner >= 0; }
+
+    /**
+     * @brief 最高优先的可达候选（resolved之后有效，否则为-1）
+     */
+    int preferredIndex() const { return m_preferred; }
+
+    /**
+     * @brief 本轮第index个候选
+     */
+    const TransportCandidate& candidate(int index) const { return m_probes[index].candidate; }
+
+signals:
+    /**
+     * @brief 决出胜者
+     * @param index 胜出候选的序号
+     * @param elapsedMs 自start起的耗时
+     */
+    void won(int index, qint64 elapsedMs);
+
+    /**
+     * @brief 排在胜者之前的候选均已出结果
+     * @param preferredIndex 最高优先的可达候选（胜者或之后才连通的更高优先候选）
+     */
+    void resolved(int preferredIndex);
+
+    /**
+     * @brief 全部候选均不可达
+     */
+    void failed();
+
+private:
+    enum class ProbeState {
+        Idle,           // 未发起
+        Connecting,     // TCP建连中
+        Handshaking,    // TCP已连通，TLS握手中
+        Reachable,
+        Failed
+    };
+
+    struct Probe {
+        TransportCandidate candidate;
+        ProbeState state = ProbeState::Idle;
+        QTcpSocket* socket = nullptr;
+        QTimer* deadline = nullptr;
+    };
+
+    /**
+     * @brief 发起下一个未发起的候选
+     */
+    void launchNext();
+
+    /**
+     * @brief 探测状态变化
+     */
+    void setState(int index, ProbeState state);
+
+    /**
+     * @brief 按优先顺序判定胜者/本轮结束
+     */
+    void evaluate();
+
+    /**
+     * @brief 中止并释放一个候选的连接
+     */
+    void abortProbe(int index);
+
+    /**
+     * @brief 释放本轮全部连接并结束
+     */
+    void finish();
+
+    std::vector<Probe> m_probes;
+    QSslConfiguration m_sslConfig;
+    QTimer* m_staggerTimer;
+    QElapsedTimer m_clock;
+    int m_staggerMs;
+    int m_timeoutMs;
+    int m_nextLaunch;
+    int m_winner;
+    int m_preferred;
+    bool m_running;
+    quint64 m_round;            // 每次start/cancel递增，发出信号后据此判断本轮是否已被重启
+};
+
+} // namespace network
+} // namespace xiaozhi
+
+#endif // TRANSPORT_RACE_H
@@ -3,24 +3,67 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T23:20:00Z
+Updated: 2026-10-17T13:00:00Z
 File: UdpManager.cpp
 Desc: UDP音频通道管理器实现（完整加密音频发送/接收）
 */
 
 #include "UdpManager.h"
+#include "NetworkThreadPool.h"
+#include "../utils/LatencyTracer.h"
 #include "../utils/Logger.h"
 #include <QHostAddress>
+#include <QHostInfo>
 #include <QThread>
+#include <QTimer>
 #include <QtMath>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 namespace xiaozhi {
 namespace network {
 
+namespace {
+constexpr int UDP_BATCH_SIZE = 32;          // 单次recvmmsg最多处理的数据报数
+constexpr int UDP_MAX_DATAGRAM = 2048;      // 单个数据报上限（16字节包头 + Opus最大1275字节，留余量）
+constexpr qint64 STATS_INTERVAL_MS = 1000;  // 下行包统计发布间隔
+constexpr qint64 SEND_ERROR_REPORT_INTERVAL_MS = 1000;  // 非瞬时发送错误上报间隔
+}
+
+// ============================================================================
+// 原生批量收发（Linux）
+// ============================================================================
+
+#ifdef Q_OS_LINUX
+struct UdpWorker::NativeBatchIo {
+    int fd = -1;
+    QSocketNotifier* notifier = nullptr;
+
+    // 接收预分配区：UDP_BATCH_SIZE个槽位，recvmmsg直接写入
+    char rxArena[UDP_BATCH_SIZE][UDP_MAX_DATAGRAM];
+    iovec rxIov[UDP_BATCH_SIZE];
+    mmsghdr rxMsgs[UDP_BATCH_SIZE];
+
+    // 发送缓冲：上行每60ms仅一帧，逐包直接send，不排队合并
+    char txBuffer[UDP_MAX_DATAGRAM];
+};
+#else
+struct UdpWorker::NativeBatchIo {};
+#endif
+
 // ============================================================================
 // UdpWorker实现
 // ============================================================================
@@ -30,12 +73,17 @@ UdpWorker::UdpWorker(QObject* parent)
     , m_socket(new QUdpSocket(this))
     , m_connected(false)
     , m_encryptor(nullptr)
+    , m_lookupId(-1)
+    , m_sendDropped(0)
+    , m_suppressedSendErrors(0)
 {
     // 连接接收信号
     connect(m_socket, &QUdpSocket::readyRead, this, &UdpWorker::onReadyRead);
 }
 
 UdpWorker::~UdpWorker() {
+    abortPeerLookup();
+    closeNativeSocket();
     if (m_socket) {
         m_socket->close();
     }
@@ -43,7 +91,7 @@ UdpWorker::~UdpWorker() {
 
 void UdpWorker::connectToUdp(const UdpConfig& config) {
     // 如果已经连接，先断开（避免重复连接）
-    if (m_connected) {
+    if (m_connected || m_lookupId >= 0) {
         utils::Logger::instance().info("⚠️ UDP已连接，忽略重复连接请求");
         return;
     }
@@ -59,6 +107,61 @@ void UdpWorker::connectToUdp(const UdpConfig& config) {
 
     // 音频加密器初始化成功
 
+    m_statsClock.start();
+    m_sendDropped = 0;
+    m_suppressedSendErrors = 0;
+    m_sendErrorClock.invalidate();
+
+    // 服务器地址只解析一次，发送时复用；域名异步解析，不阻塞共享的实时音频线程
+    m_peerAddress = QHostAddress(m_config.server);
+    if (!m_peerAddress.isNull()) {
+        openTransport();
+        return;
+    }
+    m_lookupId = QHostInfo::lookupHost(m_config.server, this, &UdpWorker::onPeerResolved);
+}
+
+void UdpWorker::onPeerResolved(const QHostInfo& info) {
+    // 解析期间已断开或重新发起的连接：丢弃过期结果
+    if (info.lookupId() != m_lookupId) {
+        return;
+    }
+    m_lookupId = -1;
+    if (!m_encryptor) {
+        return;
+    }
+
+    for (const QHostAddress& address : info.addresses()) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            m_peerAddress = address;
+            break;
+        }
+    }
+    if (m_peerAddress.isNull() && !info.addresses().isEmpty()) {
+        m_peerAddress = info.addresses().first();
+    }
+    if (m_peerAddress.isNull()) {
+        emit errorOccurred(QString("UDP服务器地址解析失败: %1").arg(info.errorString()));
+        return;
+    }
+    openTransport();
+}
+
+void UdpWorker::abortPeerLookup() {
+    if (m_lookupId >= 0) {
+        QHostInfo::abortHostLookup(m_lookupId);
+        m_lookupId = -1;
+    }
+}
+
+void UdpWorker::openTransport() {
+    // 优先使用原生批量收发套接字
+    if (openNativeSocket()) {
+        m_connected = true;
+        emit udpConnected();
+        return;
+    }
+
     try {
         // 如果socket已经bind过，先关闭重新创建
         if (m_socket->state() != QAbstractSocket::UnconnectedState) {
@@ -85,54 +188,191 @@ void UdpWorker::connectToUdp(const UdpConfig& config) {
 }
 
 void UdpWorker::disconnect() {
+    // 断开前发布最终统计
+    if (m_encryptor) {
+        publishReceiveStats(true);
+    }
+    abortPeerLookup();
+    closeNativeSocket();
     if (m_socket) {
         m_socket->close();
-        m_connected = false;
     }
+    m_connected = false;
     m_encryptor.reset();
 }
 
+bool UdpWorker::openNativeSocket() {
+#ifdef Q_OS_LINUX
+    closeNativeSocket();
+
+    sockaddr_storage peer;
+    std::memset(&peer, 0, sizeof(peer));
+    socklen_t peerLen = 0;
+    int family = AF_INET;
+    if (m_peerAddress.protocol() == QAbstractSocket::IPv4Protocol) {
+        auto* in4 = reinterpret_cast<sockaddr_in*>(&peer);
+        in4->sin_family = AF_INET;
+        in4->sin_port = htons(static_cast<uint16_t>(m_config.port));
+        in4->sin_addr.s_addr = htonl(m_peerAddress.toIPv4Address());
+        peerLen = sizeof(sockaddr_in);
+    } else if (m_peerAddress.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto* in6 = reinterpret_cast<sockaddr_in6*>(&peer);
+        const Q_IPV6ADDR addr = m_peerAddress.toIPv6Address();
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(static_cast<uint16_t>(m_config.port));
+        std::memcpy(&in6->sin6_addr, addr.c, sizeof(addr.c));
+        peerLen = sizeof(sockaddr_in6);
+        family = AF_INET6;
+    } else {
+        return false;
+    }
+
+    const int fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    // connect后内核只投递来自服务器的数据报，send无需逐包携带地址
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&peer), peerLen) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_native = std::make_unique<NativeBatchIo>();
+    m_native->fd = fd;
+    for (int i = 0; i < UDP_BATCH_SIZE; ++i) {
+        m_native->rxIov[i].iov_base = m_native->rxArena[i];
+        m_native->rxIov[i].iov_len = UDP_MAX_DATAGRAM;
+        std::memset(&m_native->rxMsgs[i], 0, sizeof(mmsghdr));
+        m_native->rxMsgs[i].msg_hdr.msg_iov = &m_native->rxIov[i];
+        m_native->rxMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    m_native->notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_native->notifier, &QSocketNotifier::activated, this, &UdpWorker::onNativeReadyRead);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void UdpWorker::closeNativeSocket() {
+#ifdef Q_OS_LINUX
+    if (!m_native) {
+        return;
+    }
+    delete m_native->notifier;
+    ::close(m_native->fd);
+#endif
+    m_native.reset();
+}
+
 void UdpWorker::sendAudioData(const QByteArray& opus_data) {
     if (!m_connected || !m_encryptor) {
         emit errorOccurred("UDP未连接或加密器未初始化");
         return;
     }
 
-    // 使用加密器封装音频包（包含加密）
     uint32_t timestamp = QDateTime::currentMSecsSinceEpoch();
-    QByteArray encrypted_packet = m_encryptor->encrypt(opus_data, timestamp);
-    if (encrypted_packet.isEmpty()) {
+
+    // 上行采集工作者同线程调用：当前追踪帧即刚编码完成的这一帧
+    const quint32 traceId = (m_tracer && m_tracer->isEnabled()) ? m_tracer->currentUplinkFrame() : 0;
+
+#ifdef Q_OS_LINUX
+    if (m_native) {
+        // 包头+密文直接加密写入预分配的发送缓冲，无中间缓冲；在本次调用内直接发出，不多一次事件循环跳转
+        const int packetSize = m_encryptor->encryptInto(opus_data.constData(), opus_data.size(), timestamp,
+                                                        m_native->txBuffer, UDP_MAX_DATAGRAM);
+        if (packetSize < 0) {
+            emit errorOccurred("音频包加密失败");
+            return;
+        }
+        if (traceId != 0) {
+            m_tracer->markUplink(traceId, utils::TracePoint::Encrypted);
+        }
+
+        ssize_t sent;
+        do {
+            sent = ::send(m_native->fd, m_native->txBuffer, static_cast<size_t>(packetSize), 0);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent < 0) {
+            // 发送缓冲满属于瞬时拥塞：实时音频不重试，丢弃本包并计数
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                ++m_sendDropped;
+            } else {
+                reportSendError(QString::fromLocal8Bit(std::strerror(errno)));
+            }
+        } else if (traceId != 0) {
+            m_tracer->markUplink(traceId, utils::TracePoint::Sent);
+        }
+        return;
+    }
+#endif
+
+    // 使用加密器封装音频包（包头+密文写入复用的发送缓冲）
+    const int capacity = audio::AudioEncryptor::packetSize(opus_data.size());
+    if (m_txDatagram.size() < capacity) {
+        m_txDatagram.resize(qMax(capacity, UDP_MAX_DATAGRAM));
+    }
+    const int packetSize = m_encryptor->encryptInto(opus_data.constData(), opus_data.size(), timestamp,
+                                                    m_txDatagram.data(), m_txDatagram.size());
+    if (packetSize < 0) {
         emit errorOccurred("音频包加密失败");
         return;
     }
+    if (traceId != 0) {
+        m_tracer->markUplink(traceId, utils::TracePoint::Encrypted);
+    }
 
     // 发送加密后的数据包
     qint64 sent = m_socket->writeDatagram(
-        encrypted_packet,
-        QHostAddress(m_config.server),
+        m_txDatagram.constData(),
+        packetSize,
+        m_peerAddress,
         m_config.port
     );
 
     if (sent < 0) {
-        emit errorOccurred(QString("UDP发送失败: %1").arg(m_socket->errorString()));
+        if (m_socket->error() == QAbstractSocket::TemporaryError) {
+            ++m_sendDropped;
+        } else {
+            reportSendError(m_socket->errorString());
+        }
+    } else if (traceId != 0) {
+        m_tracer->markUplink(traceId, utils::TracePoint::Sent);
     }
     // 已移除UDP发送详情日志（敏感信息）
 }
 
+void UdpWorker::reportSendError(const QString& error) {
+    // 非瞬时错误（网络不可达等）按间隔上报一次，期间其余的只计数，避免每帧刷屏
+    if (m_sendErrorClock.isValid() && m_sendErrorClock.elapsed() < SEND_ERROR_REPORT_INTERVAL_MS) {
+        ++m_suppressedSendErrors;
+        return;
+    }
+    m_sendErrorClock.restart();
+
+    QString message = QString("UDP发送失败: %1").arg(error);
+    if (m_suppressedSendErrors > 0) {
+        message += QString("（此前%1次同类错误已省略）").arg(m_suppressedSendErrors);
+        m_suppressedSendErrors = 0;
+    }
+    emit errorOccurred(message);
+}
+
 void UdpWorker::onReadyRead() {
     while (m_socket->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(m_socket->pendingDatagramSize());
-
-        QHostAddress sender;
-        quint16 senderPort;
+        // 复用接收缓冲，仅在遇到更大的数据报时扩容
+        const qint64 pending = m_socket->pendingDatagramSize();
+        if (pending > m_rxDatagram.size()) {
+            m_rxDatagram.resize(qMax<qint64>(pending, UDP_MAX_DATAGRAM));
+        }
 
         qint64 received = m_socket->readDatagram(
-            datagram.data(),
-            datagram.size(),
-            &sender,
-            &senderPort
+            m_rxDatagram.data(),
+            m_rxDatagram.size()
         );
+        const qint64 receivedNs = (m_tracer && m_tracer->isEnabled()) ? utils::LatencyTracer::nowNs() : 0;
 
         if (received < 0) {
             utils::Logger::instance().error("UDP接收数据失败");
@@ -140,23 +380,91 @@ void UdpWorker::onReadyRead() {
         }
 
         // 已移除UDP接收详情日志（敏感信息）
+        handleDatagram(m_rxDatagram.data(), received, receivedNs);
+    }
+}
 
-        if (!m_encryptor) {
-            utils::Logger::instance().error("加密器未初始化");
-            continue;
-        }
+void UdpWorker::onNativeReadyRead() {
+#ifdef Q_OS_LINUX
+    if (!m_native) {
+        return;
+    }
 
-        // 解密音频包
-        uint32_t timestamp, sequence;
-        QByteArray opus_data = m_encryptor->decrypt(datagram, timestamp, sequence);
-        if (opus_data.isEmpty()) {
-            utils::Logger::instance().error("音频包解密失败");
-            continue;
+    // 一次系统调用取回至多UDP_BATCH_SIZE个数据报，取满则继续，直到内核队列为空
+    for (;;) {
+        const int count = ::recvmmsg(m_native->fd, m_native->rxMsgs, UDP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                utils::Logger::instance().error("UDP接收数据失败");
+            }
+            break;
+        }
+        // 同一批数据报共用一个接收时刻
+        const qint64 receivedNs = (m_tracer && m_tracer->isEnabled()) ? utils::LatencyTracer::nowNs() : 0;
+        for (int i = 0; i < count; ++i) {
+            // 超过槽位的数据报被截断，不是合法音频包
+            if (m_native->rxMsgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
+            }
+            handleDatagram(m_native->rxArena[i], static_cast<qint64>(m_native->rxMsgs[i].msg_len), receivedNs);
+            // 回调中可能已断开连接
+            if (!m_native) {
+                return;
+            }
+        }
+        if (count < UDP_BATCH_SIZE) {
+            break;
         }
+    }
+#endif
+}
+
+void UdpWorker::handleDatagram(char* data, qint64 size, qint64 receivedNs) {
+    if (!m_encryptor) {
+        utils::Logger::instance().error("加密器未初始化");
+        return;
+    }
 
-        // 发送解密后的Opus数据
-        emit audioDataReceived(opus_data);
+    // 在接收缓冲上原地解密（不拷贝数据报、不分配中间缓冲）
+    uint32_t timestamp, sequence;
+    const int payloadSize = m_encryptor->decryptInPlace(data, static_cast<int>(size), timestamp, sequence);
+    publishReceiveStats(false);
+    if (payloadSize < 0) {
+        utils::Logger::instance().error("音频包解密失败");
+        return;
     }
+    if (payloadSize == 0) {
+        // 重复/过旧包已被防重放窗口丢弃（计入统计，不逐包打日志）
+        return;
+    }
+    if (receivedNs > 0 && m_tracer) {
+        m_tracer->markDownlink(sequence, utils::TracePoint::Received, receivedNs);
+        m_tracer->markDownlink(sequence, utils::TracePoint::Decrypted);
+    }
+
+    // 发送解密后的Opus数据（携带序列号供下游做丢包补偿）
+    // 跨线程投递需要独立副本：这是每包唯一的一次分配
+    emit audioDataReceived(QByteArray(data + sizeof(audio::AudioPacketHeader), payloadSize), sequence);
+}
+
+void UdpWorker::publishReceiveStats(bool force) {
+    if (!force && m_statsClock.isValid() && m_statsClock.elapsed() < STATS_INTERVAL_MS) {
+        return;
+    }
+    m_statsClock.restart();
+
+    const audio::ReceiveStats& s = m_encryptor->receiveStats();
+    QVariantMap stats;
+    stats["received"] = s.received;
+    stats["lost"] = s.lost;
+    stats["reordered"] = s.reordered;
+    stats["duplicated"] = s.duplicated;
+    stats["late"] = s.late;
+    stats["sendDropped"] = m_sendDropped;
+    emit receiveStatsUpdated(stats);
 }
 
 void UdpWorker::sendTestAudio(const QString& sessionId) {
@@ -194,15 +502,23 @@ void UdpWorker::sendTestAudio(const QString& sessionId) {
         QJsonDocument doc(audioPacket);
         QByteArray packetData = doc.toJson(QJsonDocument::Compact);
 
-        // 发送数据包
-        m_socket->writeDatagram(
-            packetData,
-            QHostAddress(m_config.server),
-            m_config.port
-        );
-
-        // 小延迟避免网络拥塞
-        QThread::msleep(10);
+        // 每块间隔10ms避免网络拥塞；用定时器排程而非msleep，不阻塞共享的实时音频线程
+        QTimer::singleShot(i * 10, this, [this, packetData]() {
+            if (!m_connected) {
+                return;
+            }
+#ifdef Q_OS_LINUX
+            if (m_native) {
+                ::send(m_native->fd, packetData.constData(), static_cast<size_t>(packetData.size()), 0);
+                return;
+            }
+#endif
+            m_socket->writeDatagram(
+                packetData,
+                m_peerAddress,
+                m_config.port
+            );
+        });
     }
 }
 
@@ -235,10 +551,10 @@ QByteArray UdpWorker::generateTestAudio() {
 
 UdpManager::UdpManager(QObject* parent)
     : QObject(parent)
-    , m_workerThread(new QThread(this))
+    , m_workerThread(NetworkThreadPool::instance().acquire(NetworkThreadPool::Lane::Audio))
     , m_worker(new UdpWorker())
 {
-    // 将worker移到工作线程
+    // 将worker移到共享的实时音频线程
     m_worker->moveToThread(m_workerThread);
 
     // 连接信号
@@ -255,17 +571,15 @@ UdpManager::UdpManager(QObject* parent)
             this, &UdpManager::udpConnected);
     connect(m_worker, &UdpWorker::audioDataReceived,
             this, &UdpManager::audioDataReceived);
+    connect(m_worker, &UdpWorker::receiveStatsUpdated,
+            this, &UdpManager::receiveStatsUpdated);
     connect(m_worker, &UdpWorker::errorOccurred,
             this, &UdpManager::errorOccurred);
-
-    // 启动工作线程
-    m_workerThread->start();
 }
 
 UdpManager::~UdpManager() {
-    m_workerThread->quit();
-    m_workerThread->wait();
-    delete m_worker;
+    // 共享线程继续服务其他设备，只在其中销毁本工作者
+    NetworkThreadPool::instance().retire(m_worker);
 }
 
 void UdpManager::connectToUdp(const UdpConfig& config) {
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T22:15:00Z
+Updated: 2026-10-17T10:20:00Z
 File: UdpManager.h
 Desc: UDP音频通道管理器（线程方式，完整加密音频发送/接收）
 */
@@ -16,13 +16,28 @@ Desc: UDP音频通道管理器（线程方式，完整加密音频发送/接收
 #include <QObject>
 #include <QThread>
 #include <QUdpSocket>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QElapsedTimer>
+#include <QVariantMap>
 #include <memory>
 
 namespace xiaozhi {
+namespace utils {
+class LatencyTracer;
+}
+
 namespace network {
 
 /**
  * @brief UDP工作线程
+ *
+ * 所在线程是NetworkThreadPool中的共享实时音频线程（TimeCriticalPriority），
+ * 多个设备的UDP工作者按负载分布其上；上行采集编码工作者与其同线程，可直接调用sendAudioData
+ *
+ * Linux下使用原生UDP套接字：recvmmsg一次取回多个数据报到预分配区，
+ * 上行逐包直接send（每60ms一帧，攒批无收益）；其他平台走QUdpSocket。
+ * 服务器域名异步解析，不阻塞共享线程上的其他设备
  */
 class UdpWorker : public QObject {
     Q_OBJECT
@@ -31,6 +46,11 @@ public:
     explicit UdpWorker(QObject* parent = nullptr);
     ~UdpWorker();
 
+    /**
+     * @brief 设置延迟追踪器（需在工作线程中调用；为空时不打点）
+     */
+    void setLatencyTracer(std::shared_ptr<utils::LatencyTracer> tracer) { m_tracer = std::move(tracer); }
+
 public slots:
     /**
      * @brief 连接UDP服务器（在工作线程中执行）
@@ -61,8 +81,16 @@ signals:
 
     /**
      * @brief 收到解密后的音频数据（Opus格式）
+     * @param opus_data Opus数据
+     * @param sequence 包头序列号（用于丢包检测与补偿）
      */
-    void audioDataReceived(const QByteArray& opus_data);
+    void audioDataReceived(const QByteArray& opus_data, quint32 sequence);
+
+    /**
+     * @brief 下行包序列统计更新（收包期间约每秒一次）
+     * @param stats received/lost/reordered/duplicated/late，以及sendDropped（发送缓冲满丢弃的上行包数）
+     */
+    void receiveStatsUpdated(const QVariantMap& stats);
 
     /**
      * @brief 发生错误
@@ -75,16 +103,74 @@ private slots:
      */
     void onReadyRead();
 
+    /**
+     * @brief 原生套接字可读：recvmmsg批量接收（仅Linux）
+     */
+    void onNativeReadyRead();
+
+    /**
+     * @brief 服务器域名解析完成（在工作线程中回调）
+     */
+    void onPeerResolved(const QHostInfo& info);
+
 private:
     /**
      * @brief 生成正弦波测试音频（16kHz PCM, 440Hz A4音符）
      */
     QByteArray generateTestAudio();
 
+    /**
+     * @brief 服务器地址就绪后打开收发套接字并发出udpConnected
+     */
+    void openTransport();
+
+    /**
+     * @brief 取消进行中的域名解析
+     */
+    void abortPeerLookup();
+
+    /**
+     * @brief 上报非瞬时发送错误（按间隔节流，期间的错误只计数）
+     */
+    void reportSendError(const QString& error);
+
+    /**
+     * @brief 创建原生批量收发套接字（仅Linux，失败时回退QUdpSocket）
+     */
+    bool openNativeSocket();
+
+    /**
+     * @brief 关闭原生套接字并丢弃未发送的包
+     */
+    void closeNativeSocket();
+
+    /**
+     * @brief 在接收缓冲上原地解密单个数据报并发出audioDataReceived
+     */
+    void handleDatagram(char* data, qint64 size, qint64 receivedNs);
+
+    /**
+     * @brief 发布下行包序列统计（force为false时按间隔节流）
+     */
+    void publishReceiveStats(bool force);
+
+    // 原生收发状态（收发预分配区、mmsghdr数组等，平台相关，定义在实现文件中）
+    struct NativeBatchIo;
+
     QUdpSocket* m_socket;
     UdpConfig m_config;
     bool m_connected;
     std::unique_ptr<audio::AudioEncryptor> m_encryptor;  // 音频加密器
+    QHostAddress m_peerAddress;                           // 已解析的服务器地址（不再逐包构造）
+    int m_lookupId;                                       // 进行中的域名解析（-1表示无）
+    QByteArray m_rxDatagram;                              // QUdpSocket路径复用的接收缓冲
+    QByteArray m_txDatagram;                              // QUdpSocket路径复用的发送缓冲
+    std::unique_ptr<NativeBatchIo> m_native;              // 非空表示使用原生批量收发
+    QElapsedTimer m_statsClock;                           // 统计发布节流
+    qint64 m_sendDropped;                                 // 发送缓冲满（EAGAIN/ENOBUFS）丢弃的上行包数
+    QElapsedTimer m_sendErrorClock;                       // 发送错误上报节流
+    int m_suppressedSendErrors;                           // 节流期间省略的发送错误数
+    std::shared_ptr<utils::LatencyTracer> m_tracer;       // 延迟追踪（可为空）
 };
 
 /**
@@ -118,6 +204,16 @@ public:
      */
     void sendTestAudio(const QString& sessionId);
 
+    /**
+     * @brief 工作线程（共享的高优先级实时音频线程，上行音频工作者应移入此线程）
+     */
+    QThread* workerThread() const { return m_workerThread; }
+
+    /**
+     * @brief UDP工作者（仅允许在workerThread中直接调用）
+     */
+    UdpWorker* worker() const { return m_worker; }
+
 signals:
     /**
      * @brief UDP连接成功
@@ -126,8 +222,15 @@ signals:
 
     /**
      * @brief 收到解密后的音频数据（Opus格式）
+     * @param opus_data Opus数据
+     * @param sequence 包头序列号（用于丢包检测与补偿）
+     */
+    void audioDataReceived(const QByteArray& opus_data, quint32 sequence);
+
+    /**
+     * @brief 下行包序列统计更新（收包期间约每秒一次）
      */
-    void audioDataReceived(const QByteArray& opus_data);
+    void receiveStatsUpdated(const QVariantMap& stats);
 
     /**
      * @brief 发生错误
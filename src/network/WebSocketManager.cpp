@@ -3,18 +3,22 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-01-12T16:00:00Z
+Updated: 2026-10-17T16:30:00Z
 File: WebSocketManager.cpp
 Desc: WebSocket通信管理器实现（完全复刻ESP32 websocket_protocol逻辑）
 */
 
 #include "WebSocketManager.h"
+#include "TlsSessionCache.h"
+#include "NetworkThreadPool.h"
 #include "../utils/Logger.h"
+#include "../utils/LatencyTracer.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QtEndian>
 #include <QSslConfiguration>
+#include <QUrl>
 
 namespace xiaozhi {
 namespace network {
@@ -44,47 +48,39 @@ struct BinaryProtocol3 {
 #pragma pack(pop)
 
 // ============================================================================
-// WebSocketManager实现
+// WebSocketWorker实现
 // ============================================================================
 
-WebSocketManager::WebSocketManager(QObject* parent)
+WebSocketWorker::WebSocketWorker(QObject* parent)
     : QObject(parent)
     , m_webSocket(nullptr)
     , m_helloReceived(false)
     , m_helloTimer(new QTimer(this))
+    , m_generation(0)
 {
     m_helloTimer->setSingleShot(true);
-    connect(m_helloTimer, &QTimer::timeout, this, &WebSocketManager::onHelloTimeout);
+    connect(m_helloTimer, &QTimer::timeout, this, &WebSocketWorker::onHelloTimeout);
 }
 
-WebSocketManager::~WebSocketManager() {
+WebSocketWorker::~WebSocketWorker() {
     disconnect();
 }
 
-bool WebSocketManager::connectToServer(const WebSocketConfig& config, 
-                                      const QString& deviceId, 
-                                      const QString& clientId) {
-    QMutexLocker locker(&m_mutex);
-
-    if (!config.isValid()) {
-        utils::Logger::instance().error("WebSocket配置无效");
-        emit errorOccurred("WebSocket配置无效");
-        return false;
-    }
-
-    // 断开旧连接
-    if (m_webSocket != nullptr) {
-        m_webSocket->deleteLater();
-        m_webSocket = nullptr;
-    }
+void WebSocketWorker::connectToServer(const WebSocketConfig& config,
+                                      const QString& deviceId,
+                                      const QString& clientId,
+                                      quint64 generation) {
+    // 断开旧连接（以旧代号通知，管理器据此丢弃）
+    disconnect();
 
+    m_generation = generation;
     m_config = config;
     m_deviceId = deviceId;
     m_clientId = clientId;
     m_helloReceived = false;
     m_sessionId.clear();
 
-    // 创建WebSocket
+    // 创建WebSocket（随工作者处于网络线程）
     m_webSocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
 
     // 配置SSL（如果是wss://）
@@ -93,8 +89,16 @@ bool WebSocketManager::connectToServer(const WebSocketConfig& config,
         // 在生产环境中，应该验证证书
         // 这里为了兼容性暂时不验证
         sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
+
+        // TLS会话恢复：带上同一服务器上次的会话票据，重连只需一次往返
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        const QByteArray ticket = TlsSessionCache::instance().sessionTicket(tlsPeer());
+        if (!ticket.isEmpty()) {
+            sslConfig.setSessionTicket(ticket);
+        }
         m_webSocket->setSslConfiguration(sslConfig);
-        utils::Logger::instance().info("🔒 WebSocket使用SSL/TLS加密");
+        utils::Logger::instance().info(ticket.isEmpty() ? "🔒 WebSocket使用SSL/TLS加密"
+                                                        : "🔒 WebSocket使用SSL/TLS加密（恢复会话）");
     }
 
     // 设置HTTP Headers（对齐ESP32）
@@ -120,14 +124,14 @@ bool WebSocketManager::connectToServer(const WebSocketConfig& config,
     request.setRawHeader("Client-Id", m_clientId.toUtf8());
 
     // 连接信号
-    connect(m_webSocket, &QWebSocket::connected, this, &WebSocketManager::onWebSocketConnected);
-    connect(m_webSocket, &QWebSocket::disconnected, this, &WebSocketManager::onWebSocketDisconnected);
+    connect(m_webSocket, &QWebSocket::connected, this, &WebSocketWorker::onWebSocketConnected);
+    connect(m_webSocket, &QWebSocket::disconnected, this, &WebSocketWorker::onWebSocketDisconnected);
     connect(m_webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error),
-            this, &WebSocketManager::onWebSocketError);
+            this, &WebSocketWorker::onWebSocketError);
     connect(m_webSocket, &QWebSocket::textMessageReceived, 
-            this, &WebSocketManager::onWebSocketTextMessageReceived);
+            this, &WebSocketWorker::onWebSocketTextMessageReceived);
     connect(m_webSocket, &QWebSocket::binaryMessageReceived, 
-            this, &WebSocketManager::onWebSocketBinaryMessageReceived);
+            this, &WebSocketWorker::onWebSocketBinaryMessageReceived);
 
     // 已移除WebSocket连接URL日志（敏感信息）
 
@@ -136,16 +140,16 @@ bool WebSocketManager::connectToServer(const WebSocketConfig& config,
     
     // 启动Hello超时计时器
     m_helloTimer->start(HELLO_TIMEOUT_MS);
-
-    return true;
 }
 
-void WebSocketManager::disconnect() {
-    QMutexLocker locker(&m_mutex);
-
+void WebSocketWorker::disconnect() {
     m_helloTimer->stop();
 
-    if (m_webSocket != nullptr) {
+    const bool hadSocket = m_webSocket != nullptr;
+    if (hadSocket) {
+        saveTlsSession();
+        // 先断开信号，close()同步发出的disconnected不再经onWebSocketDisconnected重复通知
+        QObject::disconnect(m_webSocket, nullptr, this, nullptr);
         m_webSocket->close();
         m_webSocket->deleteLater();
         m_webSocket = nullptr;
@@ -153,47 +157,48 @@ void WebSocketManager::disconnect() {
 
     m_helloReceived = false;
     m_sessionId.clear();
+
+    if (hadSocket) {
+        emit disconnected(m_generation);
+    }
 }
 
-bool WebSocketManager::isConnected() const {
+bool WebSocketWorker::isConnected() const {
     return m_webSocket != nullptr && 
            m_webSocket->state() == QAbstractSocket::ConnectedState &&
            m_helloReceived;
 }
 
-bool WebSocketManager::sendAudioData(const QByteArray& opusData, quint32 timestamp) {
-    QMutexLocker locker(&m_mutex);
-
+bool WebSocketWorker::sendAudioData(const QByteArray& opusData, quint32 timestamp) {
     if (!isConnected()) {
         return false;
     }
 
-    QByteArray packet = buildBinaryPacket(opusData, timestamp);
-    
-    // 检查数据包是否构建成功
-    if (packet.isEmpty()) {
-        utils::Logger::instance().error("构建音频数据包失败");
-        return false;
+    const quint32 traceId = (m_tracer && m_tracer->isEnabled()) ? m_tracer->currentUplinkFrame() : 0;
+
+    // Version 1无包头直接发送；其他版本写入复用的发送缓冲（QWebSocket发送时即拷贝入帧，不持有）
+    qint64 sent = 0;
+    if (m_config.version == 2 || m_config.version == 3) {
+        if (!WebSocketManager::buildBinaryPacketInto(m_config.version, opusData, timestamp, m_txPacket)) {
+            utils::Logger::instance().error("构建音频数据包失败");
+            return false;
+        }
+        sent = m_webSocket->sendBinaryMessage(m_txPacket);
+    } else {
+        sent = m_webSocket->sendBinaryMessage(opusData);
+    }
+    if (sent > 0 && traceId != 0) {
+        m_tracer->markUplink(traceId, utils::TracePoint::Sent);
     }
-    
-    qint64 sent = m_webSocket->sendBinaryMessage(packet);
     
     return sent > 0;
 }
 
-bool WebSocketManager::sendJsonMessage(const QString& jsonData) {
-    QMutexLocker locker(&m_mutex);
-
+bool WebSocketWorker::sendJsonMessage(const QString& jsonData) {
     if (!isConnected()) {
         return false;
     }
 
-    //  安全检查：确保JSON数据有效
-    if (jsonData.isEmpty()) {
-        utils::Logger::instance().error("JSON消息为空，无法发送");
-        return false;
-    }
-
     qint64 sent = m_webSocket->sendTextMessage(jsonData);
     
     if (sent <= 0) {
@@ -202,59 +207,14 @@ bool WebSocketManager::sendJsonMessage(const QString& jsonData) {
         QString logMsg = (len > 0 && len <= 200) ? jsonData : 
                         (len > 200) ? jsonData.left(200) + "..." : "(empty)";
         utils::Logger::instance().error(QString("发送JSON消息失败: %1").arg(logMsg));
+        emit errorOccurred("发送JSON消息失败");
         return false;
     }
 
     return true;
 }
 
-bool WebSocketManager::sendStartListening(const QString& mode) {
-    // 对齐ESP32固件：{"session_id":"xxx","type":"listen","state":"start","mode":"manual|auto|realtime"}
-    QJsonObject json;
-    json["session_id"] = m_sessionId;
-    json["type"] = "listen";
-    json["state"] = "start";
-    json["mode"] = mode.isEmpty() ? QString("manual") : mode;  // 默认manual模式
-    
-    QJsonDocument doc(json);
-    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
-    QString jsonStr = QString::fromUtf8(jsonBytes);
-    
-    utils::Logger::instance().debug(QString("📤 WebSocket发送listen消息: %1").arg(jsonStr));
-    return sendJsonMessage(jsonStr);
-}
-
-bool WebSocketManager::sendStopListening() {
-    // 对齐ESP32固件：{"session_id":"xxx","type":"listen","state":"stop"}
-    QJsonObject json;
-    json["session_id"] = m_sessionId;
-    json["type"] = "listen";
-    json["state"] = "stop";
-    
-    QJsonDocument doc(json);
-    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
-    QString jsonStr = QString::fromUtf8(jsonBytes);
-    
-    return sendJsonMessage(jsonStr);
-}
-
-bool WebSocketManager::sendAbortSpeaking() {
-    QJsonObject json;
-    json["type"] = "abort";
-    json["session_id"] = m_sessionId;
-    
-    QJsonDocument doc(json);
-    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
-    QString jsonStr = QString::fromUtf8(jsonBytes);
-    
-    return sendJsonMessage(jsonStr);
-}
-
-// ============================================================================
-// Private slots
-// ============================================================================
-
-void WebSocketManager::onWebSocketConnected() {
+void WebSocketWorker::onWebSocketConnected() {
     utils::Logger::instance().info(" WebSocket TCP连接已建立，正在发送Hello消息...");
     
     // 发送客户端Hello消息
@@ -265,21 +225,33 @@ void WebSocketManager::onWebSocketConnected() {
     }
 }
 
-void WebSocketManager::onWebSocketDisconnected() {
+void WebSocketWorker::onWebSocketDisconnected() {
     utils::Logger::instance().info("🔌 WebSocket连接已断开");
     m_helloReceived = false;
     m_helloTimer->stop();
-    emit disconnected();
+    emit disconnected(m_generation);
 }
 
-void WebSocketManager::onWebSocketError(QAbstractSocket::SocketError error) {
+QString WebSocketWorker::tlsPeer() const {
+    const QUrl url(m_config.url);
+    return QString("%1:%2").arg(url.host()).arg(url.port(443));
+}
+
+void WebSocketWorker::saveTlsSession() {
+    if (m_webSocket == nullptr || !m_config.url.startsWith("wss://")) {
+        return;
+    }
+    TlsSessionCache::instance().storeSessionTicket(tlsPeer(), m_webSocket->sslConfiguration().sessionTicket());
+}
+
+void WebSocketWorker::onWebSocketError(QAbstractSocket::SocketError error) {
     QString errorStr = m_webSocket ? m_webSocket->errorString() : "Unknown error";
     utils::Logger::instance().error(QString("❌ WebSocket错误: %1 (code: %2)")
         .arg(errorStr).arg(static_cast<int>(error)));
     emit errorOccurred(errorStr);
 }
 
-void WebSocketManager::onWebSocketTextMessageReceived(const QString& message) {
+void WebSocketWorker::onWebSocketTextMessageReceived(const QString& message) {
     //  安全检查：确保消息有效
     if (message.isEmpty()) {
         utils::Logger::instance().warn("收到空的文本消息");
@@ -303,23 +275,23 @@ void WebSocketManager::onWebSocketTextMessageReceived(const QString& message) {
 
     if (type == "hello") {
         // 服务器Hello响应
-        parseServerHello(message);
+        parseServerHello(jsonObj);
     } else {
         // 其他JSON消息（stt, tts, llm, system等）
         emit jsonMessageReceived(message);
     }
 }
 
-void WebSocketManager::onWebSocketBinaryMessageReceived(const QByteArray& message) {
-    // 解析二进制音频数据
-    QByteArray opusData = parseBinaryPacket(message);
+void WebSocketWorker::onWebSocketBinaryMessageReceived(const QByteArray& message) {
+    // 在网络线程中校验包头；投递原消息（只增加引用计数）与负载位置，负载不拷出
+    const QByteArrayView payload = WebSocketManager::binaryPayloadView(m_config.version, message);
     
-    if (!opusData.isEmpty()) {
-        emit audioDataReceived(opusData);
+    if (!payload.isEmpty()) {
+        emit audioDataReceived(message, payload.data() - message.constData(), payload.size());
     }
 }
 
-void WebSocketManager::onHelloTimeout() {
+void WebSocketWorker::onHelloTimeout() {
     if (!m_helloReceived) {
         utils::Logger::instance().error(" 等待服务器Hello响应超时");
         disconnect();
@@ -327,11 +299,7 @@ void WebSocketManager::onHelloTimeout() {
     }
 }
 
-// ============================================================================
-// Private methods
-// ============================================================================
-
-bool WebSocketManager::sendClientHello() {
+bool WebSocketWorker::sendClientHello() {
     // 构建客户端Hello消息（对齐ESP32固件）
     QJsonObject json;
     json["type"] = "hello";
@@ -362,10 +330,7 @@ bool WebSocketManager::sendClientHello() {
     return sent > 0;
 }
 
-void WebSocketManager::parseServerHello(const QString& message) {
-    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
-    QJsonObject json = doc.object();
-
+void WebSocketWorker::parseServerHello(const QJsonObject& json) {
     // 验证transport
     QString transport = json["transport"].toString();
     if (transport != "websocket") {
@@ -389,75 +354,259 @@ void WebSocketManager::parseServerHello(const QString& message) {
     m_helloReceived = true;
     m_helloTimer->stop();
 
+    // TLS 1.3的会话票据在握手后才下发，收到hello时已到达
+    saveTlsSession();
+
     // 已移除WebSocket握手详情和服务器参数日志（敏感信息）
 
+    emit helloCompleted(m_config, m_sessionId, m_generation);
+}
+
+// ============================================================================
+// WebSocketManager实现
+// ============================================================================
+
+WebSocketManager::WebSocketManager(QObject* parent)
+    : QObject(parent)
+    , m_workerThread(NetworkThreadPool::instance().acquire(NetworkThreadPool::Lane::Audio))
+    , m_worker(new WebSocketWorker())
+    , m_connected(false)
+    , m_active(false)
+    , m_generation(0)
+{
+    // 将worker移到共享的实时音频线程（WebSocket模式下音频帧也走此通道）
+    m_worker->moveToThread(m_workerThread);
+
+    // 连接信号
+    connect(this, &WebSocketManager::connectToServerInternal,
+            m_worker, &WebSocketWorker::connectToServer);
+    connect(this, &WebSocketManager::disconnectInternal,
+            m_worker, &WebSocketWorker::disconnect);
+    connect(this, &WebSocketManager::sendAudioDataInternal,
+            m_worker, &WebSocketWorker::sendAudioData);
+    connect(this, &WebSocketManager::sendJsonMessageInternal,
+            m_worker, &WebSocketWorker::sendJsonMessage);
+
+    connect(m_worker, &WebSocketWorker::helloCompleted,
+            this, &WebSocketManager::onWorkerHelloCompleted);
+    connect(m_worker, &WebSocketWorker::disconnected,
+            this, &WebSocketManager::onWorkerDisconnected);
+    connect(m_worker, &WebSocketWorker::audioDataReceived,
+            this, &WebSocketManager::audioDataReceived);
+    connect(m_worker, &WebSocketWorker::jsonMessageReceived,
+            this, &WebSocketManager::jsonMessageReceived);
+    connect(m_worker, &WebSocketWorker::errorOccurred,
+            this, &WebSocketManager::errorOccurred);
+}
+
+WebSocketManager::~WebSocketManager() {
+    // 共享线程继续服务其他设备，只在其中销毁本工作者（析构时断开连接）
+    NetworkThreadPool::instance().retire(m_worker);
+}
+
+bool WebSocketManager::connectToServer(const WebSocketConfig& config, 
+                                      const QString& deviceId, 
+                                      const QString& clientId) {
+    if (!config.isValid()) {
+        utils::Logger::instance().error("WebSocket配置无效");
+        emit errorOccurred("WebSocket配置无效");
+        return false;
+    }
+
+    // 重连前先结束旧连接，接收方能看到一次disconnected
+    if (m_active) {
+        disconnect();
+    }
+
+    m_config = config;
+    m_sessionId.clear();
+    m_connected = false;
+    m_active = true;
+    ++m_generation;
+
+    emit connectToServerInternal(config, deviceId, clientId, m_generation);
+    return true;
+}
+
+void WebSocketManager::disconnect() {
+    const bool wasActive = m_active;
+
+    // 新代号使工作线程中尚未送达的旧握手结果、断开通知全部失效
+    ++m_generation;
+    m_active = false;
+    m_connected = false;
+    m_sessionId.clear();
+    emit disconnectInternal();
+
+    if (wasActive) {
+        emit disconnected();
+    }
+}
+
+bool WebSocketManager::sendAudioData(const QByteArray& opusData, quint32 timestamp) {
+    if (!m_connected) {
+        return false;
+    }
+
+    emit sendAudioDataInternal(opusData, timestamp);
+    return true;
+}
+
+bool WebSocketManager::sendJsonMessage(const QString& jsonData) {
+    if (!m_connected) {
+        return false;
+    }
+
+    //  安全检查：确保JSON数据有效
+    if (jsonData.isEmpty()) {
+        utils::Logger::instance().error("JSON消息为空，无法发送");
+        return false;
+    }
+
+    emit sendJsonMessageInternal(jsonData);
+    return true;
+}
+
+bool WebSocketManager::sendStartListening(const QString& mode) {
+    // 对齐ESP32固件：{"session_id":"xxx","type":"listen","state":"start","mode":"manual|auto|realtime"}
+    QJsonObject json;
+    json["session_id"] = m_sessionId;
+    json["type"] = "listen";
+    json["state"] = "start";
+    json["mode"] = mode.isEmpty() ? QString("manual") : mode;  // 默认manual模式
+    
+    QJsonDocument doc(json);
+    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
+    QString jsonStr = QString::fromUtf8(jsonBytes);
+    
+    utils::Logger::instance().debug(QString("📤 WebSocket发送listen消息: %1").arg(jsonStr));
+    return sendJsonMessage(jsonStr);
+}
+
+bool WebSocketManager::sendStopListening() {
+    // 对齐ESP32固件：{"session_id":"xxx","type":"listen","state":"stop"}
+    QJsonObject json;
+    json["session_id"] = m_sessionId;
+    json["type"] = "listen";
+    json["state"] = "stop";
+    
+    QJsonDocument doc(json);
+    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
+    QString jsonStr = QString::fromUtf8(jsonBytes);
+    
+    return sendJsonMessage(jsonStr);
+}
+
+bool WebSocketManager::sendAbortSpeaking() {
+    QJsonObject json;
+    json["type"] = "abort";
+    json["session_id"] = m_sessionId;
+    
+    QJsonDocument doc(json);
+    QByteArray jsonBytes = doc.toJson(QJsonDocument::Compact);
+    QString jsonStr = QString::fromUtf8(jsonBytes);
+    
+    return sendJsonMessage(jsonStr);
+}
+
+void WebSocketManager::onWorkerHelloCompleted(const WebSocketConfig& config, const QString& sessionId,
+                                              quint64 generation) {
+    if (generation != m_generation || !m_active) {
+        return;  // disconnect()之后才送达的旧连接握手结果
+    }
+
+    // 先缓存握手结果，connected的接收方可立即读取会话ID与服务器参数
+    m_config = config;
+    m_sessionId = sessionId;
+    m_connected = true;
     emit connected();
 }
 
-QByteArray WebSocketManager::buildBinaryPacket(const QByteArray& opusData, quint32 timestamp) {
+void WebSocketManager::onWorkerDisconnected(quint64 generation) {
+    if (generation != m_generation || !m_active) {
+        return;  // 已由disconnect()/重连通知过
+    }
+
+    m_active = false;
+    m_connected = false;
+    m_sessionId.clear();
+    emit disconnected();
+}
+
+// ============================================================================
+// 二进制协议编解码（无状态）
+// ============================================================================
+
+qsizetype WebSocketManager::binaryHeaderSize(int version) {
+    if (version == 2) {
+        return static_cast<qsizetype>(sizeof(BinaryProtocol2));
+    } else if (version == 3) {
+        return static_cast<qsizetype>(sizeof(BinaryProtocol3));
+    }
+    return 0;
+}
+
+bool WebSocketManager::buildBinaryPacketInto(int version, QByteArrayView opusData, quint32 timestamp,
+                                             QByteArray& packet) {
     // 安全检查：数据大小必须合理
     if (opusData.isEmpty() || opusData.size() > 1024 * 1024) {  // 最大1MB
         utils::Logger::instance().error(QString("Opus数据大小异常: %1").arg(opusData.size()));
-        return QByteArray();
+        return false;
+    }
+    if (version == 3 && opusData.size() > 65535) {
+        utils::Logger::instance().error(QString("Version 3不支持大于65535字节的数据: %1").arg(opusData.size()));
+        return false;
     }
-    
-    if (m_config.version == 2) {
-        // Version 2: 使用BinaryProtocol2
-        int packetSize = static_cast<int>(sizeof(BinaryProtocol2)) + opusData.size();
-        if (packetSize < 0) {  // 溢出检查
-            utils::Logger::instance().error("数据包大小溢出");
-            return QByteArray();
-        }
-        
-        QByteArray packet;
-        packet.resize(packetSize);
 
-        BinaryProtocol2* header = reinterpret_cast<BinaryProtocol2*>(packet.data());
-        header->version = qToBigEndian<quint16>(m_config.version);
+    // 未共享且容量足够时resize不分配，逐帧复用同一块内存
+    const qsizetype headerSize = binaryHeaderSize(version);
+    packet.resize(headerSize + opusData.size());
+    char* out = packet.data();
+
+    if (version == 2) {
+        // Version 2: 使用BinaryProtocol2
+        BinaryProtocol2* header = reinterpret_cast<BinaryProtocol2*>(out);
+        header->version = qToBigEndian<quint16>(static_cast<quint16>(version));
         header->type = qToBigEndian<quint16>(0);  // 0 = OPUS
         header->reserved = 0;
         header->timestamp = qToBigEndian<quint32>(timestamp);
         header->payload_size = qToBigEndian<quint32>(static_cast<quint32>(opusData.size()));
-
-        memcpy(packet.data() + sizeof(BinaryProtocol2), opusData.data(), static_cast<size_t>(opusData.size()));
-        return packet;
-
-    } else if (m_config.version == 3) {
+    } else if (version == 3) {
         // Version 3: 使用BinaryProtocol3
-        if (opusData.size() > 65535) {
-            utils::Logger::instance().error(QString("Version 3不支持大于65535字节的数据: %1").arg(opusData.size()));
-            return QByteArray();
-        }
-        
-        int packetSize = static_cast<int>(sizeof(BinaryProtocol3)) + opusData.size();
-        if (packetSize < 0) {  // 溢出检查
-            utils::Logger::instance().error("数据包大小溢出");
-            return QByteArray();
-        }
-        
-        QByteArray packet;
-        packet.resize(packetSize);
-
-        BinaryProtocol3* header = reinterpret_cast<BinaryProtocol3*>(packet.data());
+        BinaryProtocol3* header = reinterpret_cast<BinaryProtocol3*>(out);
         header->type = 0;  // 0 = OPUS
         header->reserved = 0;
         header->payload_size = qToBigEndian<quint16>(static_cast<quint16>(opusData.size()));
+    }
+    // Version 1: 无包头，直接为Opus数据
 
-        memcpy(packet.data() + sizeof(BinaryProtocol3), opusData.data(), static_cast<size_t>(opusData.size()));
-        return packet;
+    memcpy(out + headerSize, opusData.data(), static_cast<size_t>(opusData.size()));
+    return true;
+}
 
-    } else {
-        // Version 1: 直接发送Opus数据
+QByteArray WebSocketManager::buildBinaryPacket(int version, const QByteArray& opusData, quint32 timestamp) {
+    if (version != 2 && version != 3) {
+        // Version 1: 直接发送Opus数据（共享输入，不拷贝）
+        if (opusData.isEmpty() || opusData.size() > 1024 * 1024) {
+            utils::Logger::instance().error(QString("Opus数据大小异常: %1").arg(opusData.size()));
+            return QByteArray();
+        }
         return opusData;
     }
+
+    QByteArray packet;
+    if (!buildBinaryPacketInto(version, opusData, timestamp, packet)) {
+        return QByteArray();
+    }
+    return packet;
 }
 
-QByteArray WebSocketManager::parseBinaryPacket(const QByteArray& data) {
-    if (m_config.version == 2) {
+QByteArrayView WebSocketManager::binaryPayloadView(int version, QByteArrayView data) {
+    if (version == 2) {
         // Version 2: 解析BinaryProtocol2
-        if (data.size() < static_cast<int>(sizeof(BinaryProtocol2))) {
+        if (data.size() < static_cast<qsizetype>(sizeof(BinaryProtocol2))) {
             utils::Logger::instance().warn("二进制数据包太小（Version 2）");
-            return QByteArray();
+            return QByteArrayView();
         }
 
         const BinaryProtocol2* header = reinterpret_cast<const BinaryProtocol2*>(data.data());
@@ -466,49 +615,48 @@ QByteArray WebSocketManager::parseBinaryPacket(const QByteArray& data) {
         // 安全检查：payloadSize必须合理
         if (payloadSize == 0 || payloadSize > 1024 * 1024) {  // 最大1MB
             utils::Logger::instance().warn(QString("无效的payload大小: %1").arg(payloadSize));
-            return QByteArray();
+            return QByteArrayView();
         }
 
-        int expectedSize = static_cast<int>(sizeof(BinaryProtocol2)) + static_cast<int>(payloadSize);
+        qsizetype expectedSize = static_cast<qsizetype>(sizeof(BinaryProtocol2)) + static_cast<qsizetype>(payloadSize);
         if (data.size() < expectedSize) {
             utils::Logger::instance().warn(QString("二进制数据包长度不匹配（Version 2）: 期望%1, 实际%2")
                 .arg(expectedSize).arg(data.size()));
-            return QByteArray();
+            return QByteArrayView();
         }
 
-        return data.mid(sizeof(BinaryProtocol2), static_cast<int>(payloadSize));
+        return data.sliced(sizeof(BinaryProtocol2), static_cast<qsizetype>(payloadSize));
 
-    } else if (m_config.version == 3) {
+    } else if (version == 3) {
         // Version 3: 解析BinaryProtocol3
-        if (data.size() < static_cast<int>(sizeof(BinaryProtocol3))) {
+        if (data.size() < static_cast<qsizetype>(sizeof(BinaryProtocol3))) {
             utils::Logger::instance().warn("二进制数据包太小（Version 3）");
-            return QByteArray();
+            return QByteArrayView();
         }
 
         const BinaryProtocol3* header = reinterpret_cast<const BinaryProtocol3*>(data.data());
         quint16 payloadSize = qFromBigEndian<quint16>(header->payload_size);
         
         // 安全检查：payloadSize必须合理
-        if (payloadSize == 0 || payloadSize > 65535) {
+        if (payloadSize == 0) {
             utils::Logger::instance().warn(QString("无效的payload大小: %1").arg(payloadSize));
-            return QByteArray();
+            return QByteArrayView();
         }
 
-        int expectedSize = static_cast<int>(sizeof(BinaryProtocol3)) + static_cast<int>(payloadSize);
+        qsizetype expectedSize = static_cast<qsizetype>(sizeof(BinaryProtocol3)) + static_cast<qsizetype>(payloadSize);
         if (data.size() < expectedSize) {
             utils::Logger::instance().warn(QString("二进制数据包长度不匹配（Version 3）: 期望%1, 实际%2")
                 .arg(expectedSize).arg(data.size()));
-            return QByteArray();
+            return QByteArrayView();
         }
 
-        return data.mid(sizeof(BinaryProtocol3), static_cast<int>(payloadSize));
+        return data.sliced(sizeof(BinaryProtocol3), static_cast<qsizetype>(payloadSize));
 
     } else {
-        // Version 1: 直接返回Opus数据
+        // Version 1: 整包即Opus数据
         return data;
     }
 }
 
 } // namespace network
 } // namespace xiaozhi
-
@@ -3,23 +3,156 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-01-12T16:00:00Z
+Updated: 2026-10-17T16:30:00Z
 File: WebSocketManager.h
-Desc: WebSocket通信管理器（完全复刻ESP32 websocket_protocol实现）
+Desc: WebSocket通信管理器（线程方式，完全复刻ESP32 websocket_protocol实现）
 */
 
 #ifndef WEBSOCKET_MANAGER_H
 #define WEBSOCKET_MANAGER_H
 
 #include "NetworkTypes.h"
+#include <QByteArrayView>
 #include <QObject>
+#include <QThread>
 #include <QWebSocket>
 #include <QTimer>
-#include <QMutex>
+#include <memory>
 
 namespace xiaozhi {
+namespace utils {
+class LatencyTracer;
+}
+
 namespace network {
 
+/**
+ * @brief WebSocket工作者
+ *
+ * QWebSocket、Hello计时器及二进制包的构建/解析都在NetworkThreadPool的共享实时音频线程中，
+ * 下行音频帧的接收解析不再与QML渲染争用GUI线程；上行采集编码工作者与其同线程，
+ * 可直接调用sendAudioData（无锁、无跨线程拷贝）
+ */
+class WebSocketWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WebSocketWorker(QObject* parent = nullptr);
+    ~WebSocketWorker();
+
+    /**
+     * @brief 设置延迟追踪器（需在工作线程中调用；为空时不打点）
+     */
+    void setLatencyTracer(std::shared_ptr<utils::LatencyTracer> tracer) { m_tracer = std::move(tracer); }
+
+    /**
+     * @brief 是否已连接（仅在工作线程中调用）
+     */
+    bool isConnected() const;
+
+public slots:
+    /**
+     * @brief 连接到WebSocket服务器（在工作线程中执行，先断开旧连接）
+     * @param generation 管理器分配的连接代号，随helloCompleted/disconnected原样带回
+     */
+    void connectToServer(const WebSocketConfig& config, const QString& deviceId, const QString& clientId,
+                         quint64 generation);
+
+    /**
+     * @brief 断开连接（有连接时以其代号发出disconnected）
+     */
+    void disconnect();
+
+    /**
+     * @brief 发送音频数据（Opus编码）
+     * @param opusData Opus编码的音频数据
+     * @param timestamp 时间戳（仅Version 2使用）
+     * @return 是否已写入套接字
+     */
+    bool sendAudioData(const QByteArray& opusData, quint32 timestamp = 0);
+
+    /**
+     * @brief 发送JSON文本消息（失败时发出errorOccurred）
+     * @return 是否已写入套接字
+     */
+    bool sendJsonMessage(const QString& jsonData);
+
+signals:
+    /**
+     * @brief Hello握手完成
+     * @param config 合并了服务器音频参数的配置
+     * @param sessionId 会话ID
+     * @param generation 该连接的代号
+     */
+    void helloCompleted(const WebSocketConfig& config, const QString& sessionId, quint64 generation);
+
+    /**
+     * @brief 连接断开
+     * @param generation 该连接的代号
+     */
+    void disconnected(quint64 generation);
+
+    /**
+     * @brief 接收到音频数据（原消息与负载位置，负载不拷出）
+     * @param message 收到的二进制消息（隐式共享）
+     * @param offset Opus负载在message中的偏移
+     * @param size Opus负载长度
+     */
+    void audioDataReceived(const QByteArray& message, qsizetype offset, qsizetype size);
+
+    /**
+     * @brief 接收到JSON消息
+     */
+    void jsonMessageReceived(const QString& jsonData);
+
+    /**
+     * @brief 发生错误
+     */
+    void errorOccurred(const QString& error);
+
+private slots:
+    void onWebSocketConnected();
+    void onWebSocketDisconnected();
+    void onWebSocketError(QAbstractSocket::SocketError error);
+    void onWebSocketTextMessageReceived(const QString& message);
+    void onWebSocketBinaryMessageReceived(const QByteArray& message);
+    void onHelloTimeout();
+
+private:
+    /**
+     * @brief 发送客户端Hello消息
+     */
+    bool sendClientHello();
+
+    /**
+     * @brief 解析服务器Hello响应
+     */
+    void parseServerHello(const QJsonObject& json);
+
+    /**
+     * @brief TLS会话缓存键（主机:端口）
+     */
+    QString tlsPeer() const;
+
+    /**
+     * @brief 保存当前连接的TLS会话票据（供下次重连恢复）
+     */
+    void saveTlsSession();
+
+    QWebSocket* m_webSocket;
+    WebSocketConfig m_config;
+    QString m_deviceId;
+    QString m_clientId;
+    QString m_sessionId;
+    bool m_helloReceived;
+    QTimer* m_helloTimer;
+    quint64 m_generation;                             // 当前连接代号（由管理器分配）
+    QByteArray m_txPacket;                            // 复用的发送包缓冲（包头+负载）
+    std::shared_ptr<utils::LatencyTracer> m_tracer;  // 延迟追踪（可为空）
+
+    static constexpr int HELLO_TIMEOUT_MS = 10000;  // 10秒超时
+};
+
 /**
  * @brief WebSocket通信管理器
  * 
@@ -28,6 +161,14 @@ namespace network {
  * 2. 音频数据收发（Opus编码，支持Version 1/2/3）
  * 3. JSON消息收发（stt, tts, llm, system等）
  * 4. 自动重连机制
+ *
+ * 与MqttManager/UdpManager相同的线程方式：传输在WebSocketWorker中，
+ * 本类只在GUI线程转发调用并缓存握手结果（会话ID、服务器音频参数）。
+ * 每次connectToServer/disconnect递增连接代号，工作者回传的握手完成与断开通知
+ * 代号不符即丢弃：disconnect之后才到达的旧握手结果不会把状态改回已连接。
+ *
+ * 发送接口是投递式的：返回true只表示已连接且已排入工作线程，不代表已写入套接字；
+ * 工作线程中的文本发送失败经errorOccurred报告，音频帧发送失败只记日志（实时流不重发）
  */
 class WebSocketManager : public QObject {
     Q_OBJECT
@@ -46,32 +187,32 @@ public:
     bool connectToServer(const WebSocketConfig& config, const QString& deviceId, const QString& clientId);
 
     /**
-     * @brief 断开连接
+     * @brief 断开连接（进行中或已建立的连接立即发出disconnected）
      */
     void disconnect();
 
     /**
-     * @brief 是否已连接
+     * @brief 是否已连接（Hello握手完成）
      */
-    bool isConnected() const;
+    bool isConnected() const { return m_connected; }
 
     /**
-     * @brief 发送音频数据（Opus编码）
+     * @brief 发送音频数据（Opus编码，投递到工作线程）
      * @param opusData Opus编码的音频数据
      * @param timestamp 时间戳（仅Version 2使用）
-     * @return 是否发送成功
+     * @return 是否已投递（未连接时为false；不代表已写入套接字）
      */
     bool sendAudioData(const QByteArray& opusData, quint32 timestamp = 0);
 
     /**
-     * @brief 发送JSON文本消息
+     * @brief 发送JSON文本消息（投递到工作线程）
      * @param jsonData JSON字符串
-     * @return 是否发送成功
+     * @return 是否已投递（未连接或消息为空时为false；写入失败经errorOccurred异步报告）
      */
     bool sendJsonMessage(const QString& jsonData);
 
     /**
-     * @brief 发送对话控制消息
+     * @brief 发送对话控制消息（投递语义同sendJsonMessage）
      * @param mode 对话模式：manual/auto/realtime（仅sendStartListening需要）
      */
     bool sendStartListening(const QString& mode = "manual");
@@ -90,78 +231,100 @@ public:
     int serverChannels() const { return m_config.serverChannels; }
     int serverFrameDuration() const { return m_config.serverFrameDuration; }
 
-signals:
     /**
-     * @brief 连接成功（Hello握手完成）
+     * @brief 工作线程（共享的高优先级实时音频线程，上行音频工作者应移入此线程）
      */
-    void connected();
+    QThread* workerThread() const { return m_workerThread; }
 
     /**
-     * @brief 连接断开
+     * @brief WebSocket工作者（仅允许在workerThread中直接调用）
      */
-    void disconnected();
+    WebSocketWorker* worker() const { return m_worker; }
 
     /**
-     * @brief 接收到音频数据（已解码Opus）
-     * @param opusData Opus编码数据
+     * @brief 二进制协议包头长度（Version 1为0）
      */
-    void audioDataReceived(const QByteArray& opusData);
+    static qsizetype binaryHeaderSize(int version);
 
     /**
-     * @brief 接收到JSON消息
-     * @param jsonData JSON字符串
+     * @brief 将包头与负载写入调用方复用的缓冲（无状态，发送路径使用）
+     * @param version 协议版本（1/2/3）
+     * @param opusData Opus编码的音频数据
+     * @param timestamp 时间戳（仅Version 2使用）
+     * @param packet 输出缓冲，按需resize（容量足够时不分配）
+     * @return 是否成功
      */
-    void jsonMessageReceived(const QString& jsonData);
+    static bool buildBinaryPacketInto(int version, QByteArrayView opusData, quint32 timestamp, QByteArray& packet);
 
     /**
-     * @brief 发生错误
+     * @brief 构建二进制协议包（无状态，每次返回新包；Version 1直接共享输入）
+     * @param version 协议版本（1/2/3）
+     * @param opusData Opus编码的音频数据
+     * @param timestamp 时间戳（仅Version 2使用）
+     * @return 完整数据包，失败返回空
      */
-    void errorOccurred(const QString& error);
+    static QByteArray buildBinaryPacket(int version, const QByteArray& opusData, quint32 timestamp);
 
-private slots:
-    void onWebSocketConnected();
-    void onWebSocketDisconnected();
-    void onWebSocketError(QAbstractSocket::SocketError error);
-    void onWebSocketTextMessageReceived(const QString& message);
-    void onWebSocketBinaryMessageReceived(const QByteArray& message);
-    void onHelloTimeout();
+    /**
+     * @brief 校验二进制协议包并返回负载视图（无状态、无分配）
+     * @param version 协议版本（1/2/3）
+     * @param data 收到的二进制消息
+     * @return 指向data内部的Opus负载，格式错误返回空视图
+     */
+    static QByteArrayView binaryPayloadView(int version, QByteArrayView data);
 
-private:
+signals:
     /**
-     * @brief 发送客户端Hello消息
+     * @brief 连接成功（Hello握手完成）
      */
-    bool sendClientHello();
+    void connected();
 
     /**
-     * @brief 解析服务器Hello响应
+     * @brief 连接断开
      */
-    void parseServerHello(const QString& message);
+    void disconnected();
 
     /**
-     * @brief 构建二进制协议包（根据version）
+     * @brief 接收到音频数据（Opus负载位于message内部，以audio::OpusPacket引用即可，不必拷出）
+     * @param message 收到的二进制消息（隐式共享）
+     * @param offset Opus负载在message中的偏移
+     * @param size Opus负载长度
      */
-    QByteArray buildBinaryPacket(const QByteArray& opusData, quint32 timestamp);
+    void audioDataReceived(const QByteArray& message, qsizetype offset, qsizetype size);
 
     /**
-     * @brief 解析二进制协议包（根据version）
+     * @brief 接收到JSON消息
+     * @param jsonData JSON字符串
      */
-    QByteArray parseBinaryPacket(const QByteArray& data);
+    void jsonMessageReceived(const QString& jsonData);
+
+    /**
+     * @brief 发生错误
+     */
+    void errorOccurred(const QString& error);
+
+    // 内部信号（用于线程通信）
+    void connectToServerInternal(const WebSocketConfig& config, const QString& deviceId, const QString& clientId,
+                                 quint64 generation);
+    void disconnectInternal();
+    void sendAudioDataInternal(const QByteArray& opusData, quint32 timestamp);
+    void sendJsonMessageInternal(const QString& jsonData);
+
+private slots:
+    void onWorkerHelloCompleted(const WebSocketConfig& config, const QString& sessionId, quint64 generation);
+    void onWorkerDisconnected(quint64 generation);
 
 private:
-    QWebSocket* m_webSocket;
+    QThread* m_workerThread;
+    WebSocketWorker* m_worker;
     WebSocketConfig m_config;
-    QString m_deviceId;
-    QString m_clientId;
     QString m_sessionId;
-    bool m_helloReceived;
-    QTimer* m_helloTimer;
-    QMutex m_mutex;
-
-    static constexpr int HELLO_TIMEOUT_MS = 10000;  // 10秒超时
+    bool m_connected;
+    bool m_active;          // 已发起连接且未断开（含握手中）
+    quint64 m_generation;   // 当前连接代号
 };
 
 } // namespace network
 } // namespace xiaozhi
 
 #endif // WEBSOCKET_MANAGER_H
-
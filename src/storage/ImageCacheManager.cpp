@@ -3,20 +3,43 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T12:00:00Z
+Updated: 2026-10-16T23:40:00Z
 File: ImageCacheManager.cpp
 Desc: 图片缓存管理器实现
 */
 
 #include "ImageCacheManager.h"
+#include "../utils/ImagePreprocessor.h"
 #include "../utils/Logger.h"
+#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
 #include <QStandardPaths>
 
 namespace xiaozhi {
 namespace storage {
 
+namespace {
+
+/**
+ * @brief 流式计算文件内容哈希（不解码图片），失败返回空
+ */
+QByteArray fileContentHash(const QString& fullPath) {
+    QFile file(fullPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+} // namespace
+
 ImageCacheManager::ImageCacheManager(QObject* parent)
     : QObject(parent)
     , m_initialized(false)
@@ -68,6 +91,10 @@ QString ImageCacheManager::generateImageFileName(qint64 timestamp, const QString
     return QString("image_%1.%2").arg(timestamp).arg(extension);
 }
 
+QString ImageCacheManager::generateThumbnailFileName(const QByteArray& contentHash) {
+    return QString("thumb_%1.jpg").arg(QString::fromLatin1(contentHash.toHex()));
+}
+
 QString ImageCacheManager::saveImageCache(const QString& deviceId, 
                                          const QString& sourceImagePath, 
                                          qint64 timestamp) {
@@ -120,6 +147,128 @@ QString ImageCacheManager::saveImageCache(const QString& deviceId,
     return relativePath;
 }
 
+QString ImageCacheManager::saveImageCache(const QString& deviceId,
+                                         const utils::PreparedImage& image,
+                                         qint64 timestamp) {
+    if (image.data.isEmpty()) {
+        // 原图直传：缓存同样保存原图
+        const QString relativePath = saveImageCache(deviceId, image.sourcePath, timestamp);
+        if (!relativePath.isEmpty() && !image.thumbnail.isEmpty()) {
+            const QString fullPath = QDir(m_basePath).filePath(relativePath);
+            storeThumbnail(fullPath, fileContentHash(fullPath), image.thumbnail);
+        }
+        return relativePath;
+    }
+
+    if (!m_initialized) {
+        emit errorOccurred("图片缓存管理器未初始化");
+        return QString();
+    }
+
+    if (!ensureDeviceDirectory(deviceId)) {
+        return QString();
+    }
+
+    const QString relativePath = QString("%1/%2").arg(deviceId, generateImageFileName(timestamp, image.format));
+    const QString fullPath = QDir(m_basePath).filePath(relativePath);
+    if (!writeCacheFile(fullPath, image.data)) {
+        return QString();
+    }
+
+    // 缩略图与原图同目录，数据已在内存中，直接计算哈希
+    if (!image.thumbnail.isEmpty()) {
+        storeThumbnail(fullPath, QCryptographicHash::hash(image.data, QCryptographicHash::Sha1),
+                       image.thumbnail);
+    }
+
+    utils::Logger::instance().info(QString("保存图片缓存: %1 (%2 bytes，原图%3 bytes)")
+        .arg(relativePath).arg(image.data.size()).arg(image.originalBytes));
+
+    return relativePath;
+}
+
+void ImageCacheManager::storeThumbnail(const QString& fullImagePath, const QByteArray& contentHash,
+                                       const QByteArray& thumbnail) {
+    if (contentHash.isEmpty()) {
+        return;
+    }
+
+    const QString thumbPath = QFileInfo(fullImagePath).dir().filePath(generateThumbnailFileName(contentHash));
+    // 相同内容的图片共用一张缩略图
+    if (!QFile::exists(thumbPath) && !writeCacheFile(thumbPath, thumbnail)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_thumbnailMutex);
+    m_thumbnailPaths.insert(fullImagePath, thumbPath);
+}
+
+QString ImageCacheManager::ensureThumbnail(const QString& imagePath) {
+    if (!m_initialized) {
+        return QString();
+    }
+
+    const QString fullPath = resolveFullPath(imagePath);
+    if (fullPath.isEmpty() || QDir(m_basePath).relativeFilePath(fullPath).startsWith("..")) {
+        return QString();
+    }
+
+    {
+        QMutexLocker locker(&m_thumbnailMutex);
+        const auto it = m_thumbnailPaths.constFind(fullPath);
+        if (it != m_thumbnailPaths.constEnd() && QFile::exists(it.value())) {
+            return it.value();
+        }
+    }
+
+    // 按内容哈希定位缩略图，旧版本缓存的图片在首次显示时补生成
+    const QByteArray contentHash = fileContentHash(fullPath);
+    if (contentHash.isEmpty()) {
+        return QString();
+    }
+    const QString thumbPath = QFileInfo(fullPath).dir().filePath(generateThumbnailFileName(contentHash));
+    if (!QFile::exists(thumbPath)) {
+        const QByteArray thumbnail = utils::ImagePreprocessor::makeThumbnail(
+            fullPath, utils::ImagePreprocessOptions().thumbnailDimension);
+        if (thumbnail.isEmpty()) {
+            utils::Logger::instance().warn(QString("生成缩略图失败: %1").arg(fullPath));
+            return QString();
+        }
+        if (!writeCacheFile(thumbPath, thumbnail)) {
+            return QString();
+        }
+    }
+
+    QMutexLocker locker(&m_thumbnailMutex);
+    m_thumbnailPaths.insert(fullPath, thumbPath);
+    return thumbPath;
+}
+
+QString ImageCacheManager::thumbnailUrl(const QString& imagePath) const {
+    if (imagePath.isEmpty() || !m_initialized) {
+        return QString();
+    }
+
+    const QString relativePath = QFileInfo(imagePath).isAbsolute()
+        ? QDir(m_basePath).relativeFilePath(imagePath)
+        : imagePath;
+    if (relativePath.startsWith("..")) {
+        return QString();
+    }
+    return QString("image://%1/%2").arg(QLatin1String(THUMBNAIL_PROVIDER_ID), relativePath);
+}
+
+bool ImageCacheManager::writeCacheFile(const QString& fullPath, const QByteArray& data) {
+    QSaveFile file(fullPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        QString error = QString("写入图片缓存失败: %1").arg(fullPath);
+        utils::Logger::instance().error(error);
+        emit errorOccurred(error);
+        return false;
+    }
+    return true;
+}
+
 QString ImageCacheManager::resolveFullPath(const QString& imagePath) const {
     if (imagePath.isEmpty()) {
         return QString();
@@ -160,7 +309,7 @@ bool ImageCacheManager::clearDeviceCache(const QString& deviceId) {
         return true;  // 目录不存在，认为清理成功
     }
     
-    // 删除目录中的所有文件
+    // 删除目录中的所有文件（含缩略图）
     QStringList files = dir.entryList(QDir::Files);
     for (const QString& file : files) {
         QString filePath = dir.filePath(file);
@@ -191,10 +340,14 @@ QStringList ImageCacheManager::getDeviceImageFiles(const QString& deviceId) {
     
     // 获取所有图片文件
     QStringList nameFilters;
-    nameFilters << "*.jpg" << "*.jpeg" << "*.png" << "*.gif" << "*.bmp";
+    nameFilters << "*.jpg" << "*.jpeg" << "*.png" << "*.gif" << "*.bmp" << "*.webp";
     
     QStringList files = dir.entryList(nameFilters, QDir::Files);
     for (const QString& file : files) {
+        // 缩略图随原图管理，不单独列出
+        if (file.startsWith("thumb_")) {
+            continue;
+        }
         result.append(QString("%1/%2").arg(deviceId, file));
     }
     
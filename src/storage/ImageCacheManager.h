@@ -3,9 +3,9 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-12T12:00:00Z
+Updated: 2026-10-16T23:40:00Z
 File: ImageCacheManager.h
-Desc: 图片缓存管理器（保存和加载图片）
+Desc: 图片缓存管理器（保存和加载图片，按内容哈希管理缩略图）
 */
 
 #ifndef IMAGE_CACHE_MANAGER_H
@@ -14,13 +14,25 @@ Desc: 图片缓存管理器（保存和加载图片）
 #include <QObject>
 #include <QString>
 #include <QDir>
+#include <QHash>
+#include <QMutex>
 
 namespace xiaozhi {
+namespace utils {
+struct PreparedImage;
+}
+
 namespace storage {
 
+/**
+ * @brief QML缩略图提供器名称（image://thumbnail/<相对路径>）
+ */
+inline constexpr char THUMBNAIL_PROVIDER_ID[] = "thumbnail";
+
 /**
  * @brief 图片缓存管理器
- * 负责保存和加载发送的图片到本地缓存目录
+ * 负责保存和加载发送的图片到本地缓存目录。
+ * 缩略图按图片内容哈希命名（thumb_<sha1>.jpg），与原图同目录，相同内容只生成一次
  */
 class ImageCacheManager : public QObject {
     Q_OBJECT
@@ -47,6 +59,17 @@ public:
                           const QString& sourceImagePath, 
                           qint64 timestamp);
 
+    /**
+     * @brief 保存预处理后的图片到缓存（与上传内容一致），并按内容哈希保存缩略图
+     * @param deviceId 设备ID
+     * @param image 预处理结果（data为空时复制原图）
+     * @param timestamp 时间戳
+     * @return 相对路径（deviceId/image_timestamp.ext），失败返回空字符串
+     */
+    QString saveImageCache(const QString& deviceId,
+                          const utils::PreparedImage& image,
+                          qint64 timestamp);
+
     /**
      * @brief 将相对路径解析为绝对路径
      * @param imagePath 图片文件相对路径
@@ -61,6 +84,20 @@ public:
      */
     bool imageFileExists(const QString& imagePath);
 
+    /**
+     * @brief 获取图片缩略图路径，不存在时生成（线程安全，供缩略图提供器在工作线程调用）
+     * @param imagePath 图片文件相对路径（必须位于缓存目录内）
+     * @return 缩略图绝对路径，失败返回空字符串
+     */
+    QString ensureThumbnail(const QString& imagePath);
+
+    /**
+     * @brief 生成图片的QML缩略图URL
+     * @param imagePath 图片文件相对路径或缓存目录内的绝对路径
+     * @return image://thumbnail/deviceId/image_timestamp.ext，无效路径返回空字符串
+     */
+    QString thumbnailUrl(const QString& imagePath) const;
+
     /**
      * @brief 清理设备的所有图片缓存
      * @param deviceId 设备ID
@@ -92,8 +129,28 @@ private:
      */
     QString generateImageFileName(qint64 timestamp, const QString& extension);
 
+    /**
+     * @brief 生成缩略图文件名（thumb_<sha1>.jpg，与原图同目录）
+     */
+    static QString generateThumbnailFileName(const QByteArray& contentHash);
+
+    /**
+     * @brief 保存缩略图（同内容已存在时跳过）并记录原图到缩略图的映射
+     */
+    void storeThumbnail(const QString& fullImagePath, const QByteArray& contentHash,
+                        const QByteArray& thumbnail);
+
+    /**
+     * @brief 写入文件（先写临时文件再替换，失败时不留下半截文件）
+     */
+    bool writeCacheFile(const QString& fullPath, const QByteArray& data);
+
     QString m_basePath;
     bool m_initialized;
+
+    // 原图绝对路径 -> 缩略图绝对路径（避免重复计算哈希）
+    QMutex m_thumbnailMutex;
+    QHash<QString, QString> m_thumbnailPaths;
 };
 
 } // namespace storage
@@ -0,0 +1,127 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T23:40:00Z
+File: ThumbnailImageProvider.cpp
+Desc: 聊天记录缩略图提供器实现
+*/
+
+#include "ThumbnailImageProvider.h"
+#include "ImageCacheManager.h"
+#include <QAtomicInt>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+
+namespace xiaozhi {
+namespace storage {
+
+namespace {
+
+/**
+ * @brief 单次缩略图请求（在线程池中执行）
+ *
+ * 引擎在收到finished后才删除响应对象（取消时同样），因此run()始终发出finished
+ */
+class ThumbnailImageResponse : public QQuickImageResponse, public QRunnable {
+public:
+    ThumbnailImageResponse(ThumbnailImageProvider* provider, const QString& id, const QSize& requestedSize)
+        : m_provider(provider)
+        , m_id(id)
+        , m_requestedSize(requestedSize)
+    {
+        setAutoDelete(false);
+    }
+
+    QQuickTextureFactory* textureFactory() const override {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override {
+        return m_error;
+    }
+
+    void cancel() override {
+        m_cancelled.storeRelaxed(1);
+    }
+
+    void run() override {
+        if (!m_cancelled.loadRelaxed()) {
+            m_image = m_provider->loadThumbnail(m_id, m_requestedSize);
+            if (m_image.isNull()) {
+                m_error = QString("无法加载缩略图: %1").arg(m_id);
+            }
+        }
+        emit finished();
+    }
+
+private:
+    ThumbnailImageProvider* m_provider;
+    QString m_id;
+    QSize m_requestedSize;
+    QImage m_image;
+    QString m_error;
+    QAtomicInt m_cancelled;
+};
+
+} // namespace
+
+ThumbnailImageProvider::ThumbnailImageProvider(ImageCacheManager* cacheManager, qint64 maxCacheBytes)
+    : m_cacheManager(cacheManager)
+{
+    // 缩略图很小，两个线程足够跟上滚动，不与预处理和音频争抢CPU
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 4, 1, 2));
+    m_pool.setObjectName("ThumbnailImageProvider");
+    m_cache.setMaxCost(static_cast<qsizetype>(std::max<qint64>(maxCacheBytes / 1024, 1)));
+}
+
+ThumbnailImageProvider::~ThumbnailImageProvider() {
+    // 已排队的请求也要执行完并发出finished，引擎才能释放响应对象
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse* ThumbnailImageProvider::requestImageResponse(const QString& id, const QSize& requestedSize) {
+    auto* response = new ThumbnailImageResponse(this, id, requestedSize);
+    m_pool.start(response);
+    return response;
+}
+
+QImage ThumbnailImageProvider::loadThumbnail(const QString& id, const QSize& requestedSize) {
+    QImage image;
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if (const QImage* cached = m_cache.object(id)) {
+            image = *cached;
+        }
+    }
+
+    if (image.isNull()) {
+        const QString thumbPath = m_cacheManager ? m_cacheManager->ensureThumbnail(id) : QString();
+        if (thumbPath.isEmpty()) {
+            return QImage();
+        }
+
+        QImageReader reader(thumbPath);
+        image = reader.read();
+        if (image.isNull()) {
+            return QImage();
+        }
+
+        QMutexLocker locker(&m_cacheMutex);
+        m_cache.insert(id, new QImage(image), std::max<qsizetype>(image.sizeInBytes() / 1024, 1));
+    }
+
+    // 缓存保存完整缩略图，按QML的sourceSize再缩小
+    if (requestedSize.isValid()
+        && (image.width() > requestedSize.width() || image.height() > requestedSize.height())) {
+        return image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image;
+}
+
+} // namespace storage
+} // namespace xiaozhi
@@ -0,0 +1,60 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T23:40:00Z
+File: ThumbnailImageProvider.h
+Desc: 聊天记录缩略图提供器（异步加载 + 内存LRU）
+*/
+
+#ifndef THUMBNAIL_IMAGE_PROVIDER_H
+#define THUMBNAIL_IMAGE_PROVIDER_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QQuickAsyncImageProvider>
+#include <QString>
+#include <QThreadPool>
+
+namespace xiaozhi {
+namespace storage {
+
+class ImageCacheManager;
+
+/**
+ * @brief 缩略图提供器（QML中使用 image://thumbnail/deviceId/image_timestamp.ext）
+ *
+ * 缩略图的读取、缺失时的补生成都在独立线程池中完成，不占用渲染线程；
+ * 解码后的缩略图保存在按字节计费的LRU中，来回滚动聊天记录时不重复解码。
+ * 由QML引擎持有，需在ImageCacheManager之前销毁
+ */
+class ThumbnailImageProvider : public QQuickAsyncImageProvider {
+public:
+    /**
+     * @param cacheManager 图片缓存管理器（生命周期长于本对象）
+     * @param maxCacheBytes 内存LRU上限（字节）
+     */
+    ThumbnailImageProvider(ImageCacheManager* cacheManager, qint64 maxCacheBytes);
+    ~ThumbnailImageProvider() override;
+
+    QQuickImageResponse* requestImageResponse(const QString& id, const QSize& requestedSize) override;
+
+    /**
+     * @brief 同步加载缩略图（在线程池中调用），失败返回空图
+     */
+    QImage loadThumbnail(const QString& id, const QSize& requestedSize);
+
+private:
+    ImageCacheManager* m_cacheManager;
+    QThreadPool m_pool;
+
+    QMutex m_cacheMutex;
+    QCache<QString, QImage> m_cache;  // 成本单位：KB
+};
+
+} // namespace storage
+} // namespace xiaozhi
+
+#endif // THUMBNAIL_IMAGE_PROVIDER_H
@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:30:00Z
+Updated: 2026-10-16T23:40:00Z
 File: Config.cpp
 Desc: 配置管理实现
 */
@@ -182,6 +182,96 @@ QString Config::getAudioOutputDeviceName() const {
     return m_settings->value("Audio/outputDeviceName", "").toString();
 }
 
+bool Config::isOpusInbandFecEnabled() const {
+    return m_settings->value("Audio/opusInbandFec", false).toBool();
+}
+
+void Config::setOpusInbandFecEnabled(bool enabled) {
+    m_settings->setValue("Audio/opusInbandFec", enabled);
+    m_settings->sync();
+}
+
+int Config::getOpusPacketLossPercent() const {
+    return m_settings->value("Audio/opusPacketLossPercent", 10).toInt();
+}
+
+void Config::setOpusPacketLossPercent(int percent) {
+    m_settings->setValue("Audio/opusPacketLossPercent", percent);
+    m_settings->sync();
+}
+
+bool Config::isLatencyTraceEnabled() const {
+    return m_settings->value("Debug/latencyTrace", false).toBool();
+}
+
+void Config::setLatencyTraceEnabled(bool enabled) {
+    m_settings->setValue("Debug/latencyTrace", enabled);
+    m_settings->sync();
+}
+
+int Config::getOtaTimeoutMs() const {
+    return m_settings->value("Network/otaTimeoutMs", 15000).toInt();
+}
+
+void Config::setOtaTimeoutMs(int timeoutMs) {
+    m_settings->setValue("Network/otaTimeoutMs", timeoutMs);
+    m_settings->sync();
+}
+
+int Config::getOtaMaxRetries() const {
+    return m_settings->value("Network/otaMaxRetries", 2).toInt();
+}
+
+void Config::setOtaMaxRetries(int retries) {
+    m_settings->setValue("Network/otaMaxRetries", retries);
+    m_settings->sync();
+}
+
+bool Config::isImagePreprocessEnabled() const {
+    return m_settings->value("Image/preprocess", true).toBool();
+}
+
+void Config::setImagePreprocessEnabled(bool enabled) {
+    m_settings->setValue("Image/preprocess", enabled);
+    m_settings->sync();
+}
+
+int Config::getImageMaxDimension() const {
+    return m_settings->value("Image/maxDimension", 1600).toInt();
+}
+
+void Config::setImageMaxDimension(int pixels) {
+    m_settings->setValue("Image/maxDimension", pixels);
+    m_settings->sync();
+}
+
+int Config::getImageQuality() const {
+    return qBound(1, m_settings->value("Image/quality", 82).toInt(), 100);
+}
+
+void Config::setImageQuality(int quality) {
+    m_settings->setValue("Image/quality", qBound(1, quality, 100));
+    m_settings->sync();
+}
+
+QString Config::getImageFormat() const {
+    return m_settings->value("Image/format", "jpg").toString();
+}
+
+void Config::setImageFormat(const QString& format) {
+    m_settings->setValue("Image/format", format);
+    m_settings->sync();
+}
+
+int Config::getThumbnailCacheMB() const {
+    return qBound(4, m_settings->value("Image/thumbnailCacheMB", 32).toInt(), 512);
+}
+
+void Config::setThumbnailCacheMB(int megabytes) {
+    m_settings->setValue("Image/thumbnailCacheMB", qBound(4, megabytes, 512));
+    m_settings->sync();
+}
+
 } // namespace utils
 } // namespace xiaozhi
 
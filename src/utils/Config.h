@@ -3,7 +3,7 @@ Project: 小智跨平台客户端 (jtxiaozhi-client)
 Version: v0.1.0
 Author: jtserver团队
 Email: jwhna1@gmail.com
-Updated: 2025-10-11T15:30:00Z
+Updated: 2026-10-17T11:30:00Z
 File: Config.h
 Desc: 配置管理（MAC地址生成、设备配置持久化）
 */
@@ -130,6 +130,66 @@ public:
     QString getAudioInputDeviceName() const;
     QString getAudioOutputDeviceName() const;
 
+    /**
+     * @brief 获取/设置上行Opus带内FEC（弱网下服务器可用冗余数据恢复丢包）
+     */
+    bool isOpusInbandFecEnabled() const;
+    void setOpusInbandFecEnabled(bool enabled);
+
+    /**
+     * @brief 获取/设置上行Opus丢包率提示（百分比，FEC启用时生效）
+     */
+    int getOpusPacketLossPercent() const;
+    void setOpusPacketLossPercent(int percent);
+
+    /**
+     * @brief 获取/设置端到端延迟追踪（逐帧打点，会话结束时导出Chrome trace到应用数据目录下的latency-traces）
+     */
+    bool isLatencyTraceEnabled() const;
+    void setLatencyTraceEnabled(bool enabled);
+
+    /**
+     * @brief 获取/设置OTA请求单次超时（毫秒）
+     */
+    int getOtaTimeoutMs() const;
+    void setOtaTimeoutMs(int timeoutMs);
+
+    /**
+     * @brief 获取/设置OTA请求失败重试次数
+     */
+    int getOtaMaxRetries() const;
+    void setOtaMaxRetries(int retries);
+
+    /**
+     * @brief 是否在上传前预处理图片（方向校正、缩放、重新压缩）
+     */
+    bool isImagePreprocessEnabled() const;
+    void setImagePreprocessEnabled(bool enabled);
+
+    /**
+     * @brief 获取/设置上传图片最长边上限（像素）
+     */
+    int getImageMaxDimension() const;
+    void setImageMaxDimension(int pixels);
+
+    /**
+     * @brief 获取/设置上传图片压缩质量（0-100）
+     */
+    int getImageQuality() const;
+    void setImageQuality(int quality);
+
+    /**
+     * @brief 获取/设置上传图片格式（jpg/webp）
+     */
+    QString getImageFormat() const;
+    void setImageFormat(const QString& format);
+
+    /**
+     * @brief 获取/设置聊天记录缩略图内存缓存上限（MB）
+     */
+    int getThumbnailCacheMB() const;
+    void setThumbnailCacheMB(int megabytes);
+
     /**
      * @brief 删除拷贝构造和赋值
      */
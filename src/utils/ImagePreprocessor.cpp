@@ -0,0 +1,216 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T23:40:00Z
+File: ImagePreprocessor.cpp
+Desc: 图片上传前预处理实现
+*/
+
+#include "ImagePreprocessor.h"
+#include "Config.h"
+#include "Logger.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QPainter>
+#include <QPointer>
+#include <QThread>
+#include <algorithm>
+
+namespace xiaozhi {
+namespace utils {
+
+namespace {
+
+/**
+ * @brief 按质量编码，失败返回空
+ */
+QByteArray encodeImage(const QImage& image, const QByteArray& format, int quality) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, format);
+    writer.setQuality(quality);
+    if (!writer.write(image)) {
+        return QByteArray();
+    }
+    return data;
+}
+
+/**
+ * @brief JPEG不支持透明：透明图铺白底
+ */
+QImage flattenAlpha(const QImage& image) {
+    if (!image.hasAlphaChannel()) {
+        return image;
+    }
+    QImage flat(image.size(), QImage::Format_RGB32);
+    flat.fill(Qt::white);
+    QPainter painter(&flat);
+    painter.drawImage(0, 0, image);
+    painter.end();
+    return flat;
+}
+
+} // namespace
+
+ImagePreprocessor& ImagePreprocessor::instance() {
+    static ImagePreprocessor instance;
+    return instance;
+}
+
+ImagePreprocessor::ImagePreprocessor() {
+    // 解码大图是CPU密集型，最多占一半核心，留给音频与GUI
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 2, 1, 4));
+    m_pool.setObjectName("ImagePreprocessor");
+}
+
+ImagePreprocessor::~ImagePreprocessor() {
+    m_pool.waitForDone();
+}
+
+ImagePreprocessOptions ImagePreprocessor::optionsFromConfig() {
+    const Config& config = Config::instance();
+    ImagePreprocessOptions options;
+    options.enabled = config.isImagePreprocessEnabled();
+    options.maxDimension = config.getImageMaxDimension();
+    options.quality = config.getImageQuality();
+    options.format = config.getImageFormat();
+    return options;
+}
+
+void ImagePreprocessor::process(const QString& imagePath, const ImagePreprocessOptions& options,
+                                QObject* context, Callback callback) {
+    QPointer<QObject> guard(context);
+    m_pool.start([imagePath, options, guard, callback = std::move(callback)]() {
+        PreparedImage image = prepare(imagePath, options);
+        // 回到主线程再检查上下文是否存活
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, callback, image]() {
+            if (guard) {
+                callback(image);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+PreparedImage ImagePreprocessor::prepare(const QString& imagePath, const ImagePreprocessOptions& options) {
+    PreparedImage result;
+    result.sourcePath = imagePath;
+
+    const QFileInfo info(imagePath);
+    result.originalBytes = info.size();
+    result.format = info.suffix().toLower();
+    if (result.format.isEmpty()) {
+        result.format = "jpg";  // 默认格式
+    }
+
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);  // 按EXIF方向校正
+    const QSize sourceSize = reader.size();
+    if (!sourceSize.isValid()) {
+        if (!info.exists()) {
+            result.error = QString("无法读取图片: %1").arg(imagePath);
+            return result;
+        }
+        // 无法识别的格式：原样上传，不生成缩略图
+        Logger::instance().warn(QString("无法识别图片格式，按原图上传: %1").arg(imagePath));
+        return result;
+    }
+
+    // 旋转90°不改变最长边，按原始方向计算缩放目标即可
+    const int maxDimension = options.enabled && options.maxDimension > 0
+        ? options.maxDimension : std::max(sourceSize.width(), sourceSize.height());
+    const bool needsResize = std::max(sourceSize.width(), sourceSize.height()) > maxDimension;
+    const bool needsRotate = reader.transformation() != QImageIOHandler::TransformationNone;
+    const QByteArray sourceFormat = reader.format().toLower();
+
+    QByteArray targetFormat = options.format.toLower() == "webp" ? QByteArray("webp") : QByteArray("jpeg");
+    if (targetFormat == "webp" && !QImageWriter::supportedImageFormats().contains("webp")) {
+        targetFormat = "jpeg";
+    }
+
+    // 尺寸、方向都无需处理且已是有损压缩格式：原图直传
+    const bool keepOriginal = !options.enabled
+        || (!needsResize && !needsRotate && (sourceFormat == "jpeg" || sourceFormat == targetFormat));
+
+    if (needsResize && !keepOriginal) {
+        // JPEG在解码时直接按比例缩小（DCT域），不解出整幅原图
+        reader.setScaledSize(sourceSize.scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+    } else if (keepOriginal && options.thumbnailDimension > 0) {
+        // 原图直传时只为缩略图解码
+        const int dim = std::max(sourceSize.width(), sourceSize.height());
+        if (dim > options.thumbnailDimension * 2) {
+            reader.setScaledSize(sourceSize.scaled(options.thumbnailDimension * 2, options.thumbnailDimension * 2,
+                                                   Qt::KeepAspectRatio));
+        }
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        Logger::instance().warn(QString("图片解码失败（%1），按原图上传: %2").arg(reader.errorString(), imagePath));
+        return result;
+    }
+
+    if (!keepOriginal) {
+        const QImage output = targetFormat == "jpeg" ? flattenAlpha(image) : image;
+        QByteArray encoded = encodeImage(output, targetFormat, options.quality);
+        if (encoded.isEmpty()) {
+            Logger::instance().warn(QString("图片重新压缩失败，按原图上传: %1").arg(imagePath));
+        } else if (needsResize || needsRotate || encoded.size() < result.originalBytes) {
+            result.data = std::move(encoded);
+            result.format = targetFormat == "jpeg" ? QString("jpg") : QString("webp");
+        }
+        // 否则重新压缩反而更大（如已高度压缩的PNG截图）：原图直传
+    }
+
+    if (!result.data.isEmpty()) {
+        result.size = image.size();
+    } else {
+        result.size = sourceSize;
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+            result.size.transpose();
+        }
+    }
+
+    if (options.thumbnailDimension > 0) {
+        const QImage thumb = image.scaled(options.thumbnailDimension, options.thumbnailDimension,
+                                          Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        result.thumbnail = encodeImage(flattenAlpha(thumb), "jpeg", 75);
+    }
+
+    Logger::instance().info(QString("图片预处理: %1x%2, %3 -> %4 bytes")
+        .arg(result.size.width()).arg(result.size.height())
+        .arg(result.originalBytes).arg(result.uploadBytes()));
+    return result;
+}
+
+QByteArray ImagePreprocessor::makeThumbnail(const QString& imagePath, int dimension) {
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+    const QSize sourceSize = reader.size();
+    if (!sourceSize.isValid() || dimension <= 0) {
+        return QByteArray();
+    }
+
+    // 先缩放解码到2倍目标尺寸，再平滑缩小，兼顾速度与质量
+    if (std::max(sourceSize.width(), sourceSize.height()) > dimension * 2) {
+        reader.setScaledSize(sourceSize.scaled(dimension * 2, dimension * 2, Qt::KeepAspectRatio));
+    }
+
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        return QByteArray();
+    }
+    const QImage thumb = std::max(image.width(), image.height()) > dimension
+        ? image.scaled(dimension, dimension, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+        : image;
+    return encodeImage(flattenAlpha(thumb), "jpeg", 75);
+}
+
+} // namespace utils
+} // namespace xiaozhi
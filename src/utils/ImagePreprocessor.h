@@ -0,0 +1,105 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T23:40:00Z
+File: ImagePreprocessor.h
+Desc: 图片上传前预处理（EXIF方向校正、限制最长边、重新压缩、生成缩略图）
+*/
+
+#ifndef IMAGE_PREPROCESSOR_H
+#define IMAGE_PREPROCESSOR_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+
+namespace xiaozhi {
+namespace utils {
+
+/**
+ * @brief 预处理参数（在GUI线程从Config读取后传入）
+ */
+struct ImagePreprocessOptions {
+    bool enabled = true;            // 关闭时上传原图，只生成缩略图
+    int maxDimension = 1600;        // 最长边上限（像素）
+    int quality = 82;               // 重新压缩质量（0-100）
+    QString format = "jpg";         // 输出格式：jpg/webp（不支持webp时回退jpg）
+    int thumbnailDimension = 320;   // 缩略图最长边（像素）
+};
+
+/**
+ * @brief 预处理结果
+ */
+struct PreparedImage {
+    QString sourcePath;             // 原图路径
+    QByteArray data;                // 处理后的图片数据（为空表示原图可直接使用）
+    QString format;                 // 上传数据的扩展名（jpg/webp/png...）
+    QByteArray thumbnail;           // JPEG缩略图（解码失败时为空）
+    QSize size;                     // 上传图片尺寸（已校正方向）
+    qint64 originalBytes = 0;       // 原图字节数
+    QString error;                  // 非空表示失败
+
+    bool isValid() const { return error.isEmpty(); }
+
+    /**
+     * @brief 上传字节数
+     */
+    qint64 uploadBytes() const { return data.isEmpty() ? originalBytes : data.size(); }
+};
+
+/**
+ * @brief 图片预处理器（线程安全）
+ *
+ * 解码、缩放、编码都在独立的小线程池中进行，不占用GUI线程和网络线程。
+ * 读取时按EXIF方向自动旋转，JPEG按目标尺寸缩放解码（不解出整幅原图）；
+ * 原图已满足尺寸与格式要求且无需旋转时不重新压缩，避免二次有损
+ */
+class ImagePreprocessor {
+public:
+    using Callback = std::function<void(const PreparedImage& image)>;
+
+    static ImagePreprocessor& instance();
+
+    /**
+     * @brief 从Config读取当前预处理参数（GUI线程调用）
+     */
+    static ImagePreprocessOptions optionsFromConfig();
+
+    /**
+     * @brief 异步预处理
+     * @param context 回调上下文（GUI线程对象，已销毁时不回调）
+     * @param callback 在GUI线程中调用
+     */
+    void process(const QString& imagePath, const ImagePreprocessOptions& options,
+                 QObject* context, Callback callback);
+
+    /**
+     * @brief 同步预处理（在工作线程中调用）
+     */
+    static PreparedImage prepare(const QString& imagePath, const ImagePreprocessOptions& options);
+
+    /**
+     * @brief 为已有图片生成JPEG缩略图（在工作线程中调用，按目标尺寸缩放解码）
+     * @return 缩略图数据，解码失败返回空
+     */
+    static QByteArray makeThumbnail(const QString& imagePath, int dimension);
+
+    ImagePreprocessor(const ImagePreprocessor&) = delete;
+    ImagePreprocessor& operator=(const ImagePreprocessor&) = delete;
+
+private:
+    ImagePreprocessor();
+    ~ImagePreprocessor();
+
+    QThreadPool m_pool;
+};
+
+} // namespace utils
+} // namespace xiaozhi
+
+#endif // IMAGE_PREPROCESSOR_H
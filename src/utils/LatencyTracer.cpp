@@ -0,0 +1,402 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T16:20:00Z
+File: LatencyTracer.cpp
+Desc: 端到端音频延迟追踪实现
+*/
+
+#include "LatencyTracer.h"
+#include "Logger.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+
+namespace xiaozhi {
+namespace utils {
+
+namespace {
+
+// Chrome trace中的线程泳道
+enum Lane {
+    LaneUplink = 1,
+    LaneNetworkRx = 2,
+    LanePlayout = 3,
+    LaneConversation = 4
+};
+
+} // namespace
+
+LatencyTracer::LatencyTracer(const QString& sessionId)
+    : m_sessionId(sessionId)
+    , m_epochNs(nowNs())
+    , m_listenStopNs(0)
+    , m_sttNs(0)
+    , m_awaitingTts(false)
+    , m_awaitingFirstAudio(false)
+    , m_eventCount(0)
+{
+}
+
+void LatencyTracer::setEnabled(bool enabled) {
+    if (enabled) {
+        QMutexLocker locker(&m_eventMutex);
+        if (m_events.empty()) {
+            m_events.resize(MAX_EVENTS);
+        }
+    }
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 LatencyTracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+quint32 LatencyTracer::beginUplinkFrame(qint64 captureNs) {
+    if (!isEnabled()) {
+        return 0;
+    }
+
+    // 帧号从1开始，0保留为"未追踪"
+    quint32 id = m_nextUplink.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (id == 0) {
+        id = m_nextUplink.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    m_currentUplink.store(id, std::memory_order_relaxed);
+
+    qint64 now = nowNs();
+    mark(m_uplink.data(), id, TracePoint::Capture, captureNs > 0 ? captureNs : now,
+         TracePoint::Capture, TracePoint::Sent);
+    mark(m_uplink.data(), id, TracePoint::FrameComplete, now,
+         TracePoint::Capture, TracePoint::Sent);
+    return id;
+}
+
+void LatencyTracer::markUplink(quint32 frameId, TracePoint point, qint64 ns) {
+    if (frameId == 0 || !isEnabled()) {
+        return;
+    }
+    mark(m_uplink.data(), frameId, point, ns > 0 ? ns : nowNs(),
+         TracePoint::Capture, TracePoint::Sent);
+}
+
+void LatencyTracer::markDownlink(quint32 sequence, TracePoint point, qint64 ns) {
+    if (!isEnabled()) {
+        return;
+    }
+    qint64 at = ns > 0 ? ns : nowNs();
+    mark(m_downlink.data(), sequence, point, at, TracePoint::Received, TracePoint::SinkWritten);
+
+    // 本轮首个写入播放设备的音频：即用户感知到的"开始回答"时刻
+    if (point == TracePoint::SinkWritten && m_awaitingFirstAudio) {
+        m_awaitingFirstAudio = false;
+        if (m_sttNs > 0) {
+            record(SttToFirstAudio, m_sttNs, at, sequence);
+        }
+        if (m_listenStopNs > 0) {
+            record(StopToFirstAudio, m_listenStopNs, at, sequence);
+        }
+    }
+}
+
+void LatencyTracer::markTurn(TurnPoint point) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    qint64 now = nowNs();
+    switch (point) {
+    case TurnPoint::ListenStop:
+        m_listenStopNs = now;
+        m_sttNs = 0;
+        m_awaitingTts = false;
+        m_awaitingFirstAudio = false;
+        break;
+    case TurnPoint::Stt:
+        if (m_listenStopNs > 0) {
+            record(StopToStt, m_listenStopNs, now, 0);
+        }
+        m_sttNs = now;
+        m_awaitingTts = true;
+        m_awaitingFirstAudio = true;
+        break;
+    case TurnPoint::TtsStart:
+        // 一轮回复可能有多个sentence_start，只统计第一个
+        if (m_awaitingTts && m_sttNs > 0) {
+            record(SttToTtsStart, m_sttNs, now, 0);
+        }
+        m_awaitingTts = false;
+        break;
+    }
+}
+
+void LatencyTracer::mark(FrameSlot* ring, quint32 id, TracePoint point, qint64 ns,
+                         TracePoint first, TracePoint last) {
+    FrameSlot& slot = ring[id % RING_SLOTS];
+    int index = static_cast<int>(point);
+    int firstIndex = static_cast<int>(first);
+
+    if (point == first) {
+        // 链首：占用槽位（覆盖已绕回的旧帧）
+        slot.valid.store(false, std::memory_order_relaxed);
+        for (auto& value : slot.ns) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        slot.id.store(id, std::memory_order_relaxed);
+        slot.ns[index].store(ns, std::memory_order_relaxed);
+        slot.valid.store(true, std::memory_order_release);
+        return;
+    }
+
+    if (!slot.valid.load(std::memory_order_acquire) ||
+        slot.id.load(std::memory_order_relaxed) != id) {
+        return;  // 链首未打点或槽位已被新帧覆盖
+    }
+    slot.ns[index].store(ns, std::memory_order_relaxed);
+
+    // 阶段耗时从链上最近一个已打点位置算起（WebSocket下行没有解密点）
+    for (int prev = index - 1; prev >= firstIndex; --prev) {
+        qint64 prevNs = slot.ns[prev].load(std::memory_order_relaxed);
+        if (prevNs > 0) {
+            record(stageEndingAt(point), prevNs, ns, id);
+            break;
+        }
+    }
+
+    if (point == last) {
+        qint64 startNs = slot.ns[firstIndex].load(std::memory_order_relaxed);
+        if (startNs > 0) {
+            record(first == TracePoint::Capture ? UplinkTotal : DownlinkTotal, startNs, ns, id);
+        }
+        slot.valid.store(false, std::memory_order_relaxed);
+    }
+}
+
+void LatencyTracer::record(Stage stage, qint64 startNs, qint64 endNs, quint32 id) {
+    if (endNs < startNs) {
+        return;
+    }
+
+    quint64 us = static_cast<quint64>((endNs - startNs) / 1000);
+    Histogram& histogram = m_histograms[stage];
+    histogram.buckets[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.sumUs.fetch_add(us, std::memory_order_relaxed);
+    quint64 max = histogram.maxUs.load(std::memory_order_relaxed);
+    while (us > max && !histogram.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+
+    // 事件环：拿不到锁（正在导出或另一线程写入）就丢弃，打点线程不等待
+    if (!m_eventMutex.tryLock()) {
+        return;
+    }
+    if (!m_events.empty()) {
+        TraceEvent& event = m_events[m_eventCount % m_events.size()];
+        event.startNs = startNs;
+        event.endNs = endNs;
+        event.id = id;
+        event.stage = static_cast<quint8>(stage);
+        ++m_eventCount;
+    }
+    m_eventMutex.unlock();
+}
+
+LatencyTracer::Stage LatencyTracer::stageEndingAt(TracePoint point) {
+    switch (point) {
+    case TracePoint::FrameComplete: return Framing;
+    case TracePoint::Encoded:       return Encode;
+    case TracePoint::Encrypted:     return Encrypt;
+    case TracePoint::Sent:          return Send;
+    case TracePoint::Decrypted:     return Decrypt;
+    case TracePoint::Enqueued:      return Deliver;
+    case TracePoint::Decoded:       return JitterDecode;
+    case TracePoint::SinkWritten:   return SinkWrite;
+    default:                        return Framing;
+    }
+}
+
+int LatencyTracer::bucketFor(quint64 us) {
+    // 0~7us各占一档；之后每个2的幂区间分8档（相对误差≤12.5%）
+    if (us < 8) {
+        return static_cast<int>(us);
+    }
+    int exponent = 3;
+    while ((us >> (exponent + 1)) != 0) {
+        ++exponent;
+    }
+    int sub = static_cast<int>((us >> (exponent - 3)) & 7);
+    int bucket = 8 + (exponent - 3) * 8 + sub;
+    return std::min(bucket, HISTOGRAM_BUCKETS - 1);
+}
+
+quint64 LatencyTracer::bucketUpperUs(int bucket) {
+    if (bucket < 8) {
+        return static_cast<quint64>(bucket);
+    }
+    int shift = (bucket - 8) / 8;
+    quint64 sub = static_cast<quint64>((bucket - 8) % 8);
+    return ((8 + sub + 1) << shift) - 1;
+}
+
+quint64 LatencyTracer::percentileUs(const Histogram& histogram, double p) {
+    quint64 count = histogram.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0;
+    }
+
+    quint64 rank = static_cast<quint64>(p * static_cast<double>(count) + 0.5);
+    rank = std::max<quint64>(1, std::min(rank, count));
+    quint64 seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperUs(i), histogram.maxUs.load(std::memory_order_relaxed));
+        }
+    }
+    return histogram.maxUs.load(std::memory_order_relaxed);
+}
+
+const char* LatencyTracer::stageName(int stage) {
+    switch (stage) {
+    case Framing:          return "framing";
+    case Encode:           return "encode";
+    case Encrypt:          return "encrypt";
+    case Send:             return "send";
+    case UplinkTotal:      return "uplink_total";
+    case Decrypt:          return "decrypt";
+    case Deliver:          return "deliver";
+    case JitterDecode:     return "jitter_decode";
+    case SinkWrite:        return "sink_write";
+    case DownlinkTotal:    return "downlink_total";
+    case StopToStt:        return "stop_to_stt";
+    case SttToTtsStart:    return "stt_to_tts_start";
+    case SttToFirstAudio:  return "stt_to_first_audio";
+    case StopToFirstAudio: return "stop_to_first_audio";
+    default:               return "unknown";
+    }
+}
+
+int LatencyTracer::stageLane(int stage) {
+    if (stage <= UplinkTotal) {
+        return LaneUplink;
+    }
+    if (stage <= Deliver) {
+        return LaneNetworkRx;
+    }
+    if (stage <= DownlinkTotal) {
+        return LanePlayout;
+    }
+    return LaneConversation;
+}
+
+QVariantMap LatencyTracer::stats() const {
+    QVariantMap result;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const Histogram& histogram = m_histograms[stage];
+        quint64 count = histogram.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+
+        QVariantMap entry;
+        entry["count"] = count;
+        entry["meanUs"] = static_cast<double>(histogram.sumUs.load(std::memory_order_relaxed)) / count;
+        entry["p50Us"] = percentileUs(histogram, 0.50);
+        entry["p90Us"] = percentileUs(histogram, 0.90);
+        entry["p99Us"] = percentileUs(histogram, 0.99);
+        entry["maxUs"] = histogram.maxUs.load(std::memory_order_relaxed);
+        result[stageName(stage)] = entry;
+    }
+    return result;
+}
+
+bool LatencyTracer::exportChromeTrace(const QString& path) const {
+    QJsonArray traceEvents;
+
+    // 进程/线程命名元数据
+    QJsonObject processName;
+    processName["ph"] = "M";
+    processName["name"] = "process_name";
+    processName["pid"] = 1;
+    processName["args"] = QJsonObject{{"name", QString("xiaozhi %1").arg(m_sessionId)}};
+    traceEvents.append(processName);
+
+    const QList<QPair<int, QString>> lanes = {
+        {LaneUplink, "audio-uplink"},
+        {LaneNetworkRx, "network-rx"},
+        {LanePlayout, "playout"},
+        {LaneConversation, "conversation"}
+    };
+    for (const auto& lane : lanes) {
+        QJsonObject threadName;
+        threadName["ph"] = "M";
+        threadName["name"] = "thread_name";
+        threadName["pid"] = 1;
+        threadName["tid"] = lane.first;
+        threadName["args"] = QJsonObject{{"name", lane.second}};
+        traceEvents.append(threadName);
+    }
+
+    {
+        QMutexLocker locker(&m_eventMutex);
+        quint64 size = m_events.size();
+        quint64 available = std::min<quint64>(m_eventCount, size);
+        quint64 begin = m_eventCount - available;
+        for (quint64 i = begin; i < m_eventCount; ++i) {
+            const TraceEvent& event = m_events[i % size];
+            QJsonObject object;
+            object["ph"] = "X";
+            object["name"] = stageName(event.stage);
+            object["cat"] = "latency";
+            object["pid"] = 1;
+            object["tid"] = stageLane(event.stage);
+            object["ts"] = static_cast<double>(event.startNs - m_epochNs) / 1000.0;
+            object["dur"] = static_cast<double>(event.endNs - event.startNs) / 1000.0;
+            object["args"] = QJsonObject{{"id", static_cast<qint64>(event.id)}};
+            traceEvents.append(object);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+    root["otherData"] = QJsonObject{
+        {"session", m_sessionId},
+        {"stats", QJsonObject::fromVariantMap(stats())}
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Logger::instance().error(QString("导出延迟追踪失败: %1").arg(file.errorString()));
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+
+    Logger::instance().info(QString("延迟追踪已导出: %1 (%2 个事件)")
+                                .arg(path).arg(traceEvents.size()));
+    return true;
+}
+
+void LatencyTracer::reset() {
+    for (auto& histogram : m_histograms) {
+        for (auto& bucket : histogram.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.sumUs.store(0, std::memory_order_relaxed);
+        histogram.maxUs.store(0, std::memory_order_relaxed);
+    }
+
+    QMutexLocker locker(&m_eventMutex);
+    m_eventCount = 0;
+}
+
+} // namespace utils
+} // namespace xiaozhi
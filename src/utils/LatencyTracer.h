@@ -0,0 +1,187 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:20:00Z
+File: LatencyTracer.h
+Desc: 端到端音频延迟追踪（上行采集→发送、下行接收→写入播放设备的逐帧打点、直方图与Chrome trace导出）
+*/
+
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QMutex>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace xiaozhi {
+namespace utils {
+
+/**
+ * @brief 逐帧打点位置
+ *
+ * 上行链：Capture → FrameComplete → Encoded → Encrypted → Sent（以上行帧号关联）
+ * 下行链：Received → Decrypted → Enqueued → Decoded → SinkWritten（以包序列号关联）
+ */
+enum class TracePoint {
+    Capture,        // 帧首个采样块从采集设备读出
+    FrameComplete,  // 凑满一帧
+    Encoded,        // Opus编码完成
+    Encrypted,      // AES-CTR封包完成
+    Sent,           // 交给内核（writeDatagram/send）
+    Received,       // 从内核取回数据报
+    Decrypted,      // 解密完成
+    Enqueued,       // 进入抖动缓冲（已跨线程投递到GUI线程）
+    Decoded,        // 出队并解码完成
+    SinkWritten,    // 写入播放设备
+    Count
+};
+
+/**
+ * @brief 对话级打点（均在GUI线程调用）
+ */
+enum class TurnPoint {
+    ListenStop,     // 用户停止说话（发送listen stop）
+    Stt,            // 收到stt消息
+    TtsStart        // 收到tts start/sentence_start消息
+};
+
+/**
+ * @brief 端到端延迟追踪器（每个会话一份）
+ *
+ * 打点在音频线程、UDP线程和GUI线程中进行：
+ * - 未启用时每个打点只是一次原子读
+ * - 各阶段耗时计入无锁对数直方图（原子计数）
+ * - 阶段区间同时写入有界事件环用于导出Chrome trace；事件环加锁失败时丢弃该事件，
+ *   打点线程永不阻塞
+ */
+class LatencyTracer {
+public:
+    explicit LatencyTracer(const QString& sessionId);
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 单调时钟（纳秒）
+     */
+    static qint64 nowNs();
+
+    /**
+     * @brief 开始一个上行帧（音频线程，凑满一帧时调用）
+     * @param captureNs 帧首个采样块读出的时刻
+     * @return 上行帧号（用于后续打点）；未启用时返回0
+     */
+    quint32 beginUplinkFrame(qint64 captureNs);
+
+    /**
+     * @brief 当前线程最近开始的上行帧号（编码后同步调用的发送路径用它关联）
+     */
+    quint32 currentUplinkFrame() const { return m_currentUplink.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 上行打点
+     */
+    void markUplink(quint32 frameId, TracePoint point, qint64 ns = 0);
+
+    /**
+     * @brief 下行打点（Received为链首）
+     * @param sequence 包序列号
+     */
+    void markDownlink(quint32 sequence, TracePoint point, qint64 ns = 0);
+
+    /**
+     * @brief 对话级打点
+     */
+    void markTurn(TurnPoint point);
+
+    /**
+     * @brief 各阶段统计（微秒）：{阶段: {count, meanUs, p50Us, p90Us, p99Us, maxUs}}
+     */
+    QVariantMap stats() const;
+
+    /**
+     * @brief 导出Chrome trace JSON（chrome://tracing / Perfetto可直接打开）
+     */
+    bool exportChromeTrace(const QString& path) const;
+
+    /**
+     * @brief 清空直方图与事件
+     */
+    void reset();
+
+private:
+    enum Stage {
+        Framing, Encode, Encrypt, Send, UplinkTotal,
+        Decrypt, Deliver, JitterDecode, SinkWrite, DownlinkTotal,
+        StopToStt, SttToTtsStart, SttToFirstAudio, StopToFirstAudio,
+        StageCount
+    };
+
+    static constexpr int RING_SLOTS = 256;          // 在途帧槽位（60ms帧约15秒）
+    static constexpr int HISTOGRAM_BUCKETS = 200;   // 对数桶：每个2的幂分8档，覆盖到约60秒
+    static constexpr int MAX_EVENTS = 32768;        // Chrome trace事件上限（环形覆盖）
+    static constexpr int POINT_COUNT = static_cast<int>(TracePoint::Count);
+
+    struct FrameSlot {
+        std::atomic<quint32> id{0};
+        std::atomic<bool> valid{false};
+        std::array<std::atomic<qint64>, POINT_COUNT> ns{};
+    };
+
+    struct Histogram {
+        std::array<std::atomic<quint64>, HISTOGRAM_BUCKETS> buckets{};
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> sumUs{0};
+        std::atomic<quint64> maxUs{0};
+    };
+
+    struct TraceEvent {
+        qint64 startNs;
+        qint64 endNs;
+        quint32 id;
+        quint8 stage;
+    };
+
+    void mark(FrameSlot* ring, quint32 id, TracePoint point, qint64 ns, TracePoint first, TracePoint last);
+    void record(Stage stage, qint64 startNs, qint64 endNs, quint32 id);
+
+    static Stage stageEndingAt(TracePoint point);
+    static int bucketFor(quint64 us);
+    static quint64 bucketUpperUs(int bucket);
+    static quint64 percentileUs(const Histogram& histogram, double p);
+    static const char* stageName(int stage);
+    static int stageLane(int stage);
+
+    QString m_sessionId;
+    qint64 m_epochNs;
+    std::atomic<bool> m_enabled{false};
+
+    std::atomic<quint32> m_nextUplink{0};
+    std::atomic<quint32> m_currentUplink{0};
+    std::array<FrameSlot, RING_SLOTS> m_uplink;
+    std::array<FrameSlot, RING_SLOTS> m_downlink;
+    std::array<Histogram, StageCount> m_histograms;
+
+    // 对话级状态（仅GUI线程访问）
+    qint64 m_listenStopNs;
+    qint64 m_sttNs;
+    bool m_awaitingTts;
+    bool m_awaitingFirstAudio;
+
+    mutable QMutex m_eventMutex;
+    std::vector<TraceEvent> m_events;   // 环形事件缓冲
+    quint64 m_eventCount;               // 累计写入数
+};
+
+} // namespace utils
+} // namespace xiaozhi
+
+#endif // LATENCY_TRACER_H
@@ -0,0 +1,267 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T18:00:00Z
+File: TransportRaceTest.cpp
+Desc: 传输层候选并发探测测试（回退耗时受错开间隔约束，而非逐个等待连接超时）
+*/
+
+// 需要Qt6 Core/Network/Test，以-Isrc链接以下源文件（含moc）构建为独立可执行文件：
+//   src/network/TransportRace.cpp
+//
+// 用法：transport_race_test [QTest参数]
+//
+// 被过滤端口（SYN被丢弃，连接既不成功也不被拒绝）借助Linux监听队列占满后的行为在本机模拟，
+// 其他平台跳过相关用例
+
+#include "network/TransportRace.h"
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QSignalSpy>
+#include <QSslSocket>
+#include <QTcpServer>
+#include <QTest>
+
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace xiaozhi::network;
+
+namespace {
+
+constexpr int STAGGER_MS = 250;
+constexpr int TIMEOUT_MS = 5000;        // 与MqttWorker的单候选连接超时相同
+constexpr int SCHEDULING_SLACK_MS = 500; // 事件循环与定时器精度余量
+
+const QString LOCALHOST = QStringLiteral("127.0.0.1");
+
+/**
+ * @brief 本机模拟的被过滤端口
+ *
+ * 监听队列长度为0且从不accept：占满队列后内核丢弃新的SYN，
+ * 对端看到的与防火墙静默丢包相同，只能等连接超时
+ */
+class FilteredPort {
+public:
+    FilteredPort() {
+#ifdef Q_OS_LINUX
+        m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (m_listener < 0
+            || ::bind(m_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::listen(m_listener, 0) != 0
+            || ::getsockname(m_listener, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return;
+        }
+
+        // 持续占位直到某个连接200ms内握不上：此后队列已满，新的SYN被丢弃
+        for (int i = 0; i < 16; ++i) {
+            const int filler = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (filler < 0) {
+                return;
+            }
+            m_fillers.push_back(filler);
+            ::fcntl(filler, F_SETFL, O_NONBLOCK);
+            ::connect(filler, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            pollfd pfd{filler, POLLOUT, 0};
+            if (::poll(&pfd, 1, 200) == 0) {
+                m_port = ntohs(addr.sin_port);
+                return;
+            }
+        }
+#endif
+    }
+
+    ~FilteredPort() {
+#ifdef Q_OS_LINUX
+        for (int filler : m_fillers) {
+            ::close(filler);
+        }
+        if (m_listener >= 0) {
+            ::close(m_listener);
+        }
+#endif
+    }
+
+    /**
+     * @brief 端口号（0表示本平台无法模拟）
+     */
+    quint16 port() const { return m_port; }
+
+private:
+    int m_listener = -1;
+    std::vector<int> m_fillers;
+    quint16 m_port = 0;
+};
+
+/**
+ * @brief 取一个当前无人监听的本机端口（连接立即被拒绝）
+ */
+quint16 closedPort() {
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost);
+    const quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+TransportCandidate candidate(quint16 port, bool useSSL) {
+    TransportCandidate c;
+    c.host = LOCALHOST;
+    c.port = port;
+    c.useSSL = useSSL;
+    return c;
+}
+
+} // namespace
+
+class TransportRaceTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 首选端口被过滤：回退到次选只需一个错开间隔，不等首选的连接超时
+     */
+    void filteredPreferredFallsBackWithinStagger() {
+        FilteredPort filtered;
+        if (filtered.port() == 0) {
+            QSKIP("本平台无法模拟被过滤端口");
+        }
+        QTcpServer open;
+        QVERIFY(open.listen(QHostAddress::LocalHost));
+
+        TransportRace race;
+        race.setStaggerMs(STAGGER_MS);
+        race.setTimeoutMs(TIMEOUT_MS);
+        QSignalSpy wonSpy(&race, &TransportRace::won);
+        QSignalSpy failedSpy(&race, &TransportRace::failed);
+
+        // 同MQTT的无缓存首连：8883(TLS)优先，1883(TCP)次之
+        QElapsedTimer clock;
+        clock.start();
+        race.start({candidate(filtered.port(), QSslSocket::supportsSsl()),
+                    candidate(open.serverPort(), false)});
+
+        QVERIFY(wonSpy.wait(TIMEOUT_MS));
+        const qint64 elapsedMs = clock.elapsed();
+        QCOMPARE(failedSpy.count(), 0);
+        QCOMPARE(wonSpy.first().at(0).toInt(), 1);
+        QVERIFY2(elapsedMs >= STAGGER_MS * 9 / 10,
+                 qPrintable(QString("次选在错开间隔之前发起: %1ms").arg(elapsedMs)));
+        QVERIFY2(elapsedMs < STAGGER_MS + SCHEDULING_SLACK_MS,
+                 qPrintable(QString("回退耗时%1ms，超过错开间隔%2ms").arg(elapsedMs).arg(STAGGER_MS)));
+    }
+
+    /**
+     * @brief 首选TLS已连通、握手进行中：明文次选可达也不抢先（防降级），首选超时后才胜出
+     */
+    void tlsHandshakeInProgressIsNotPreempted() {
+        if (!QSslSocket::supportsSsl()) {
+            QSKIP("Qt未启用TLS后端");
+        }
+        // 接受TCP连接但从不回应ClientHello
+        QTcpServer silentTls;
+        QVERIFY(silentTls.listen(QHostAddress::LocalHost));
+        QTcpServer open;
+        QVERIFY(open.listen(QHostAddress::LocalHost));
+
+        constexpr int handshakeTimeoutMs = 1000;
+        TransportRace race;
+        race.setStaggerMs(STAGGER_MS);
+        race.setTimeoutMs(handshakeTimeoutMs);
+        QSignalSpy wonSpy(&race, &TransportRace::won);
+
+        race.start({candidate(silentTls.serverPort(), true), candidate(open.serverPort(), false)});
+
+        QVERIFY(!wonSpy.wait(handshakeTimeoutMs / 2));
+        QVERIFY(wonSpy.wait(handshakeTimeoutMs + SCHEDULING_SLACK_MS));
+        QCOMPARE(wonSpy.first().at(0).toInt(), 1);
+        QVERIFY(wonSpy.first().at(1).toLongLong() >= handshakeTimeoutMs * 9 / 10);
+    }
+
+    /**
+     * @brief 全部被拒绝：失败立即发起下一个，整轮不等错开间隔和连接超时
+     */
+    void allRefusedFailsWithoutWaitingForTimeout() {
+        TransportRace race;
+        race.setStaggerMs(STAGGER_MS);
+        race.setTimeoutMs(TIMEOUT_MS);
+        QSignalSpy wonSpy(&race, &TransportRace::won);
+        QSignalSpy failedSpy(&race, &TransportRace::failed);
+
+        QElapsedTimer clock;
+        clock.start();
+        race.start({candidate(closedPort(), false), candidate(closedPort(), false)});
+
+        QVERIFY(failedSpy.wait(TIMEOUT_MS));
+        QCOMPARE(wonSpy.count(), 0);
+        QVERIFY2(clock.elapsed() < STAGGER_MS,
+                 qPrintable(QString("全部被拒绝耗时%1ms").arg(clock.elapsed())));
+    }
+
+    /**
+     * @brief 胜出后继续等待更高优先的候选出结果，再给出写入缓存的候选
+     */
+    void resolvedReportsWinnerOnceHigherCandidatesFail() {
+        FilteredPort filtered;
+        if (filtered.port() == 0) {
+            QSKIP("本平台无法模拟被过滤端口");
+        }
+        QTcpServer open;
+        QVERIFY(open.listen(QHostAddress::LocalHost));
+
+        constexpr int probeTimeoutMs = 800;
+        TransportRace race;
+        race.setStaggerMs(STAGGER_MS);
+        race.setTimeoutMs(probeTimeoutMs);
+        QSignalSpy wonSpy(&race, &TransportRace::won);
+        QSignalSpy resolvedSpy(&race, &TransportRace::resolved);
+
+        race.start({candidate(filtered.port(), false), candidate(open.serverPort(), false)});
+
+        QVERIFY(wonSpy.wait(TIMEOUT_MS));
+        QCOMPARE(resolvedSpy.count(), 0);
+        QVERIFY(race.isResolving());
+
+        QVERIFY(resolvedSpy.wait(probeTimeoutMs + SCHEDULING_SLACK_MS));
+        QCOMPARE(resolvedSpy.first().at(0).toInt(), 1);
+        QCOMPARE(race.preferredIndex(), 1);
+        QVERIFY(!race.isResolving());
+    }
+
+    /**
+     * @brief 取消后不再发出任何信号
+     */
+    void cancelSuppressesSignals() {
+        QTcpServer open;
+        QVERIFY(open.listen(QHostAddress::LocalHost));
+
+        TransportRace race;
+        QSignalSpy wonSpy(&race, &TransportRace::won);
+        QSignalSpy failedSpy(&race, &TransportRace::failed);
+
+        race.start({candidate(open.serverPort(), false)});
+        race.cancel();
+
+        QVERIFY(!wonSpy.wait(STAGGER_MS));
+        QCOMPARE(failedSpy.count(), 0);
+        QCOMPARE(race.preferredIndex(), -1);
+    }
+};
+
+QTEST_MAIN(TransportRaceTest)
+#include "TransportRaceTest.moc"
@@ -0,0 +1,499 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:50:00Z
+File: LoadGenerator.cpp
+Desc: 无头多设备压测驱动实现
+*/
+
+#include "LoadGenerator.h"
+#include "SyntheticPcmSource.h"
+#include "../../src/audio/AudioDevice.h"
+#include "../../src/audio/ConversationManager.h"
+#include "../../src/network/DeviceSession.h"
+#include "../../src/utils/Logger.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace xiaozhi {
+namespace loadgen {
+
+namespace {
+
+/**
+ * @brief 进程累计CPU时间（用户态+内核态，秒）
+ */
+double processCpuSeconds() {
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto toSec = [](const FILETIME& ft) {
+        ULARGE_INTEGER v;
+        v.LowPart = ft.dwLowDateTime;
+        v.HighPart = ft.dwHighDateTime;
+        return static_cast<double>(v.QuadPart) / 1e7;   // 100ns单位
+    };
+    return toSec(kernel) + toSec(user);
+#else
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+         + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+/**
+ * @brief 进程当前常驻内存（KB，取不到当前值时退化为峰值）
+ */
+qint64 processRssKb() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<qint64>(pmc.WorkingSetSize / 1024);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!status.atEnd()) {
+            const QByteArray line = status.readLine();
+            if (line.startsWith("VmRSS:")) {
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+            }
+        }
+    }
+    return 0;
+#else
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<qint64>(usage.ru_maxrss / 1024);     // macOS以字节为单位
+#endif
+}
+
+/**
+ * @brief 最近秩百分位
+ */
+double percentile(const QVector<double>& sorted, double p) {
+    if (sorted.isEmpty()) {
+        return 0.0;
+    }
+    const int rank = static_cast<int>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp(rank - 1, 0, static_cast<int>(sorted.size()) - 1)];
+}
+
+const char* const STAGE_ORDER[] = { "ota", "connect", "channel", "stt", "tts_start", "turn" };
+
+} // namespace
+
+LoadGenerator::LoadGenerator(const LoadConfig& config, QObject* parent)
+    : QObject(parent)
+    , m_config(config)
+    , m_launched(0)
+    , m_reported(false)
+    , m_timeouts(0)
+    , m_cpuStartSec(0.0)
+    , m_lastCpuSec(0.0)
+    , m_lastSampleMs(0)
+    , m_peakCpuPercent(0.0)
+    , m_baselineRssKb(0)
+    , m_peakRssKb(0)
+    , m_peakActive(0)
+{
+    m_rampTimer.setInterval(qMax(0, m_config.rampMs));
+    connect(&m_rampTimer, &QTimer::timeout, this, &LoadGenerator::launchNext);
+
+    m_sampleTimer.setInterval(1000);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &LoadGenerator::sampleResources);
+
+    m_deadline.setSingleShot(true);
+    connect(&m_deadline, &QTimer::timeout, this, [this]() {
+        utils::Logger::instance().info("[loadgen] 达到时长上限，结束压测");
+        report();
+    });
+}
+
+LoadGenerator::~LoadGenerator() {
+    // 先销毁会话（其对话管理器持有播放设备的裸指针）
+    m_bySession.clear();
+    for (auto& device : m_devices) {
+        delete device->session;
+        device->session = nullptr;
+    }
+    m_devices.clear();
+}
+
+void LoadGenerator::start() {
+    m_runClock.start();
+    m_cpuStartSec = processCpuSeconds();
+    m_lastCpuSec = m_cpuStartSec;
+    m_baselineRssKb = processRssKb();
+    m_peakRssKb = m_baselineRssKb;
+
+    m_devices.reserve(m_config.devices);
+    m_sampleTimer.start();
+    if (m_config.durationS > 0) {
+        m_deadline.start(m_config.durationS * 1000);
+    }
+
+    launchNext();
+    if (m_launched < m_config.devices) {
+        m_rampTimer.start();
+    }
+}
+
+void LoadGenerator::launchNext() {
+    if (m_launched >= m_config.devices) {
+        m_rampTimer.stop();
+        return;
+    }
+    createDevice(m_launched++);
+    if (m_launched >= m_config.devices) {
+        m_rampTimer.stop();
+    }
+}
+
+void LoadGenerator::createDevice(int index) {
+    auto owned = std::make_unique<Device>();
+    Device* device = owned.get();
+    device->index = index;
+    // 空输出播放设备：完整走解码与播放路径，但不占用声卡
+    device->audioDevice = std::make_unique<audio::AudioDevice>();
+    device->audioDevice->setNullSink(true);
+    m_devices.push_back(std::move(owned));
+
+    const QString mac = macForIndex(m_config.macPrefix, index);
+    const QString deviceId = QString("loadgen-%1").arg(index, 5, 10, QChar('0'));
+    device->session = new network::DeviceSession(deviceId, deviceId, mac, m_config.otaUrl,
+                                                 device->audioDevice.get(), m_config.websocket);
+    m_bySession.insert(device->session, device);
+
+    // 上行采集替换为合成数据源
+    const QByteArray loopPcm = m_config.loopPcm;
+    device->session->setPcmSourceFactory([loopPcm, index](const audio::AudioConfig& config, QObject* parent) -> QIODevice* {
+        return new SyntheticPcmSource(config, loopPcm, index, parent);
+    });
+
+    device->timer = new QTimer(this);
+    device->timer->setSingleShot(true);
+    connect(device->timer, &QTimer::timeout, this, [this, device]() { onTimer(device); });
+
+    connect(device->session, &network::DeviceSession::otaCompleted, this, [this, device]() {
+        if (device->phase != Phase::Ota) {
+            return;
+        }
+        record("ota", device->stageClock);
+        device->phase = Phase::Connecting;
+        device->stageClock.start();
+        armTimer(device, m_config.responseTimeoutMs);
+    });
+
+    connect(device->session, &network::DeviceSession::connectionStateChanged, this,
+            [this, device](const QString&, bool connected, bool) {
+        if (device->phase == Phase::Connecting && connected) {
+            record("connect", device->stageClock);
+            device->phase = Phase::OpeningChannel;
+            device->stageClock.start();
+            armTimer(device, m_config.responseTimeoutMs);
+            // WebSocket模式下对话管理器可能已在连接回调中创建且通道已打开
+            wireConversation(device);
+        } else if (!connected && device->phase != Phase::Pending && device->phase != Phase::Ota
+                   && device->phase != Phase::Connecting
+                   && device->phase != Phase::Done && device->phase != Phase::Failed) {
+            fail(device, "disconnected");
+        }
+    });
+
+    connect(device->session, &network::DeviceSession::conversationReady, this, [this, device]() {
+        wireConversation(device);
+    });
+
+    device->phase = Phase::Ota;
+    device->stageClock.start();
+    armTimer(device, m_config.responseTimeoutMs);
+    device->session->getOtaConfig();
+}
+
+void LoadGenerator::wireConversation(Device* device) {
+    audio::ConversationManager* conversation = device->session->conversationManager();
+    if (!conversation || conversation->property("loadgenWired").toBool()) {
+        if (conversation && device->phase == Phase::OpeningChannel && conversation->udpChannelOpened()) {
+            record("channel", device->stageClock);
+            beginTurn(device);
+        }
+        return;
+    }
+    conversation->setProperty("loadgenWired", true);
+    conversation->setMode(audio::ConversationMode::Manual);
+
+    connect(conversation, &audio::ConversationManager::udpChannelOpenedChanged, this, [this, device](bool opened) {
+        if (opened && device->phase == Phase::OpeningChannel) {
+            record("channel", device->stageClock);
+            beginTurn(device);
+        } else if (!opened && (device->phase == Phase::Talking || device->phase == Phase::AwaitingReply)) {
+            fail(device, "channel_closed");
+        }
+    });
+
+    connect(conversation, &audio::ConversationManager::sttTextReceived, this, [this, device](const QString&) {
+        if (device->phase == Phase::AwaitingReply && !device->sttSeen) {
+            device->sttSeen = true;
+            record("stt", device->stageClock);
+        }
+    });
+
+    connect(conversation, &audio::ConversationManager::ttsMessageStarted, this, [this, device](const QString&, qint64) {
+        if (device->phase == Phase::AwaitingReply && !device->ttsSeen) {
+            device->ttsSeen = true;
+            record("tts_start", device->stageClock);
+        }
+    });
+
+    connect(conversation, &audio::ConversationManager::stateChanged, this, [this, device](audio::ConversationState state) {
+        if (device->phase != Phase::AwaitingReply) {
+            return;
+        }
+        if (state == audio::ConversationState::Speaking) {
+            device->speakingSeen = true;
+        } else if (state == audio::ConversationState::Idle && device->speakingSeen) {
+            record("turn", device->stageClock);
+            finishTurn(device, false);
+        }
+    });
+
+    if (device->phase == Phase::OpeningChannel && conversation->udpChannelOpened()) {
+        record("channel", device->stageClock);
+        beginTurn(device);
+    }
+}
+
+void LoadGenerator::beginTurn(Device* device) {
+    audio::ConversationManager* conversation = device->session->conversationManager();
+    if (!conversation) {
+        fail(device, "no_conversation");
+        return;
+    }
+    device->phase = Phase::Talking;
+    device->sttSeen = false;
+    device->ttsSeen = false;
+    device->speakingSeen = false;
+    conversation->startConversation();
+    armTimer(device, m_config.talkMs);
+}
+
+void LoadGenerator::endTalking(Device* device) {
+    audio::ConversationManager* conversation = device->session->conversationManager();
+    if (!conversation) {
+        fail(device, "no_conversation");
+        return;
+    }
+    conversation->stopRecording();
+    device->phase = Phase::AwaitingReply;
+    device->stageClock.start();
+    armTimer(device, m_config.responseTimeoutMs);
+}
+
+void LoadGenerator::finishTurn(Device* device, bool timedOut) {
+    if (timedOut) {
+        ++m_timeouts;
+        // 超时仍在播报则打断，保证下一轮从空闲开始
+        if (audio::ConversationManager* conversation = device->session->conversationManager()) {
+            if (conversation->state() == audio::ConversationState::Speaking) {
+                conversation->abortSpeaking();
+            }
+        }
+    }
+
+    ++device->turnsDone;
+    if (device->turnsDone >= m_config.turns) {
+        device->phase = Phase::Done;
+        device->timer->stop();
+        checkAllDone();
+        return;
+    }
+    device->phase = Phase::Gap;
+    armTimer(device, m_config.turnGapMs);
+}
+
+void LoadGenerator::fail(Device* device, const QString& reason) {
+    if (device->phase == Phase::Done || device->phase == Phase::Failed) {
+        return;
+    }
+    device->phase = Phase::Failed;
+    device->timer->stop();
+    m_failures[reason]++;
+    utils::Logger::instance().warn(QString("[loadgen] 设备 #%1 失败: %2").arg(device->index).arg(reason));
+    checkAllDone();
+}
+
+void LoadGenerator::armTimer(Device* device, int ms) {
+    device->timer->start(qMax(0, ms));
+}
+
+void LoadGenerator::onTimer(Device* device) {
+    switch (device->phase) {
+    case Phase::Ota:
+        fail(device, "ota_timeout");
+        break;
+    case Phase::Connecting:
+        fail(device, "connect_timeout");
+        break;
+    case Phase::OpeningChannel:
+        fail(device, "channel_timeout");
+        break;
+    case Phase::Talking:
+        endTalking(device);
+        break;
+    case Phase::AwaitingReply:
+        finishTurn(device, true);
+        break;
+    case Phase::Gap:
+        beginTurn(device);
+        break;
+    default:
+        break;
+    }
+}
+
+void LoadGenerator::checkAllDone() {
+    if (m_launched < m_config.devices) {
+        return;
+    }
+    for (const auto& device : m_devices) {
+        if (device->phase != Phase::Done && device->phase != Phase::Failed) {
+            return;
+        }
+    }
+    report();
+}
+
+void LoadGenerator::sampleResources() {
+    const qint64 nowMs = m_runClock.elapsed();
+    const double cpu = processCpuSeconds();
+    if (nowMs > m_lastSampleMs) {
+        const double percent = (cpu - m_lastCpuSec) * 100000.0 / (nowMs - m_lastSampleMs);
+        m_peakCpuPercent = qMax(m_peakCpuPercent, percent);
+    }
+    m_lastCpuSec = cpu;
+    m_lastSampleMs = nowMs;
+    m_peakRssKb = qMax(m_peakRssKb, processRssKb());
+
+    int active = 0;
+    for (const auto& device : m_devices) {
+        if (device->phase != Phase::Done && device->phase != Phase::Failed) {
+            ++active;
+        }
+    }
+    m_peakActive = qMax(m_peakActive, active);
+}
+
+void LoadGenerator::record(const QString& stage, const QElapsedTimer& clock) {
+    m_latencies[stage].append(clock.nsecsElapsed() / 1e6);
+}
+
+void LoadGenerator::report() {
+    if (m_reported) {
+        return;
+    }
+    m_reported = true;
+    sampleResources();
+    m_rampTimer.stop();
+    m_sampleTimer.stop();
+    m_deadline.stop();
+    for (const auto& device : m_devices) {
+        device->timer->stop();
+    }
+
+    QTextStream out(stdout);
+    const double wallSec = m_runClock.elapsed() / 1000.0;
+    int done = 0;
+    for (const auto& device : m_devices) {
+        if (device->phase == Phase::Done) {
+            ++done;
+        }
+    }
+
+    out << "\n=== loadgen report ===\n";
+    out << QString("devices: %1 launched, %2 completed, %3 failed, %4 turn timeouts, wall %5 s\n")
+               .arg(m_launched).arg(done)
+               .arg(std::count_if(m_devices.begin(), m_devices.end(),
+                                  [](const auto& d) { return d->phase == Phase::Failed; }))
+               .arg(m_timeouts).arg(wallSec, 0, 'f', 1);
+
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg("stage", -10).arg("count", 7).arg("p50 ms", 10)
+               .arg("p90 ms", 10).arg("p99 ms", 10).arg("max ms", 10);
+    for (const char* stage : STAGE_ORDER) {
+        QVector<double> samples = m_latencies.value(stage);
+        std::sort(samples.begin(), samples.end());
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+                   .arg(stage, -10).arg(samples.size(), 7)
+                   .arg(percentile(samples, 50), 10, 'f', 1)
+                   .arg(percentile(samples, 90), 10, 'f', 1)
+                   .arg(percentile(samples, 99), 10, 'f', 1)
+                   .arg(samples.isEmpty() ? 0.0 : samples.last(), 10, 'f', 1);
+    }
+
+    if (!m_failures.isEmpty()) {
+        out << "failures:\n";
+        for (auto it = m_failures.constBegin(); it != m_failures.constEnd(); ++it) {
+            out << QString("  %1: %2\n").arg(it.key()).arg(it.value());
+        }
+    }
+
+    // 资源：按峰值并发设备数摊分
+    const double cpuSec = processCpuSeconds() - m_cpuStartSec;
+    const int perDevice = qMax(1, m_peakActive);
+    const double rssGrowthMb = (m_peakRssKb - m_baselineRssKb) / 1024.0;
+    out << QString("cpu: %1 s total, avg %2%, peak %3%, %4 ms/s per device\n")
+               .arg(cpuSec, 0, 'f', 2)
+               .arg(wallSec > 0 ? cpuSec * 100.0 / wallSec : 0.0, 0, 'f', 1)
+               .arg(m_peakCpuPercent, 0, 'f', 1)
+               .arg(wallSec > 0 ? cpuSec * 1000.0 / wallSec / perDevice : 0.0, 0, 'f', 2);
+    out << QString("rss: baseline %1 MB, peak %2 MB, %3 MB per device (peak concurrency %4)\n")
+               .arg(m_baselineRssKb / 1024.0, 0, 'f', 1)
+               .arg(m_peakRssKb / 1024.0, 0, 'f', 1)
+               .arg(rssGrowthMb / perDevice, 0, 'f', 2)
+               .arg(m_peakActive);
+    quint64 nullSinkBytes = 0;
+    for (const auto& device : m_devices) {
+        nullSinkBytes += device->audioDevice->nullSinkBytes();
+    }
+    out << QString("playback: %1 bytes decoded to null sink\n").arg(nullSinkBytes);
+    out.flush();
+
+    emit finished();
+}
+
+QString LoadGenerator::macForIndex(const QString& prefix, int index) {
+    // 前缀补足到6字节，剩余字节按序号填充（大端）
+    QStringList octets = prefix.split(':', Qt::SkipEmptyParts);
+    while (octets.size() > 6) {
+        octets.removeLast();
+    }
+    const int free = 6 - octets.size();
+    for (int i = free - 1; i >= 0; --i) {
+        octets.append(QString("%1").arg((index >> (8 * i)) & 0xFF, 2, 16, QChar('0')));
+    }
+    return octets.join(':').toLower();
+}
+
+} // namespace loadgen
+} // namespace xiaozhi
@@ -0,0 +1,154 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:50:00Z
+File: LoadGenerator.h
+Desc: 无头多设备压测驱动（复用DeviceSession完整协议栈，统计各阶段延迟与资源占用）
+*/
+
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+namespace xiaozhi {
+namespace audio {
+class AudioDevice;
+}
+namespace network {
+class DeviceSession;
+}
+
+namespace loadgen {
+
+/**
+ * @brief 压测参数
+ */
+struct LoadConfig {
+    QString otaUrl;                 // OTA服务器地址
+    int devices = 10;               // 模拟设备数
+    int rampMs = 200;               // 相邻设备启动间隔（毫秒）
+    int turns = 3;                  // 每设备对话轮数
+    int talkMs = 3000;              // 每轮上行说话时长（毫秒）
+    int turnGapMs = 1000;           // 轮次间隔（毫秒）
+    int responseTimeoutMs = 15000;  // 单阶段等待超时（毫秒）
+    int durationS = 0;              // 总时长上限（秒，0表示跑完所有轮次）
+    bool websocket = false;         // 使用WebSocket协议
+    QString macPrefix = "02:4c:47"; // 合成MAC前缀（本地管理地址）
+    QByteArray loopPcm;             // 上行循环PCM（为空时使用合成正弦波）
+};
+
+/**
+ * @brief 多设备压测驱动
+ *
+ * 每个模拟设备都是一个真实的DeviceSession（OTA→MQTT/WebSocket→音频通道→对话），
+ * 上行采集替换为SyntheticPcmSource，下行播放到各自独立的空输出AudioDevice
+ * （与真实设备一样每个会话独占播放状态，互不打断、互不抢占排空）。
+ * 采集的阶段：
+ * - ota：请求OTA到配置返回
+ * - connect：OTA完成到信令连接建立（含会话内置的连接延迟）
+ * - channel：信令连接到音频通道打开
+ * - stt：停止说话到收到STT文本
+ * - tts_start：停止说话到开始播报
+ * - turn：停止说话到播报结束回到空闲
+ */
+class LoadGenerator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LoadGenerator(const LoadConfig& config, QObject* parent = nullptr);
+    ~LoadGenerator();
+
+    /**
+     * @brief 开始压测（按ramp间隔逐个启动设备）
+     */
+    void start();
+
+signals:
+    /**
+     * @brief 压测结束（报告已输出）
+     */
+    void finished();
+
+private:
+    enum class Phase {
+        Pending,        // 尚未启动
+        Ota,            // 等待OTA配置
+        Connecting,     // 等待信令连接
+        OpeningChannel, // 等待音频通道
+        Talking,        // 上行说话中
+        AwaitingReply,  // 等待服务器回复
+        Gap,            // 轮次间隔
+        Done,           // 已完成
+        Failed          // 已失败
+    };
+
+    struct Device {
+        int index = 0;
+        std::unique_ptr<audio::AudioDevice> audioDevice;   // 本设备的空输出播放设备
+        network::DeviceSession* session = nullptr;
+        Phase phase = Phase::Pending;
+        int turnsDone = 0;
+        bool sttSeen = false;
+        bool ttsSeen = false;
+        bool speakingSeen = false;
+        QElapsedTimer stageClock;       // 当前阶段起点
+        QTimer* timer = nullptr;        // 说话时长/轮次间隔/超时
+    };
+
+    void launchNext();
+    void createDevice(int index);
+    void wireConversation(Device* device);
+    void beginTurn(Device* device);
+    void endTalking(Device* device);
+    void finishTurn(Device* device, bool timedOut);
+    void fail(Device* device, const QString& reason);
+    void armTimer(Device* device, int ms);
+    void onTimer(Device* device);
+    void checkAllDone();
+    void sampleResources();
+
+    void record(const QString& stage, const QElapsedTimer& clock);
+    void report();
+
+    static QString macForIndex(const QString& prefix, int index);
+
+    LoadConfig m_config;
+    std::vector<std::unique_ptr<Device>> m_devices;
+    QHash<network::DeviceSession*, Device*> m_bySession;
+    QTimer m_rampTimer;
+    QTimer m_sampleTimer;
+    QTimer m_deadline;
+    QElapsedTimer m_runClock;
+    int m_launched;
+    bool m_reported;
+
+    QMap<QString, QVector<double>> m_latencies;     // 阶段 → 延迟样本（毫秒）
+    QMap<QString, int> m_failures;                  // 失败原因 → 次数
+    int m_timeouts;
+
+    // 资源采样
+    double m_cpuStartSec;
+    double m_lastCpuSec;
+    qint64 m_lastSampleMs;
+    double m_peakCpuPercent;
+    qint64 m_baselineRssKb;
+    qint64 m_peakRssKb;
+    int m_peakActive;
+};
+
+} // namespace loadgen
+} // namespace xiaozhi
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,102 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T14:30:00Z
+File: SyntheticPcmSource.cpp
+Desc: 无头压测的采集数据源实现
+*/
+
+#include "SyntheticPcmSource.h"
+#include <QtMath>
+#include <cstring>
+
+namespace xiaozhi {
+namespace loadgen {
+
+SyntheticPcmSource::SyntheticPcmSource(const audio::AudioConfig& config, const QByteArray& loopPcm,
+                                       int seed, QObject* parent)
+    : QIODevice(parent)
+    , m_config(config)
+    , m_loopPcm(loopPcm)
+    , m_loopOffset(0)
+    , m_frequency(220.0 + 20.0 * (seed % 20))
+    , m_sampleIndex(0)
+    , m_bytesPerSecond(static_cast<qint64>(config.sampleRate) * config.channelCount * (config.sampleSize / 8))
+    , m_producedBytes(0)
+    , m_buffer(static_cast<size_t>(m_bytesPerSecond))   // 缓冲1秒，读取方停滞时丢弃最旧之外的新数据
+{
+    // 循环PCM按整采样对齐
+    const int sampleBytes = m_config.channelCount * (m_config.sampleSize / 8);
+    if (m_loopPcm.size() % sampleBytes != 0) {
+        m_loopPcm.chop(m_loopPcm.size() % sampleBytes);
+    }
+
+    open(QIODevice::ReadOnly);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(TICK_MS);
+    connect(&m_timer, &QTimer::timeout, this, &SyntheticPcmSource::onTick);
+    m_clock.start();
+    m_timer.start();
+}
+
+qint64 SyntheticPcmSource::bytesAvailable() const {
+    return static_cast<qint64>(m_buffer.size()) + QIODevice::bytesAvailable();
+}
+
+qint64 SyntheticPcmSource::readData(char* data, qint64 maxlen) {
+    return static_cast<qint64>(m_buffer.read(data, static_cast<size_t>(maxlen)));
+}
+
+qint64 SyntheticPcmSource::writeData(const char* data, qint64 len) {
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return -1;
+}
+
+void SyntheticPcmSource::onTick() {
+    // 按墙钟计算应产出的总量（整采样对齐），定时器延迟时一次补齐
+    const int sampleBytes = m_config.channelCount * (m_config.sampleSize / 8);
+    qint64 due = m_clock.elapsed() * m_bytesPerSecond / 1000;
+    due -= due % sampleBytes;
+    if (due > m_producedBytes) {
+        produce(due - m_producedBytes);
+        m_producedBytes = due;
+        emit readyRead();
+    }
+}
+
+void SyntheticPcmSource::produce(qint64 bytes) {
+    char chunk[1024];
+    while (bytes > 0) {
+        const qint64 n = qMin<qint64>(bytes, sizeof(chunk));
+        if (!m_loopPcm.isEmpty()) {
+            // 循环拷贝文件PCM
+            qint64 filled = 0;
+            while (filled < n) {
+                const qint64 part = qMin<qint64>(n - filled, m_loopPcm.size() - m_loopOffset);
+                std::memcpy(chunk + filled, m_loopPcm.constData() + m_loopOffset, static_cast<size_t>(part));
+                filled += part;
+                m_loopOffset = (m_loopOffset + part) % m_loopPcm.size();
+            }
+        } else {
+            // 合成正弦波（16位小端，所有声道相同）
+            qint16* samples = reinterpret_cast<qint16*>(chunk);
+            const qint64 frames = n / (2 * m_config.channelCount);
+            for (qint64 i = 0; i < frames; ++i, ++m_sampleIndex) {
+                const double t = static_cast<double>(m_sampleIndex) / m_config.sampleRate;
+                const qint16 value = static_cast<qint16>(32767.0 * 0.3 * qSin(2.0 * M_PI * m_frequency * t));
+                for (int ch = 0; ch < m_config.channelCount; ++ch) {
+                    *samples++ = value;
+                }
+            }
+        }
+        // 读取方停滞导致缓冲满时，超出部分丢弃（与麦克风溢出行为一致）
+        m_buffer.write(chunk, static_cast<size_t>(n));
+        bytes -= n;
+    }
+}
+
+} // namespace loadgen
+} // namespace xiaozhi
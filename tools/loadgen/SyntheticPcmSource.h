@@ -0,0 +1,76 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T14:30:00Z
+File: SyntheticPcmSource.h
+Desc: 无头压测的采集数据源（按实时节奏产出文件PCM或合成正弦波，替代麦克风）
+*/
+
+#ifndef SYNTHETIC_PCM_SOURCE_H
+#define SYNTHETIC_PCM_SOURCE_H
+
+#include "../../src/audio/AudioTypes.h"
+#include "../../src/audio/SpscRingBuffer.h"
+#include <QIODevice>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QTimer>
+
+namespace xiaozhi {
+namespace loadgen {
+
+/**
+ * @brief 合成/文件PCM采集数据源
+ *
+ * 以墙钟为基准每个节拍补齐应产出的采样，行为与麦克风一致（按实时速率发出readyRead）：
+ * - loopPcm非空：循环播放该PCM（需与采集格式一致：16kHz单声道s16le）
+ * - loopPcm为空：生成正弦波，频率由seed区分，便于在服务器侧区分设备
+ *
+ * 在采集工作者所在的音频线程中创建和使用
+ */
+class SyntheticPcmSource : public QIODevice {
+    Q_OBJECT
+
+public:
+    SyntheticPcmSource(const audio::AudioConfig& config, const QByteArray& loopPcm,
+                       int seed, QObject* parent = nullptr);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override;
+    qint64 writeData(const char* data, qint64 len) override;
+
+private slots:
+    /**
+     * @brief 节拍：按已过时间补齐采样并通知读取
+     */
+    void onTick();
+
+private:
+    /**
+     * @brief 产出n字节PCM写入缓冲
+     */
+    void produce(qint64 bytes);
+
+    static constexpr int TICK_MS = 20;
+
+    audio::AudioConfig m_config;
+    QByteArray m_loopPcm;       // 循环播放的PCM（隐式共享，只读）
+    qint64 m_loopOffset;        // 循环播放位置（字节）
+    double m_frequency;         // 合成正弦波频率（Hz）
+    qint64 m_sampleIndex;       // 合成正弦波的采样序号
+    qint64 m_bytesPerSecond;
+    qint64 m_producedBytes;     // 已产出字节数
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    audio::SpscRingBuffer m_buffer;
+};
+
+} // namespace loadgen
+} // namespace xiaozhi
+
+#endif // SYNTHETIC_PCM_SOURCE_H
@@ -0,0 +1,151 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-17T10:50:00Z
+File: main.cpp
+Desc: 无头压测工具入口（xiaozhi-loadgen）
+*/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QtEndian>
+#include "LoadGenerator.h"
+#include "../../src/version/version_info.h"
+#include "../../src/utils/Logger.h"
+
+namespace {
+
+/**
+ * @brief 从WAV文件中取出PCM数据
+ *
+ * 逐个遍历RIFF子块定位fmt与data（LIST等附加块、扩展fmt块的位置和长度都不固定），
+ * 并校验格式为16kHz单声道16位PCM
+ */
+bool extractWavPcm(const QByteArray& wav, QByteArray& pcm, QString& error) {
+    if (wav.size() < 12 || !wav.startsWith("RIFF") || wav.mid(8, 4) != "WAVE") {
+        error = "不是RIFF/WAVE文件";
+        return false;
+    }
+
+    const auto* bytes = reinterpret_cast<const uchar*>(wav.constData());
+    bool fmtSeen = false;
+    qsizetype offset = 12;
+    while (offset + 8 <= wav.size()) {
+        const QByteArray id = wav.mid(offset, 4);
+        const quint32 size = qFromLittleEndian<quint32>(bytes + offset + 4);
+        const qsizetype body = offset + 8;
+        const qsizetype available = qMin<qsizetype>(size, wav.size() - body);
+
+        if (id == "fmt ") {
+            if (available < 16) {
+                error = "fmt块过短";
+                return false;
+            }
+            const quint16 format = qFromLittleEndian<quint16>(bytes + body);
+            const quint16 channels = qFromLittleEndian<quint16>(bytes + body + 2);
+            const quint32 sampleRate = qFromLittleEndian<quint32>(bytes + body + 4);
+            const quint16 bitsPerSample = qFromLittleEndian<quint16>(bytes + body + 14);
+            // 1为PCM，0xFFFE为WAVE_FORMAT_EXTENSIBLE（子格式同样可能是PCM）
+            if ((format != 1 && format != 0xFFFE) || channels != 1 || sampleRate != 16000 || bitsPerSample != 16) {
+                error = QString("需要16kHz单声道16位PCM（实际格式%1，%2声道，%3Hz，%4位）")
+                            .arg(format).arg(channels).arg(sampleRate).arg(bitsPerSample);
+                return false;
+            }
+            fmtSeen = true;
+        } else if (id == "data") {
+            if (!fmtSeen) {
+                error = "data块之前缺少fmt块";
+                return false;
+            }
+            // 截断的文件只取实际存在的部分
+            pcm = wav.mid(body, available & ~qsizetype(1));
+            return true;
+        }
+
+        // 子块按偶数字节对齐
+        offset = body + static_cast<qsizetype>(size) + (size & 1);
+    }
+
+    error = "未找到data块";
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(xiaozhi::version::AUTHOR);
+    app.setApplicationName("xiaozhi-loadgen");
+    app.setApplicationVersion(xiaozhi::version::VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("小智服务器无头压测工具：模拟多台设备完成OTA、连接、音频通道与多轮对话");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption otaOpt("ota-url", "OTA服务器地址", "url");
+    QCommandLineOption devicesOpt("devices", "模拟设备数（默认10）", "n", "10");
+    QCommandLineOption rampOpt("ramp-ms", "相邻设备启动间隔毫秒（默认200）", "ms", "200");
+    QCommandLineOption turnsOpt("turns", "每设备对话轮数（默认3）", "n", "3");
+    QCommandLineOption talkOpt("talk-ms", "每轮上行说话时长毫秒（默认3000）", "ms", "3000");
+    QCommandLineOption gapOpt("turn-gap-ms", "轮次间隔毫秒（默认1000）", "ms", "1000");
+    QCommandLineOption timeoutOpt("response-timeout-ms", "单阶段等待超时毫秒（默认15000）", "ms", "15000");
+    QCommandLineOption durationOpt("duration-s", "总时长上限秒（默认0，跑完所有轮次）", "s", "0");
+    QCommandLineOption pcmOpt("pcm-file", "上行循环音频（16kHz单声道s16le的.pcm或.wav），缺省为合成正弦波", "path");
+    QCommandLineOption wsOpt("websocket", "使用WebSocket协议（服务器提供时）");
+    QCommandLineOption macOpt("mac-prefix", "合成MAC前缀（默认02:4c:47）", "prefix", "02:4c:47");
+    QCommandLineOption verboseOpt("verbose", "输出客户端日志到控制台");
+    parser.addOptions({ otaOpt, devicesOpt, rampOpt, turnsOpt, talkOpt, gapOpt, timeoutOpt,
+                        durationOpt, pcmOpt, wsOpt, macOpt, verboseOpt });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    if (!parser.isSet(otaOpt)) {
+        err << "缺少 --ota-url\n";
+        parser.showHelp(1);
+    }
+
+    xiaozhi::loadgen::LoadConfig config;
+    config.otaUrl = parser.value(otaOpt);
+    config.devices = qMax(1, parser.value(devicesOpt).toInt());
+    config.rampMs = parser.value(rampOpt).toInt();
+    config.turns = qMax(0, parser.value(turnsOpt).toInt());
+    config.talkMs = parser.value(talkOpt).toInt();
+    config.turnGapMs = parser.value(gapOpt).toInt();
+    config.responseTimeoutMs = parser.value(timeoutOpt).toInt();
+    config.durationS = parser.value(durationOpt).toInt();
+    config.websocket = parser.isSet(wsOpt);
+    config.macPrefix = parser.value(macOpt);
+
+    if (parser.isSet(pcmOpt)) {
+        QFile file(parser.value(pcmOpt));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "无法打开音频文件: " << file.fileName() << "\n";
+            return 1;
+        }
+        config.loopPcm = file.readAll();
+        if (config.loopPcm.startsWith("RIFF")) {
+            QByteArray pcm;
+            QString error;
+            if (!extractWavPcm(config.loopPcm, pcm, error)) {
+                err << "无法解析WAV文件 " << file.fileName() << ": " << error << "\n";
+                return 1;
+            }
+            config.loopPcm = pcm;
+        }
+    }
+
+    // 数百个会话的客户端日志会淹没报告，默认只写日志文件
+    xiaozhi::utils::Logger::instance().setConsoleOutput(parser.isSet(verboseOpt));
+
+    xiaozhi::loadgen::LoadGenerator generator(config);
+    QObject::connect(&generator, &xiaozhi::loadgen::LoadGenerator::finished,
+                     &app, &QCoreApplication::quit, Qt::QueuedConnection);
+    generator.start();
+
+    return app.exec();
+}
@@ -0,0 +1,302 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: MqttGateway.cpp
+Desc: 本地替身服务器的最小MQTT网关实现
+*/
+
+#include "MqttGateway.h"
+#include "../../src/utils/Logger.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+
+namespace xiaozhi {
+namespace standin {
+
+namespace {
+
+// 报文类型（固定头高4位）
+constexpr quint8 CONNECT = 1;
+constexpr quint8 CONNACK = 2;
+constexpr quint8 PUBLISH = 3;
+constexpr quint8 PUBACK = 4;
+constexpr quint8 SUBSCRIBE = 8;
+constexpr quint8 SUBACK = 9;
+constexpr quint8 UNSUBSCRIBE = 10;
+constexpr quint8 UNSUBACK = 11;
+constexpr quint8 PINGREQ = 12;
+constexpr quint8 PINGRESP = 13;
+constexpr quint8 DISCONNECT = 14;
+
+// 单个报文上限（设备JSON消息远小于此值）
+constexpr int MAX_PACKET_SIZE = 1024 * 1024;
+
+/**
+ * @brief 按MQTT UTF-8字符串格式读取（2字节大端长度+内容）
+ */
+bool readString(const QByteArray& body, int& pos, QByteArray& out) {
+    if (pos + 2 > body.size()) {
+        return false;
+    }
+    const int len = qFromBigEndian<quint16>(body.constData() + pos);
+    pos += 2;
+    if (pos + len > body.size()) {
+        return false;
+    }
+    out = body.mid(pos, len);
+    pos += len;
+    return true;
+}
+
+void appendString(QByteArray& out, const QByteArray& value) {
+    const quint16 len = qToBigEndian<quint16>(static_cast<quint16>(value.size()));
+    out.append(reinterpret_cast<const char*>(&len), 2);
+    out.append(value);
+}
+
+} // namespace
+
+MqttGateway::MqttGateway(QObject* parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MqttGateway::onNewConnection);
+}
+
+MqttGateway::~MqttGateway() {
+}
+
+bool MqttGateway::listen(const QHostAddress& address, quint16 port) {
+    if (!m_server->listen(address, port)) {
+        utils::Logger::instance().error(QString("[standin] MQTT监听失败: %1").arg(m_server->errorString()));
+        return false;
+    }
+    return true;
+}
+
+quint16 MqttGateway::serverPort() const {
+    return m_server->serverPort();
+}
+
+void MqttGateway::publish(QTcpSocket* client, const QByteArray& payload) {
+    auto it = m_clients.find(client);
+    if (it == m_clients.end() || !it->connected) {
+        return;
+    }
+    QByteArray body;
+    body.reserve(2 + it->replyTopic.size() + payload.size());
+    appendString(body, it->replyTopic.toUtf8());
+    body.append(payload);
+    client->write(encodePacket(PUBLISH << 4, body));
+}
+
+void MqttGateway::onNewConnection() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_clients.insert(socket, Client());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { onDisconnected(socket); });
+    }
+}
+
+void MqttGateway::onReadyRead(QTcpSocket* socket) {
+    auto it = m_clients.find(socket);
+    if (it == m_clients.end()) {
+        return;
+    }
+    Client& client = *it;
+    client.buffer.append(socket->readAll());
+
+    // 逐个切出完整报文：固定头1字节 + 剩余长度（1~4字节变长编码）+ 报文体
+    int consumed = 0;
+    while (client.buffer.size() - consumed >= 2) {
+        const char* data = client.buffer.constData() + consumed;
+        const int available = client.buffer.size() - consumed;
+
+        int remaining = 0;
+        int multiplier = 1;
+        int lenBytes = 0;
+        bool complete = false;
+        while (lenBytes < 4 && 1 + lenBytes < available) {
+            const quint8 byte = static_cast<quint8>(data[1 + lenBytes]);
+            remaining += (byte & 0x7F) * multiplier;
+            multiplier *= 128;
+            ++lenBytes;
+            if ((byte & 0x80) == 0) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            if (lenBytes >= 4) {
+                socket->abort();
+                return;
+            }
+            break;  // 长度字段尚未收全
+        }
+        if (remaining > MAX_PACKET_SIZE) {
+            socket->abort();
+            return;
+        }
+        const int total = 1 + lenBytes + remaining;
+        if (available < total) {
+            break;  // 报文体尚未收全
+        }
+
+        const quint8 header = static_cast<quint8>(data[0]);
+        const QByteArray body(data + 1 + lenBytes, remaining);
+        consumed += total;
+        if (!handlePacket(socket, client, header, body)) {
+            socket->abort();
+            return;
+        }
+    }
+    client.buffer.remove(0, consumed);
+}
+
+void MqttGateway::onDisconnected(QTcpSocket* socket) {
+    if (m_clients.remove(socket) > 0) {
+        emit clientDisconnected(socket);
+    }
+    socket->deleteLater();
+}
+
+bool MqttGateway::handlePacket(QTcpSocket* socket, Client& client, quint8 header, const QByteArray& body) {
+    const quint8 type = header >> 4;
+    if (!client.connected && type != CONNECT) {
+        return false;
+    }
+
+    switch (type) {
+    case CONNECT:
+        return handleConnect(socket, client, body);
+    case PUBLISH:
+        return handlePublish(socket, client, header, body);
+    case SUBSCRIBE:
+        return handleSubscribe(socket, body, false);
+    case UNSUBSCRIBE:
+        return handleSubscribe(socket, body, true);
+    case PINGREQ:
+        socket->write(encodePacket(PINGRESP << 4, QByteArray()));
+        return true;
+    case DISCONNECT:
+        socket->disconnectFromHost();
+        return true;
+    case PUBACK:
+        return true;    // 只下发QoS0，不会收到；容错忽略
+    default:
+        utils::Logger::instance().warn(QString("[standin] 不支持的MQTT报文类型: %1").arg(type));
+        return false;
+    }
+}
+
+bool MqttGateway::handleConnect(QTcpSocket* socket, Client& client, const QByteArray& body) {
+    int pos = 0;
+    QByteArray protocolName;
+    if (!readString(body, pos, protocolName) || pos + 4 > body.size()) {
+        return false;
+    }
+    const quint8 level = static_cast<quint8>(body[pos]);
+    const quint8 flags = static_cast<quint8>(body[pos + 1]);
+    pos += 4;   // level + flags + keepalive
+
+    if (!((protocolName == "MQTT" && level == 4) || (protocolName == "MQIsdp" && level == 3))) {
+        // 不支持的协议版本：返回码1
+        QByteArray ack(2, '\0');
+        ack[1] = 0x01;
+        socket->write(encodePacket(CONNACK << 4, ack));
+        return false;
+    }
+
+    QByteArray clientId;
+    if (!readString(body, pos, clientId)) {
+        return false;
+    }
+    if (flags & 0x04) {
+        // 跳过遗嘱主题与消息
+        QByteArray skip;
+        if (!readString(body, pos, skip) || !readString(body, pos, skip)) {
+            return false;
+        }
+    }
+    // 用户名/密码不做校验（替身服务器不鉴权）
+
+    client.clientId = QString::fromUtf8(clientId);
+    client.replyTopic = QString("devices/p2p/%1").arg(client.clientId);
+    client.connected = true;
+
+    socket->write(encodePacket(CONNACK << 4, QByteArray(2, '\0')));
+    return true;
+}
+
+bool MqttGateway::handlePublish(QTcpSocket* socket, Client& client, quint8 header, const QByteArray& body) {
+    const int qos = (header >> 1) & 0x03;
+    int pos = 0;
+    QByteArray topic;
+    if (!readString(body, pos, topic)) {
+        return false;
+    }
+    if (qos > 0) {
+        if (pos + 2 > body.size()) {
+            return false;
+        }
+        const QByteArray packetId = body.mid(pos, 2);
+        pos += 2;
+        if (qos == 1) {
+            socket->write(encodePacket(PUBACK << 4, packetId));
+        } else {
+            return false;   // 设备不使用QoS2
+        }
+    }
+    emit messageReceived(socket, client.clientId, body.mid(pos));
+    return true;
+}
+
+bool MqttGateway::handleSubscribe(QTcpSocket* socket, const QByteArray& body, bool unsubscribe) {
+    if (body.size() < 2) {
+        return false;
+    }
+    const QByteArray packetId = body.left(2);
+    if (unsubscribe) {
+        socket->write(encodePacket(UNSUBACK << 4, packetId));
+        return true;
+    }
+
+    // 每个主题授予QoS0
+    QByteArray ack = packetId;
+    int pos = 2;
+    while (pos < body.size()) {
+        QByteArray filter;
+        if (!readString(body, pos, filter) || pos >= body.size()) {
+            return false;
+        }
+        ++pos;  // 请求的QoS
+        ack.append('\0');
+    }
+    socket->write(encodePacket(SUBACK << 4, ack));
+    return true;
+}
+
+QByteArray MqttGateway::encodePacket(quint8 header, const QByteArray& body) {
+    QByteArray packet;
+    packet.reserve(5 + body.size());
+    packet.append(static_cast<char>(header));
+    int remaining = body.size();
+    do {
+        quint8 byte = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) {
+            byte |= 0x80;
+        }
+        packet.append(static_cast<char>(byte));
+    } while (remaining > 0);
+    packet.append(body);
+    return packet;
+}
+
+} // namespace standin
+} // namespace xiaozhi
@@ -0,0 +1,99 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: MqttGateway.h
+Desc: 本地替身服务器的最小MQTT 3.1/3.1.1网关（明文TCP，点对点下发，无需订阅）
+*/
+
+#ifndef STANDIN_MQTT_GATEWAY_H
+#define STANDIN_MQTT_GATEWAY_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QString>
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace xiaozhi {
+namespace standin {
+
+/**
+ * @brief 最小MQTT网关
+ *
+ * 行为与小智MQTT网关一致：设备发布到publish_topic的消息交给上层处理，
+ * 服务器消息直接以PUBLISH下发到该设备连接（客户端不订阅任何主题）。
+ * 支持CONNECT/PUBLISH(QoS0/1)/SUBSCRIBE/UNSUBSCRIBE/PINGREQ/DISCONNECT，
+ * 不支持遗嘱、保留消息与会话持久化。
+ */
+class MqttGateway : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MqttGateway(QObject* parent = nullptr);
+    ~MqttGateway();
+
+    /**
+     * @brief 开始监听
+     */
+    bool listen(const QHostAddress& address, quint16 port);
+    quint16 serverPort() const;
+
+    /**
+     * @brief 向指定客户端连接下发消息（QoS0）
+     * @param client 客户端连接
+     * @param payload 消息内容（JSON文本）
+     */
+    void publish(QTcpSocket* client, const QByteArray& payload);
+
+    int clientCount() const { return m_clients.size(); }
+
+signals:
+    /**
+     * @brief 客户端发布了消息
+     */
+    void messageReceived(QTcpSocket* client, const QString& clientId, const QByteArray& payload);
+
+    /**
+     * @brief 客户端断开（连接对象随后被deleteLater）
+     */
+    void clientDisconnected(QTcpSocket* client);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Client {
+        QByteArray buffer;          // 未解析的入站字节
+        QString clientId;
+        QString replyTopic;         // 下发主题
+        bool connected = false;     // 已完成CONNECT
+    };
+
+    void onReadyRead(QTcpSocket* socket);
+    void onDisconnected(QTcpSocket* socket);
+
+    /**
+     * @brief 处理一个完整报文
+     * @return false表示协议错误，需断开连接
+     */
+    bool handlePacket(QTcpSocket* socket, Client& client, quint8 header, const QByteArray& body);
+    bool handleConnect(QTcpSocket* socket, Client& client, const QByteArray& body);
+    bool handlePublish(QTcpSocket* socket, Client& client, quint8 header, const QByteArray& body);
+    bool handleSubscribe(QTcpSocket* socket, const QByteArray& body, bool unsubscribe);
+
+    static QByteArray encodePacket(quint8 header, const QByteArray& body);
+
+    QTcpServer* m_server;
+    QHash<QTcpSocket*, Client> m_clients;
+};
+
+} // namespace standin
+} // namespace xiaozhi
+
+#endif // STANDIN_MQTT_GATEWAY_H
@@ -0,0 +1,525 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: StandinServer.cpp
+Desc: 本地替身服务器实现
+*/
+
+#include "StandinServer.h"
+#include "MqttGateway.h"
+#include "UdpAudioRelay.h"
+#include "../../src/utils/Logger.h"
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QUuid>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <QtEndian>
+#include <cstring>
+
+namespace xiaozhi {
+namespace standin {
+
+namespace {
+
+// 与客户端WebSocketManager中的定义一致（对齐ESP32固件）
+#pragma pack(push, 1)
+
+struct BinaryProtocol2 {
+    quint16 version;
+    quint16 type;
+    quint32 reserved;
+    quint32 timestamp;
+    quint32 payload_size;
+};
+
+struct BinaryProtocol3 {
+    quint8 type;
+    quint8 reserved;
+    quint16 payload_size;
+};
+
+#pragma pack(pop)
+
+// OTA请求上限（设备信息JSON约1KB）
+constexpr int MAX_OTA_REQUEST = 64 * 1024;
+
+QString randomHex(int bytes) {
+    QByteArray raw(bytes, Qt::Uninitialized);
+    for (int i = 0; i < bytes; ++i) {
+        raw[i] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+    }
+    return QString::fromLatin1(raw.toHex());
+}
+
+QByteArray buildWsPacket(int version, const QByteArray& opus, quint32 timestamp) {
+    if (version == 2) {
+        QByteArray packet(static_cast<int>(sizeof(BinaryProtocol2)) + opus.size(), Qt::Uninitialized);
+        BinaryProtocol2 header;
+        header.version = qToBigEndian<quint16>(2);
+        header.type = 0;
+        header.reserved = 0;
+        header.timestamp = qToBigEndian<quint32>(timestamp);
+        header.payload_size = qToBigEndian<quint32>(static_cast<quint32>(opus.size()));
+        std::memcpy(packet.data(), &header, sizeof(header));
+        std::memcpy(packet.data() + sizeof(header), opus.constData(), static_cast<size_t>(opus.size()));
+        return packet;
+    }
+    if (version == 3) {
+        QByteArray packet(static_cast<int>(sizeof(BinaryProtocol3)) + opus.size(), Qt::Uninitialized);
+        BinaryProtocol3 header;
+        header.type = 0;
+        header.reserved = 0;
+        header.payload_size = qToBigEndian<quint16>(static_cast<quint16>(opus.size()));
+        std::memcpy(packet.data(), &header, sizeof(header));
+        std::memcpy(packet.data() + sizeof(header), opus.constData(), static_cast<size_t>(opus.size()));
+        return packet;
+    }
+    return opus;
+}
+
+/**
+ * @brief 取出二进制帧中的Opus负载（格式错误返回空）
+ */
+QByteArray parseWsPacket(int version, const QByteArray& data) {
+    if (version == 2) {
+        if (data.size() < static_cast<int>(sizeof(BinaryProtocol2))) {
+            return QByteArray();
+        }
+        BinaryProtocol2 header;
+        std::memcpy(&header, data.constData(), sizeof(header));
+        const quint32 size = qFromBigEndian<quint32>(header.payload_size);
+        if (size == 0 || sizeof(header) + size > static_cast<quint32>(data.size())) {
+            return QByteArray();
+        }
+        return data.mid(sizeof(header), static_cast<int>(size));
+    }
+    if (version == 3) {
+        if (data.size() < static_cast<int>(sizeof(BinaryProtocol3))) {
+            return QByteArray();
+        }
+        BinaryProtocol3 header;
+        std::memcpy(&header, data.constData(), sizeof(header));
+        const quint16 size = qFromBigEndian<quint16>(header.payload_size);
+        if (size == 0 || sizeof(header) + size > static_cast<quint32>(data.size())) {
+            return QByteArray();
+        }
+        return data.mid(sizeof(header), size);
+    }
+    return data;
+}
+
+} // namespace
+
+StandinServer::StandinServer(const ServerOptions& options, QObject* parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_otaServer(new QTcpServer(this))
+    , m_mqtt(new MqttGateway(this))
+    , m_udp(new UdpAudioRelay(this))
+    , m_wsServer(new QWebSocketServer("xiaozhi-standin", QWebSocketServer::NonSecureMode, this))
+    , m_otaRequests(0)
+    , m_retiredUplink(0)
+    , m_retiredDownlink(0)
+    , m_retiredTurns(0)
+    , m_lastUplink(0)
+    , m_lastDownlink(0)
+{
+    connect(m_otaServer, &QTcpServer::newConnection, this, &StandinServer::onOtaConnection);
+    connect(m_mqtt, &MqttGateway::messageReceived, this, &StandinServer::onMqttMessage);
+    connect(m_mqtt, &MqttGateway::clientDisconnected, this, &StandinServer::onMqttClientDisconnected);
+    connect(m_wsServer, &QWebSocketServer::newConnection, this, &StandinServer::onWebSocketConnection);
+    connect(&m_statsTimer, &QTimer::timeout, this, &StandinServer::printStats);
+}
+
+StandinServer::~StandinServer() {
+}
+
+bool StandinServer::start() {
+    if (!m_otaServer->listen(m_options.bindAddress, m_options.otaPort)) {
+        utils::Logger::instance().error(QString("[standin] OTA监听失败: %1").arg(m_otaServer->errorString()));
+        return false;
+    }
+    if (m_options.enableMqtt) {
+        if (!m_mqtt->listen(m_options.bindAddress, m_options.mqttPort)
+            || !m_udp->bind(m_options.bindAddress, m_options.udpPort)) {
+            return false;
+        }
+    }
+    if (m_options.enableWebSocket && !m_wsServer->listen(m_options.bindAddress, m_options.wsPort)) {
+        utils::Logger::instance().error(QString("[standin] WebSocket监听失败: %1").arg(m_wsServer->errorString()));
+        return false;
+    }
+
+    // 端口0表示由系统分配，回填实际端口供OTA响应使用
+    m_options.otaPort = m_otaServer->serverPort();
+    if (m_options.enableMqtt) {
+        m_options.mqttPort = m_mqtt->serverPort();
+        m_options.udpPort = m_udp->localPort();
+    }
+    if (m_options.enableWebSocket) {
+        m_options.wsPort = m_wsServer->serverPort();
+    }
+
+    QTextStream out(stdout);
+    out << QString("standin OTA:       http://%1:%2/xiaozhi/ota/\n").arg(m_options.advertisedHost).arg(m_options.otaPort);
+    if (m_options.enableMqtt) {
+        out << QString("standin MQTT:      %1:%2 (UDP %3)\n").arg(m_options.advertisedHost).arg(m_options.mqttPort).arg(m_options.udpPort);
+    }
+    if (m_options.enableWebSocket) {
+        out << QString("standin WebSocket: ws://%1:%2/xiaozhi/v1/ (version %3)\n")
+                   .arg(m_options.advertisedHost).arg(m_options.wsPort).arg(m_options.wsVersion);
+    }
+    out.flush();
+
+    if (m_options.statsIntervalS > 0) {
+        m_statsTimer.start(m_options.statsIntervalS * 1000);
+    }
+    return true;
+}
+
+// ========== OTA ==========
+
+void StandinServer::onOtaConnection() {
+    while (QTcpSocket* socket = m_otaServer->nextPendingConnection()) {
+        m_otaBuffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onOtaReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_otaBuffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void StandinServer::onOtaReadyRead(QTcpSocket* socket) {
+    auto it = m_otaBuffers.find(socket);
+    if (it == m_otaBuffers.end()) {
+        return;
+    }
+    QByteArray& buffer = *it;
+    buffer.append(socket->readAll());
+    if (buffer.size() > MAX_OTA_REQUEST) {
+        socket->abort();
+        return;
+    }
+
+    const int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return;
+    }
+
+    // 解析请求头（只关心Content-Length与Device-Id）
+    int contentLength = 0;
+    QString deviceId;
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines[i].trimmed();
+        const int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            contentLength = value.toInt();
+        } else if (name == "device-id") {
+            deviceId = QString::fromUtf8(value);
+        }
+    }
+    if (buffer.size() < headerEnd + 4 + contentLength) {
+        return;     // 请求体尚未收全
+    }
+
+    ++m_otaRequests;
+    const QByteArray body = QJsonDocument(buildOtaResponse(deviceId)).toJson(QJsonDocument::Compact);
+    QByteArray response = "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: application/json\r\n"
+                          "Connection: close\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+    response.append(body);
+    buffer.clear();
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+QJsonObject StandinServer::buildOtaResponse(const QString& deviceId) const {
+    QJsonObject json;
+
+    QJsonObject firmware;
+    firmware["version"] = "0.0.0";
+    firmware["url"] = "";
+    json["firmware"] = firmware;
+
+    if (!m_options.activationCode.isEmpty()) {
+        QJsonObject activation;
+        activation["code"] = m_options.activationCode;
+        activation["message"] = "standin";
+        json["activation"] = activation;
+    }
+
+    if (m_options.enableMqtt) {
+        QString macKey = deviceId;
+        macKey.replace(':', '_');
+        QJsonObject mqtt;
+        mqtt["endpoint"] = QString("%1:%2").arg(m_options.advertisedHost).arg(m_options.mqttPort);
+        mqtt["client_id"] = QString("GID_standin@@@%1@@@%2").arg(macKey, QUuid::createUuid().toString(QUuid::WithoutBraces));
+        mqtt["username"] = "standin";
+        mqtt["password"] = "standin";
+        mqtt["publish_topic"] = "device-server";
+        mqtt["subscribe_topic"] = "null";
+        json["mqtt"] = mqtt;
+    }
+
+    if (m_options.enableWebSocket) {
+        QJsonObject websocket;
+        websocket["url"] = QString("ws://%1:%2/xiaozhi/v1/").arg(m_options.advertisedHost).arg(m_options.wsPort);
+        websocket["token"] = "standin";
+        websocket["version"] = m_options.wsVersion;
+        json["websocket"] = websocket;
+    }
+    return json;
+}
+
+// ========== MQTT + UDP ==========
+
+void StandinServer::onMqttMessage(QTcpSocket* client, const QString& clientId, const QByteArray& payload) {
+    Q_UNUSED(clientId);
+    const QJsonDocument doc = QJsonDocument::fromJson(payload);
+    if (!doc.isObject()) {
+        return;
+    }
+    const QJsonObject message = doc.object();
+    if (message["type"].toString() == "hello") {
+        startMqttSession(client);
+        return;
+    }
+    auto it = m_mqttSessions.find(client);
+    if (it != m_mqttSessions.end()) {
+        it->session->handleJson(message);
+    }
+}
+
+void StandinServer::onMqttClientDisconnected(QTcpSocket* client) {
+    closeMqttSession(client);
+}
+
+void StandinServer::startMqttSession(QTcpSocket* client) {
+    // 重复hello视为新会话（与真实网关一致，旧的UDP通道作废）
+    closeMqttSession(client);
+
+    const quint32 ssrc = allocateSsrc();
+    const QString keyHex = randomHex(16);
+    // nonce: [type 0x01][flags][len 2][ssrc 4][timestamp 4][sequence 4]
+    const QString nonceHex = QString("01000000%1%2").arg(ssrc, 8, 16, QChar('0')).arg(QString(16, QChar('0')));
+
+    StandinSession* session = createSession();
+    if (!m_udp->addRoute(ssrc, keyHex, nonceHex, session)) {
+        retireSession(session);
+        return;
+    }
+    session->setJsonSender([this, client](const QJsonObject& message) {
+        m_mqtt->publish(client, QJsonDocument(message).toJson(QJsonDocument::Compact));
+    });
+    session->setAudioSender([this, ssrc](const QByteArray& opus) {
+        m_udp->sendAudio(ssrc, opus);
+    });
+    connect(session, &StandinSession::closed, this, [this, client, session]() {
+        // 会话在自身信号中不能直接销毁；期间若已重新hello则不影响新会话
+        QMetaObject::invokeMethod(this, [this, client, session]() {
+            if (m_mqttSessions.value(client).session == session) {
+                closeMqttSession(client);
+            }
+        }, Qt::QueuedConnection);
+    });
+    m_mqttSessions.insert(client, MqttBinding{ session, ssrc });
+
+    QJsonObject udp;
+    udp["server"] = m_options.advertisedHost;
+    udp["port"] = m_options.udpPort;
+    udp["key"] = keyHex;
+    udp["nonce"] = nonceHex;
+
+    QJsonObject hello;
+    hello["type"] = "hello";
+    hello["version"] = 3;
+    hello["transport"] = "udp";
+    hello["session_id"] = session->sessionId();
+    hello["audio_params"] = session->audioParams();
+    hello["udp"] = udp;
+    m_mqtt->publish(client, QJsonDocument(hello).toJson(QJsonDocument::Compact));
+}
+
+void StandinServer::closeMqttSession(QTcpSocket* client) {
+    auto it = m_mqttSessions.find(client);
+    if (it == m_mqttSessions.end()) {
+        return;
+    }
+    m_udp->removeRoute(it->ssrc);
+    retireSession(it->session);
+    m_mqttSessions.erase(it);
+}
+
+quint32 StandinServer::allocateSsrc() const {
+    for (;;) {
+        const quint32 ssrc = QRandomGenerator::global()->generate();
+        bool inUse = (ssrc == 0);
+        for (auto it = m_mqttSessions.constBegin(); !inUse && it != m_mqttSessions.constEnd(); ++it) {
+            inUse = (it->ssrc == ssrc);
+        }
+        if (!inUse) {
+            return ssrc;
+        }
+    }
+}
+
+// ========== WebSocket ==========
+
+void StandinServer::onWebSocketConnection() {
+    while (QWebSocket* socket = m_wsServer->nextPendingConnection()) {
+        // 二进制帧格式以客户端声明的Protocol-Version为准，缺省使用OTA下发的版本
+        bool ok = false;
+        int version = socket->request().rawHeader("Protocol-Version").toInt(&ok);
+        if (!ok || version < 1 || version > 3) {
+            version = m_options.wsVersion;
+        }
+        m_wsSessions.insert(socket, WsBinding{ nullptr, version });
+
+        connect(socket, &QWebSocket::textMessageReceived, this, [this, socket](const QString& message) {
+            onWsText(socket, message);
+        });
+        connect(socket, &QWebSocket::binaryMessageReceived, this, [this, socket](const QByteArray& message) {
+            onWsBinary(socket, message);
+        });
+        connect(socket, &QWebSocket::disconnected, this, [this, socket]() {
+            closeWsSession(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void StandinServer::onWsText(QWebSocket* socket, const QString& message) {
+    auto it = m_wsSessions.find(socket);
+    if (it == m_wsSessions.end()) {
+        return;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
+    if (!doc.isObject()) {
+        return;
+    }
+    const QJsonObject json = doc.object();
+
+    if (json["type"].toString() == "hello") {
+        if (it->session) {
+            retireSession(it->session);
+        }
+        StandinSession* session = createSession();
+        const int version = it->version;
+        session->setJsonSender([socket](const QJsonObject& reply) {
+            socket->sendTextMessage(QString::fromUtf8(QJsonDocument(reply).toJson(QJsonDocument::Compact)));
+        });
+        session->setAudioSender([socket, version, clock = QElapsedTimer()](const QByteArray& opus) mutable {
+            if (!clock.isValid()) {
+                clock.start();
+            }
+            socket->sendBinaryMessage(buildWsPacket(version, opus, static_cast<quint32>(clock.elapsed())));
+        });
+        connect(session, &StandinSession::closed, socket, [socket]() {
+            socket->close();
+        }, Qt::QueuedConnection);
+        it->session = session;
+
+        QJsonObject hello;
+        hello["type"] = "hello";
+        hello["version"] = version;
+        hello["transport"] = "websocket";
+        hello["session_id"] = session->sessionId();
+        hello["audio_params"] = session->audioParams();
+        socket->sendTextMessage(QString::fromUtf8(QJsonDocument(hello).toJson(QJsonDocument::Compact)));
+        return;
+    }
+
+    if (it->session) {
+        it->session->handleJson(json);
+    }
+}
+
+void StandinServer::onWsBinary(QWebSocket* socket, const QByteArray& message) {
+    auto it = m_wsSessions.find(socket);
+    if (it == m_wsSessions.end() || !it->session) {
+        return;
+    }
+    const QByteArray opus = parseWsPacket(it->version, message);
+    if (!opus.isEmpty()) {
+        it->session->handleUplinkAudio(opus);
+    }
+}
+
+void StandinServer::closeWsSession(QWebSocket* socket) {
+    auto it = m_wsSessions.find(socket);
+    if (it == m_wsSessions.end()) {
+        return;
+    }
+    if (it->session) {
+        retireSession(it->session);
+    }
+    m_wsSessions.erase(it);
+}
+
+// ========== 会话与统计 ==========
+
+StandinSession* StandinServer::createSession() {
+    return new StandinSession(QUuid::createUuid().toString(QUuid::WithoutBraces), m_options.session, this);
+}
+
+void StandinServer::retireSession(StandinSession* session) {
+    m_retiredUplink += session->uplinkFrames();
+    m_retiredDownlink += session->downlinkFrames();
+    m_retiredTurns += session->turns();
+    session->disconnect(this);
+    session->setJsonSender(nullptr);
+    session->setAudioSender(nullptr);
+    session->deleteLater();
+}
+
+void StandinServer::printStats() {
+    quint64 uplink = m_retiredUplink;
+    quint64 downlink = m_retiredDownlink;
+    quint64 turns = m_retiredTurns;
+    for (const MqttBinding& binding : std::as_const(m_mqttSessions)) {
+        uplink += binding.session->uplinkFrames();
+        downlink += binding.session->downlinkFrames();
+        turns += binding.session->turns();
+    }
+    for (const WsBinding& binding : std::as_const(m_wsSessions)) {
+        if (binding.session) {
+            uplink += binding.session->uplinkFrames();
+            downlink += binding.session->downlinkFrames();
+            turns += binding.session->turns();
+        }
+    }
+
+    const double interval = qMax(1, m_options.statsIntervalS);
+    QTextStream out(stdout);
+    out << QString("[standin] ota=%1 mqtt=%2 ws=%3 turns=%4 | up %5 fps, down %6 fps | udp rx=%7 tx=%8 dropped=%9\n")
+               .arg(m_otaRequests)
+               .arg(m_mqttSessions.size())
+               .arg(m_wsSessions.size())
+               .arg(turns)
+               .arg((uplink - m_lastUplink) / interval, 0, 'f', 1)
+               .arg((downlink - m_lastDownlink) / interval, 0, 'f', 1)
+               .arg(m_udp->rxPackets())
+               .arg(m_udp->txPackets())
+               .arg(m_udp->rxDropped());
+    out.flush();
+    m_lastUplink = uplink;
+    m_lastDownlink = downlink;
+}
+
+} // namespace standin
+} // namespace xiaozhi
@@ -0,0 +1,131 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: StandinServer.h
+Desc: 本地替身服务器（OTA HTTP、MQTT网关+加密UDP、WebSocket v1/v2/v3），供离线端到端测试与压测
+*/
+
+#ifndef STANDIN_SERVER_H
+#define STANDIN_SERVER_H
+
+#include "StandinSession.h"
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QString>
+#include <QTimer>
+
+class QTcpServer;
+class QTcpSocket;
+class QWebSocket;
+class QWebSocketServer;
+
+namespace xiaozhi {
+namespace standin {
+
+class MqttGateway;
+class UdpAudioRelay;
+
+/**
+ * @brief 替身服务器参数
+ */
+struct ServerOptions {
+    QHostAddress bindAddress = QHostAddress::LocalHost;
+    QString advertisedHost = QStringLiteral("127.0.0.1");  // 写入OTA/hello响应的地址
+    quint16 otaPort = 8002;
+    quint16 mqttPort = 1883;        // 1xxx端口客户端优先尝试明文TCP
+    quint16 udpPort = 8884;
+    quint16 wsPort = 8000;
+    int wsVersion = 1;              // OTA中下发的WebSocket协议版本（1/2/3）
+    bool enableMqtt = true;
+    bool enableWebSocket = true;
+    QString activationCode;         // 非空时OTA响应携带激活码
+    int statsIntervalS = 5;         // 统计输出间隔（秒，0关闭）
+    SessionOptions session;
+};
+
+/**
+ * @brief 本地替身服务器
+ *
+ * - OTA：任意路径的HTTP请求都返回指向本机MQTT/WebSocket的配置
+ * - MQTT：hello分配会话、AES key/nonce与UDP地址，之后JSON消息交给会话
+ * - UDP：按AudioEncryptor封包加解密，回声下发
+ * - WebSocket：按连接的Protocol-Version头解析/封装v1/v2/v3二进制帧
+ */
+class StandinServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StandinServer(const ServerOptions& options, QObject* parent = nullptr);
+    ~StandinServer();
+
+    /**
+     * @brief 启动所有端点
+     * @return 任一端点监听失败返回false
+     */
+    bool start();
+
+private slots:
+    void onOtaConnection();
+    void onWebSocketConnection();
+    void onMqttMessage(QTcpSocket* client, const QString& clientId, const QByteArray& payload);
+    void onMqttClientDisconnected(QTcpSocket* client);
+    void printStats();
+
+private:
+    struct MqttBinding {
+        StandinSession* session = nullptr;
+        quint32 ssrc = 0;
+    };
+
+    struct WsBinding {
+        StandinSession* session = nullptr;
+        int version = 1;
+    };
+
+    // OTA
+    void onOtaReadyRead(QTcpSocket* socket);
+    QJsonObject buildOtaResponse(const QString& deviceId) const;
+
+    // MQTT
+    void startMqttSession(QTcpSocket* client);
+    void closeMqttSession(QTcpSocket* client);
+    quint32 allocateSsrc() const;
+
+    // WebSocket
+    void onWsText(QWebSocket* socket, const QString& message);
+    void onWsBinary(QWebSocket* socket, const QByteArray& message);
+    void closeWsSession(QWebSocket* socket);
+
+    StandinSession* createSession();
+    void retireSession(StandinSession* session);
+
+    ServerOptions m_options;
+    QTcpServer* m_otaServer;
+    MqttGateway* m_mqtt;
+    UdpAudioRelay* m_udp;
+    QWebSocketServer* m_wsServer;
+    QTimer m_statsTimer;
+
+    QHash<QTcpSocket*, QByteArray> m_otaBuffers;
+    QHash<QTcpSocket*, MqttBinding> m_mqttSessions;
+    QHash<QWebSocket*, WsBinding> m_wsSessions;
+
+    // 统计
+    quint64 m_otaRequests;
+    quint64 m_retiredUplink;        // 已销毁会话的累计帧数
+    quint64 m_retiredDownlink;
+    quint64 m_retiredTurns;
+    quint64 m_lastUplink;
+    quint64 m_lastDownlink;
+};
+
+} // namespace standin
+} // namespace xiaozhi
+
+#endif // STANDIN_SERVER_H
@@ -0,0 +1,197 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: StandinSession.cpp
+Desc: 本地替身服务器的会话对话逻辑实现
+*/
+
+#include "StandinSession.h"
+
+namespace xiaozhi {
+namespace standin {
+
+namespace {
+
+// 开始播报时先突发的帧数（与真实服务器的预缓冲一致，避免客户端抖动缓冲起播过慢）
+constexpr int PREBUFFER_FRAMES = 3;
+
+} // namespace
+
+StandinSession::StandinSession(const QString& sessionId, const SessionOptions& options, QObject* parent)
+    : QObject(parent)
+    , m_sessionId(sessionId)
+    , m_options(options)
+    , m_listening(false)
+    , m_playIndex(0)
+    , m_uplinkFrames(0)
+    , m_downlinkFrames(0)
+    , m_turns(0)
+{
+    m_paceTimer.setTimerType(Qt::PreciseTimer);
+    m_paceTimer.setInterval(qMax(5, m_options.frameDurationMs / 3));
+    connect(&m_paceTimer, &QTimer::timeout, this, &StandinSession::onPaceTick);
+
+    m_autoTurnTimer.setSingleShot(true);
+    connect(&m_autoTurnTimer, &QTimer::timeout, this, [this]() {
+        if (m_listening) {
+            m_listening = false;
+            beginReply();
+        }
+    });
+
+    m_replyDelayTimer.setSingleShot(true);
+    connect(&m_replyDelayTimer, &QTimer::timeout, this, &StandinSession::startPlayback);
+}
+
+void StandinSession::handleJson(const QJsonObject& message) {
+    const QString type = message["type"].toString();
+
+    if (type == "listen") {
+        const QString state = message["state"].toString();
+        if (state == "start") {
+            startListening(message["mode"].toString());
+        } else if (state == "stop") {
+            if (m_listening) {
+                m_listening = false;
+                m_autoTurnTimer.stop();
+                beginReply();
+            }
+        } else if (state == "detect") {
+            // 唤醒词检测：直接当作一轮文本回复
+            beginReply();
+        }
+    } else if (type == "abort") {
+        cancelReply();
+    } else if (type == "goodbye") {
+        cancelReply();
+        emit closed();
+    }
+    // iot/mcp/pong等消息无需应答
+}
+
+void StandinSession::handleUplinkAudio(const QByteArray& opus) {
+    ++m_uplinkFrames;
+    if (m_listening && m_turnFrames.size() < m_options.maxTurnFrames) {
+        m_turnFrames.append(opus);
+    }
+}
+
+QJsonObject StandinSession::audioParams() const {
+    // 回声使用客户端上行的Opus帧，因此下行参数与客户端上行一致
+    QJsonObject params;
+    params["format"] = "opus";
+    params["sample_rate"] = 16000;
+    params["channels"] = 1;
+    params["frame_duration"] = m_options.frameDurationMs;
+    return params;
+}
+
+void StandinSession::startListening(const QString& mode) {
+    // 新一轮聆听会打断仍在进行的回复
+    cancelReply();
+    m_turnFrames.clear();
+    m_listening = true;
+    if (mode == "auto" || mode == "realtime") {
+        m_autoTurnTimer.start(m_options.autoTurnMs);
+    }
+}
+
+void StandinSession::beginReply() {
+    m_replyDelayTimer.start(qMax(0, m_options.responseDelayMs));
+}
+
+void StandinSession::startPlayback() {
+    ++m_turns;
+
+    QJsonObject stt;
+    stt["type"] = "stt";
+    stt["text"] = m_options.sttText;
+    stt["is_final"] = true;
+    send(stt);
+
+    QJsonObject llm;
+    llm["type"] = "llm";
+    llm["emotion"] = "neutral";
+    llm["text"] = "😐";
+    send(llm);
+
+    QJsonObject ttsStart;
+    ttsStart["type"] = "tts";
+    ttsStart["state"] = "start";
+    send(ttsStart);
+
+    QJsonObject sentence;
+    sentence["type"] = "tts";
+    sentence["state"] = "sentence_start";
+    sentence["text"] = m_options.sttText;
+    send(sentence);
+
+    m_playIndex = 0;
+    m_playClock.start();
+    onPaceTick();
+    if (m_playIndex < m_turnFrames.size()) {
+        m_paceTimer.start();
+    }
+}
+
+void StandinSession::onPaceTick() {
+    // 按墙钟计算应已发出的帧数，定时器抖动时一次补齐
+    const qint64 due = PREBUFFER_FRAMES + m_playClock.elapsed() / qMax(1, m_options.frameDurationMs);
+    while (m_playIndex < m_turnFrames.size() && m_playIndex < due) {
+        if (m_sendAudio) {
+            m_sendAudio(m_turnFrames[m_playIndex]);
+        }
+        ++m_playIndex;
+        ++m_downlinkFrames;
+    }
+    if (m_playIndex >= m_turnFrames.size()) {
+        finishReply();
+    }
+}
+
+void StandinSession::finishReply() {
+    m_paceTimer.stop();
+    m_turnFrames.clear();
+    m_playIndex = 0;
+
+    QJsonObject ttsStop;
+    ttsStop["type"] = "tts";
+    ttsStop["state"] = "stop";
+    send(ttsStop);
+
+    QJsonObject audioEnd;
+    audioEnd["type"] = "system";
+    audioEnd["action"] = "audio_end";
+    send(audioEnd);
+}
+
+void StandinSession::cancelReply() {
+    m_autoTurnTimer.stop();
+    m_replyDelayTimer.stop();
+    if (m_paceTimer.isActive()) {
+        // 播报中被打断：与真实服务器一致，仍以tts stop收尾
+        m_paceTimer.stop();
+        QJsonObject ttsStop;
+        ttsStop["type"] = "tts";
+        ttsStop["state"] = "stop";
+        send(ttsStop);
+    }
+    m_listening = false;
+    m_turnFrames.clear();
+    m_playIndex = 0;
+}
+
+void StandinSession::send(const QJsonObject& message) {
+    if (!m_sendJson) {
+        return;
+    }
+    QJsonObject withSession = message;
+    withSession["session_id"] = m_sessionId;
+    m_sendJson(withSession);
+}
+
+} // namespace standin
+} // namespace xiaozhi
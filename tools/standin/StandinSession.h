@@ -0,0 +1,115 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: StandinSession.h
+Desc: 本地替身服务器的会话对话逻辑（与传输无关：收集上行音频，按轮次回放STT/TTS/下行音频）
+*/
+
+#ifndef STANDIN_SESSION_H
+#define STANDIN_SESSION_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+
+namespace xiaozhi {
+namespace standin {
+
+/**
+ * @brief 会话行为参数
+ */
+struct SessionOptions {
+    int frameDurationMs = 60;       // 下行帧时长（与hello中的audio_params一致）
+    int responseDelayMs = 300;      // 模拟识别/合成的处理延迟（毫秒）
+    int autoTurnMs = 3000;          // auto/realtime模式下一轮聆听时长（毫秒）
+    int maxTurnFrames = 500;        // 单轮最多缓存的上行帧数
+    QString sttText = QStringLiteral("本地替身服务器回声测试");
+};
+
+/**
+ * @brief 替身服务器会话
+ *
+ * 一轮对话：listen start收集上行Opus帧 → listen stop（或auto模式超时）→
+ * 延迟responseDelayMs后依次下发stt、llm、tts start/sentence_start，
+ * 按帧时长节奏回放本轮上行帧（回声），最后下发tts stop与system audio_end。
+ * JSON与音频通过注入的发送函数交给具体传输（MQTT+UDP或WebSocket）。
+ */
+class StandinSession : public QObject {
+    Q_OBJECT
+
+public:
+    using JsonSender = std::function<void(const QJsonObject& message)>;
+    using AudioSender = std::function<void(const QByteArray& opus)>;
+
+    StandinSession(const QString& sessionId, const SessionOptions& options, QObject* parent = nullptr);
+
+    QString sessionId() const { return m_sessionId; }
+    void setJsonSender(JsonSender sender) { m_sendJson = std::move(sender); }
+    void setAudioSender(AudioSender sender) { m_sendAudio = std::move(sender); }
+
+    /**
+     * @brief 处理客户端JSON消息（hello由传输层处理，不会到这里）
+     */
+    void handleJson(const QJsonObject& message);
+
+    /**
+     * @brief 处理客户端上行Opus帧
+     */
+    void handleUplinkAudio(const QByteArray& opus);
+
+    /**
+     * @brief 服务器音频参数（hello响应中的audio_params）
+     */
+    QJsonObject audioParams() const;
+
+    quint64 uplinkFrames() const { return m_uplinkFrames; }
+    quint64 downlinkFrames() const { return m_downlinkFrames; }
+    quint64 turns() const { return m_turns; }
+
+signals:
+    /**
+     * @brief 客户端告别，会话可销毁
+     */
+    void closed();
+
+private slots:
+    void onPaceTick();
+
+private:
+    void startListening(const QString& mode);
+    void beginReply();
+    void startPlayback();
+    void finishReply();
+    void cancelReply();
+    void send(const QJsonObject& message);
+
+    QString m_sessionId;
+    SessionOptions m_options;
+    JsonSender m_sendJson;
+    AudioSender m_sendAudio;
+
+    bool m_listening;
+    QVector<QByteArray> m_turnFrames;   // 本轮上行帧（回声源）
+    int m_playIndex;                    // 回放位置
+    QElapsedTimer m_playClock;
+    QTimer m_paceTimer;                 // 下行节拍
+    QTimer m_autoTurnTimer;             // auto模式聆听时长
+    QTimer m_replyDelayTimer;           // 处理延迟
+
+    quint64 m_uplinkFrames;
+    quint64 m_downlinkFrames;
+    quint64 m_turns;
+};
+
+} // namespace standin
+} // namespace xiaozhi
+
+#endif // STANDIN_SESSION_H
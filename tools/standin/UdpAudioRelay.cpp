@@ -0,0 +1,125 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: UdpAudioRelay.cpp
+Desc: 本地替身服务器的UDP音频通道实现
+*/
+
+#include "UdpAudioRelay.h"
+#include "StandinSession.h"
+#include "../../src/utils/Logger.h"
+#include <QUdpSocket>
+#include <QtEndian>
+
+namespace xiaozhi {
+namespace standin {
+
+namespace {
+
+constexpr int MAX_DATAGRAM = 2048;
+
+} // namespace
+
+UdpAudioRelay::UdpAudioRelay(QObject* parent)
+    : QObject(parent)
+    , m_socket(new QUdpSocket(this))
+    , m_rxBuffer(MAX_DATAGRAM, Qt::Uninitialized)
+    , m_txBuffer(MAX_DATAGRAM, Qt::Uninitialized)
+    , m_rxPackets(0)
+    , m_txPackets(0)
+    , m_rxDropped(0)
+{
+    m_clock.start();
+    connect(m_socket, &QUdpSocket::readyRead, this, &UdpAudioRelay::onReadyRead);
+}
+
+UdpAudioRelay::~UdpAudioRelay() {
+}
+
+bool UdpAudioRelay::bind(const QHostAddress& address, quint16 port) {
+    if (!m_socket->bind(address, port)) {
+        utils::Logger::instance().error(QString("[standin] UDP绑定失败: %1").arg(m_socket->errorString()));
+        return false;
+    }
+    // 数百路并发时默认接收缓冲容易溢出
+    m_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+    return true;
+}
+
+quint16 UdpAudioRelay::localPort() const {
+    return m_socket->localPort();
+}
+
+bool UdpAudioRelay::addRoute(quint32 ssrc, const QString& keyHex, const QString& nonceHex, StandinSession* session) {
+    Route route;
+    route.session = session;
+    route.crypto = std::make_unique<audio::AudioEncryptor>();
+    if (!route.crypto->initialize(keyHex, nonceHex)) {
+        return false;
+    }
+    m_routes[ssrc] = std::move(route);
+    return true;
+}
+
+void UdpAudioRelay::removeRoute(quint32 ssrc) {
+    m_routes.erase(ssrc);
+}
+
+bool UdpAudioRelay::sendAudio(quint32 ssrc, const QByteArray& opus) {
+    auto it = m_routes.find(ssrc);
+    if (it == m_routes.end() || it->second.peerPort == 0) {
+        return false;
+    }
+    const int size = it->second.crypto->encryptInto(opus.constData(), opus.size(),
+                                             static_cast<uint32_t>(m_clock.elapsed()),
+                                             m_txBuffer.data(), m_txBuffer.size());
+    if (size <= 0) {
+        return false;
+    }
+    if (m_socket->writeDatagram(m_txBuffer.constData(), size, it->second.peer, it->second.peerPort) != size) {
+        return false;
+    }
+    ++m_txPackets;
+    return true;
+}
+
+void UdpAudioRelay::onReadyRead() {
+    while (m_socket->hasPendingDatagrams()) {
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        const qint64 size = m_socket->readDatagram(m_rxBuffer.data(), m_rxBuffer.size(), &sender, &senderPort);
+        if (size < static_cast<qint64>(sizeof(audio::AudioPacketHeader))) {
+            ++m_rxDropped;
+            continue;
+        }
+
+        const quint32 ssrc = qFromBigEndian<quint32>(m_rxBuffer.constData() + 4);
+        auto it = m_routes.find(ssrc);
+        if (it == m_routes.end()) {
+            ++m_rxDropped;
+            continue;
+        }
+
+        uint32_t timestamp = 0;
+        uint32_t sequence = 0;
+        const int payloadSize = it->second.crypto->decryptInPlace(m_rxBuffer.data(), static_cast<int>(size),
+                                                           timestamp, sequence);
+        if (payloadSize <= 0) {
+            ++m_rxDropped;   // 解密失败或被防重放窗口过滤
+            continue;
+        }
+
+        // 客户端NAT映射可能变化，始终回发到最近的源地址
+        it->second.peer = sender;
+        it->second.peerPort = senderPort;
+        ++m_rxPackets;
+        it->second.session->handleUplinkAudio(
+            QByteArray(m_rxBuffer.constData() + sizeof(audio::AudioPacketHeader), payloadSize));
+    }
+}
+
+} // namespace standin
+} // namespace xiaozhi
@@ -0,0 +1,89 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: UdpAudioRelay.h
+Desc: 本地替身服务器的UDP音频通道（与客户端相同的AES-CTR封包，按SSRC路由会话）
+*/
+
+#ifndef STANDIN_UDP_AUDIO_RELAY_H
+#define STANDIN_UDP_AUDIO_RELAY_H
+
+#include "../../src/audio/AudioEncryptor.h"
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <memory>
+#include <unordered_map>
+
+class QUdpSocket;
+
+namespace xiaozhi {
+namespace standin {
+
+class StandinSession;
+
+/**
+ * @brief UDP音频中继
+ *
+ * 每个MQTT会话在hello时分配独立的key/nonce，nonce中的SSRC（字节4-7）即路由键。
+ * 加解密直接复用客户端的AudioEncryptor，保证与客户端封包格式逐字节一致；
+ * 下行目的地址取该会话最近一次上行包的源地址。
+ */
+class UdpAudioRelay : public QObject {
+    Q_OBJECT
+
+public:
+    explicit UdpAudioRelay(QObject* parent = nullptr);
+    ~UdpAudioRelay();
+
+    bool bind(const QHostAddress& address, quint16 port);
+    quint16 localPort() const;
+
+    /**
+     * @brief 注册会话路由
+     * @param ssrc 会话SSRC（nonce字节4-7，大端）
+     * @param keyHex AES密钥（十六进制）
+     * @param nonceHex nonce（十六进制）
+     * @param session 上行音频交付的会话
+     */
+    bool addRoute(quint32 ssrc, const QString& keyHex, const QString& nonceHex, StandinSession* session);
+    void removeRoute(quint32 ssrc);
+
+    /**
+     * @brief 向会话下发一帧Opus（尚未收到上行包时无目的地址，丢弃）
+     */
+    bool sendAudio(quint32 ssrc, const QByteArray& opus);
+
+    quint64 rxPackets() const { return m_rxPackets; }
+    quint64 txPackets() const { return m_txPackets; }
+    quint64 rxDropped() const { return m_rxDropped; }
+
+private slots:
+    void onReadyRead();
+
+private:
+    struct Route {
+        StandinSession* session = nullptr;
+        std::unique_ptr<audio::AudioEncryptor> crypto;
+        QHostAddress peer;
+        quint16 peerPort = 0;
+    };
+
+    QUdpSocket* m_socket;
+    std::unordered_map<quint32, Route> m_routes;
+    QByteArray m_rxBuffer;      // 复用的接收缓冲
+    QByteArray m_txBuffer;      // 复用的发送缓冲
+    QElapsedTimer m_clock;      // 下行时间戳基准
+    quint64 m_rxPackets;
+    quint64 m_txPackets;
+    quint64 m_rxDropped;
+};
+
+} // namespace standin
+} // namespace xiaozhi
+
+#endif // STANDIN_UDP_AUDIO_RELAY_H
@@ -0,0 +1,85 @@
+/*
+Project: 小智跨平台客户端 (jtxiaozhi-client)
+Version: v0.1.0
+Author: jtserver团队
+Email: jwhna1@gmail.com
+Updated: 2026-10-16T15:10:00Z
+File: main.cpp
+Desc: 本地替身服务器入口（xiaozhi-standin）
+*/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "StandinServer.h"
+#include "../../src/version/version_info.h"
+#include "../../src/utils/Logger.h"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(xiaozhi::version::AUTHOR);
+    app.setApplicationName("xiaozhi-standin");
+    app.setApplicationVersion(xiaozhi::version::VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("小智本地替身服务器：OTA、MQTT网关+加密UDP、WebSocket(v1/v2/v3)，回声应答");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption bindOpt("bind", "监听地址（默认127.0.0.1）", "addr", "127.0.0.1");
+    QCommandLineOption hostOpt("host", "下发给客户端的服务器地址（默认同监听地址）", "host");
+    QCommandLineOption otaPortOpt("ota-port", "OTA HTTP端口（默认8002，0为自动分配）", "port", "8002");
+    QCommandLineOption mqttPortOpt("mqtt-port", "MQTT端口（默认1883）", "port", "1883");
+    QCommandLineOption udpPortOpt("udp-port", "UDP音频端口（默认8884）", "port", "8884");
+    QCommandLineOption wsPortOpt("ws-port", "WebSocket端口（默认8000）", "port", "8000");
+    QCommandLineOption wsVersionOpt("ws-version", "OTA下发的WebSocket协议版本1/2/3（默认1）", "n", "1");
+    QCommandLineOption noMqttOpt("no-mqtt", "不提供MQTT+UDP");
+    QCommandLineOption noWsOpt("no-websocket", "不提供WebSocket");
+    QCommandLineOption activationOpt("activation-code", "OTA响应携带的激活码", "code");
+    QCommandLineOption delayOpt("response-delay-ms", "模拟处理延迟毫秒（默认300）", "ms", "300");
+    QCommandLineOption autoTurnOpt("auto-turn-ms", "auto模式每轮聆听毫秒（默认3000）", "ms", "3000");
+    QCommandLineOption frameOpt("frame-ms", "下行帧时长毫秒（默认60，需与客户端上行一致）", "ms", "60");
+    QCommandLineOption sttOpt("stt-text", "下发的识别文本", "text");
+    QCommandLineOption statsOpt("stats-interval-s", "统计输出间隔秒（默认5，0关闭）", "s", "5");
+    QCommandLineOption verboseOpt("verbose", "输出日志到控制台");
+    parser.addOptions({ bindOpt, hostOpt, otaPortOpt, mqttPortOpt, udpPortOpt, wsPortOpt, wsVersionOpt,
+                        noMqttOpt, noWsOpt, activationOpt, delayOpt, autoTurnOpt, frameOpt, sttOpt,
+                        statsOpt, verboseOpt });
+    parser.process(app);
+
+    xiaozhi::utils::Logger::instance().setConsoleOutput(parser.isSet(verboseOpt));
+
+    xiaozhi::standin::ServerOptions options;
+    options.bindAddress = QHostAddress(parser.value(bindOpt));
+    options.advertisedHost = parser.isSet(hostOpt) ? parser.value(hostOpt) : parser.value(bindOpt);
+    options.otaPort = static_cast<quint16>(parser.value(otaPortOpt).toUInt());
+    options.mqttPort = static_cast<quint16>(parser.value(mqttPortOpt).toUInt());
+    options.udpPort = static_cast<quint16>(parser.value(udpPortOpt).toUInt());
+    options.wsPort = static_cast<quint16>(parser.value(wsPortOpt).toUInt());
+    options.wsVersion = qBound(1, parser.value(wsVersionOpt).toInt(), 3);
+    options.enableMqtt = !parser.isSet(noMqttOpt);
+    options.enableWebSocket = !parser.isSet(noWsOpt);
+    options.activationCode = parser.value(activationOpt);
+    options.statsIntervalS = parser.value(statsOpt).toInt();
+    options.session.responseDelayMs = parser.value(delayOpt).toInt();
+    options.session.autoTurnMs = parser.value(autoTurnOpt).toInt();
+    options.session.frameDurationMs = qMax(10, parser.value(frameOpt).toInt());
+    if (parser.isSet(sttOpt)) {
+        options.session.sttText = parser.value(sttOpt);
+    }
+
+    if (options.bindAddress.isNull()) {
+        QTextStream(stderr) << "无效的监听地址: " << parser.value(bindOpt) << "\n";
+        return 1;
+    }
+    if (!options.enableMqtt && !options.enableWebSocket) {
+        QTextStream(stderr) << "--no-mqtt 与 --no-websocket 不能同时使用\n";
+        return 1;
+    }
+
+    xiaozhi::standin::StandinServer server(options);
+    if (!server.start()) {
+        return 1;
+    }
+    return app.exec();
+}